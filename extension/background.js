@@ -2,6 +2,7 @@
 const HOST_NAME = 'com.paperclip.host.chrome';
 let port = null;
 let pingTimer = null;
+let hostStatus = 'unknown'; // 호스트의 status 프레임: loading | ready | failed | unavailable
 
 function log(...args) {
   const ts = new Date().toISOString().split('T')[1].replace('Z', '');
@@ -22,76 +23,79 @@ function connectNative() {
   }
 
   port.onMessage.addListener(onHostMessage);
+  flush();
 
   port.onDisconnect.addListener(() => {
     log('host disconnected');
     try { clearInterval(pingTimer); } catch (_) { }
     pingTimer = null;
     port = null;
-    // 끊기면 큐는 남아있을 수 있으니 재연결 시도
+    // 진행 중이던 요청은 호스트와 함께 사라짐
+    failAllPending('AI 호스트 연결이 끊어졌습니다. 잠시 후 다시 시도해 주세요.');
+    // 재연결 시도
     setTimeout(connectNative, 1000);
   });
 
   // keep-alive / 상태 확인
   pingTimer = setInterval(() => {
-    try { port.postMessage({ type: 'ping' }); log('ping -> host'); } catch (_) { }
+    try { port.postMessage({ type: 'ping' }); log('ping -> host', hostStatus); } catch (_) { }
   }, 20000);
 }
 
-/* ---------- 요청 큐 (동시에 1개) ---------- */
-const queue = [];
-let busy = false;
-let currentTarget = null; // {tabId, frameId}
+/* ---------- 요청 라우팅 ---------- */
+// 스케줄링/선점은 호스트가 담당: 요청은 즉시 전달하고 응답은 id로 라우팅
+const DEADLINE_MS = 8000;   // 호스트(DLL)가 강제하는 요청별 마감
+const DOCUMENT_DEADLINE_MS = 60000; // 문서 전체 검사 (문장 수십 개를 한 번에)
+const pending = new Map();  // id -> {tabId, frameId, partial}
+const outbox = [];          // 호스트 연결 전 대기
+let nextId = 1;
 
 function enqueue(payload, tabId, frameId) {
-  queue.push({ payload, tabId, frameId });
-  pump();
+  const id = nextId++;
+  pending.set(id, { tabId, frameId, partial: null });
+  outbox.push({ deadline_ms: DEADLINE_MS, ...payload, id, session: `${tabId}:${frameId}` });
+  flush();
 }
 
-function pump() {
-  if (busy || queue.length === 0) return;
+function flush() {
+  if (outbox.length === 0) return;
   if (!port) connectNative();
   if (!port) { log('host not connected; wait'); return; }
 
-  busy = true;
-  const { payload, tabId, frameId } = queue.shift();
-  currentTarget = { tabId, frameId };
-
-  // 타임아웃 가드(8초)
-  currentTarget._to = setTimeout(() => {
-    log('host timeout -> fallback');
-    deliverToCurrent({
-      type: 'error',
-      error: 'AI 응답이 지연됩니다. 잠시 후 다시 시도해 주세요.'
-    });
-    finishRequest();
-  }, 800000);
-
-  try {
-    port.postMessage(payload);
-    log('posted to host:', payload.type);
-  } catch (e) {
-    clearTimeout(currentTarget._to);
-    deliverToCurrent({ type: 'error', error: String(e) });
-    finishRequest();
+  while (outbox.length) {
+    const payload = outbox.shift();
+    try {
+      port.postMessage(payload);
+      log('posted to host:', payload.type, payload.id);
+    } catch (e) {
+      deliver(payload.id, { type: 'error', error: String(e) });
+      pending.delete(payload.id);
+    }
   }
 }
 
-function finishRequest() {
-  busy = false;
-  currentTarget = null;
-  pump();
-}
-
-function deliverToCurrent(msg) {
-  if (!currentTarget) return;
-  const { tabId, frameId } = currentTarget;
+function deliver(id, msg) {
+  const target = pending.get(id);
+  if (!target) return;
+  const { tabId, frameId } = target;
   if (tabId != null) {
     chrome.tabs.sendMessage(tabId, msg, { frameId }, () => void chrome.runtime.lastError);
   }
 }
 
+function failAllPending(error) {
+  for (const id of pending.keys()) deliver(id, { type: 'error', error });
+  pending.clear();
+}
+
 /* ---------- 호스트 응답 ---------- */
+function toneOf(flag) {
+  return String(flag || '').toLowerCase() === 'impolite' ? 'impolite' : 'polite';
+}
+function toneTextOf(tone) {
+  return tone === 'impolite' ? '수정을 권장해요' : '좋은 톤이에요';
+}
+
 function onHostMessage(msg) {
   // DIAG는 콘솔만
   if (msg && msg.type === 'diag') {
@@ -101,34 +105,91 @@ function onHostMessage(msg) {
 
   log('onMessage from host:', msg);
 
-  if (msg && Array.isArray(msg.suggestions) && msg.suggestions.length > 0) {
+  if (msg && msg.type === 'pong') {
+    log('pong <- host');
+    return;
+  }
+
+  // 모델 로딩 상태 (loading → ready/failed). 로딩 중 요청은 호스트가 큐에 보관
+  if (msg && msg.type === 'status') {
+    hostStatus = msg.state;
+    log('host status:', msg.state, msg.load_ms ?? msg.elapsed_ms ?? '', msg.error || '');
+    return;
+  }
+
+  const req = msg ? pending.get(msg.id) : undefined;
+  if (!req) return; // 이미 종료/선점된 요청
+
+  // 문서 검사: 문장마다 판정과 본문 오프셋(UTF-16), 끝나면 요약 한 번
+  if (msg.type === 'sentence') {
+    const [flag, ...rest] = msg.suggestions || [];
+    deliver(msg.id, {
+      type: 'document_sentence',
+      index: msg.index,
+      start: msg.start,
+      end: msg.end,
+      tone: msg.error ? 'polite' : toneOf(flag),
+      suggestions: rest,
+      tier: msg.tier || ''
+    });
+    return;
+  }
+  if (msg.type === 'document') {
+    deliver(msg.id, { type: 'document_result', sentences: msg.sentences, flagged: msg.flagged, truncated: !!msg.truncated });
+    pending.delete(msg.id);
+    return;
+  }
+
+  // 스트리밍: 배열 원소가 닫힐 때마다 도착 (0 = tone flag, 1.. = 대안)
+  if (msg.type === 'partial') {
+    if (msg.index === 0) {
+      req.partial = { tone: toneOf(msg.text), suggestions: [] };
+    } else if (req.partial) {
+      req.partial.suggestions.push(msg.text);
+    } else {
+      return;
+    }
+    const partial = req.partial;
+    deliver(msg.id, {
+      type: 'analysis_partial',
+      tone: partial.tone,
+      toneText: toneTextOf(partial.tone),
+      suggestions: partial.suggestions.slice()
+    });
+    return;
+  }
+
+  // 같은 탭/프레임의 새 문장에 밀려난 요청은 조용히 폐기, 마감 초과는 안내
+  if (msg.type === 'aborted') {
+    if (msg.reason === 'deadline') {
+      deliver(msg.id, { type: 'error', error: 'AI 응답이 지연됩니다. 잠시 후 다시 시도해 주세요.' });
+    }
+    pending.delete(msg.id);
+    return;
+  }
+
+  if (Array.isArray(msg.suggestions) && msg.suggestions.length > 0) {
     // 첫 요소 = tone flag, 나머지 = suggestions
     const [flag, ...rest] = msg.suggestions;
 
-    const tone = flag.toLowerCase() === "impolite" ? "impolite" : "polite";
-    const toneText = tone === "impolite" ? "수정을 권장해요" : "좋은 톤이에요";
+    const tone = toneOf(flag);
+    const toneText = toneTextOf(tone);
 
-    if (currentTarget?._to) clearTimeout(currentTarget._to);
-    deliverToCurrent({
+    // tier: 답한 단계 (fastpath | cache | verdict = 판정만 | rewrite = 7B 대안 생성)
+    deliver(msg.id, {
       type: "analysis_result",
       tone,
       toneText,
-      suggestions: rest
+      suggestions: rest,
+      tier: msg.tier || ''
     });
-    finishRequest();
+    pending.delete(msg.id);
     return;
   }
 
-
-  if (msg && msg.type === 'pong') {
-    log('pong <- host');
-    return;
-  }
-
-  if (msg && msg.error) {
-    if (currentTarget?._to) clearTimeout(currentTarget._to);
-    deliverToCurrent({ type: 'error', error: msg.error });
-    finishRequest();
+  if (msg.error) {
+    deliver(msg.id, { type: 'error', error: msg.error });
+    pending.delete(msg.id);
     return;
   }
 }
@@ -166,7 +227,11 @@ chrome.runtime.onMessage.addListener((req, sender, sendResponse) => {
     const focus = req.focus || req.body || '';
     const context = req.context || '';
     const body = req.body || '';
-    const payload = { type: 'analyze', focus, context, body, ts: Date.now() };
+    // alternatives: 사용자가 직접 대안을 요청 → 네이티브가 '정중함' 판정에서 멈추지 않음
+    // priority: 단축키(직접 요청) > 입력 중 문장 > 문서 전체 검사 — 호스트가 이 순서로 처리
+    const alternatives = !!req.alternatives;
+    const priority = alternatives ? 'interactive' : 'live';
+    const payload = { type: 'analyze', focus, context, body, stream: true, alternatives, priority, ts: Date.now() };
 
     const tabId = sender?.tab?.id ?? null;
     const frameId = sender?.frameId ?? 0;
@@ -176,6 +241,24 @@ chrome.runtime.onMessage.addListener((req, sender, sendResponse) => {
     return true; // async OK (응답 이미 반환했지만 MV3에선 true 허용)
   }
 
+  // 입력 중인 문장의 prefill 힌트: 응답도 재시도도 없음 (연결이 없으면 버림)
+  if (req?.type === 'prefillHint') {
+    if (port) {
+      const session = `${sender?.tab?.id ?? null}:${sender?.frameId ?? 0}`;
+      try { port.postMessage({ type: 'prefill', session, focus: req.focus || '', context: req.context || '' }); } catch (_) { }
+    }
+    sendResponse({ ok: true });
+    return;
+  }
+
+  // 보내기 전 전체 검사: 문장 분리는 호스트가 네이티브로 (오프셋은 보낸 body 기준)
+  if (req?.type === 'analyzeDocument') {
+    const payload = { type: 'analyze_document', body: req.body || '', deadline_ms: DOCUMENT_DEADLINE_MS, priority: 'background', ts: Date.now() };
+    enqueue(payload, sender?.tab?.id ?? null, sender?.frameId ?? 0);
+    sendResponse({ ok: true, status: 'queued' });
+    return true;
+  }
+
   sendResponse({ ok: false, error: 'unknown message' });
 });
 
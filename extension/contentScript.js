@@ -10,12 +10,16 @@
 const PUNCT_KEYS = ['.', '!', '?'];
 const PUNCT_REGEX = /[.!?؟¡。？！]/;
 const lastSentMap = new WeakMap();
+const HINT_PAUSE_MS = 300;      // 입력이 이만큼 멈추면 쓰는 중인 문장을 미리 prefill
+const HINT_MIN_CHARS = 8;
+const lastHintMap = new WeakMap();
 const rollbackStack = new WeakMap();
 let lastTarget = null;
 let politeIndicator = null;
 let rollbackIndicator = null;
 let suggestBuf = [];
 let isAnalyzing = false;
+let docCheck = null; // 문서 전체 검사: { bodyDiv, body, flagged: [{start, end, text, suggestions}] }
 
 /* ========== Styles ========== */
 const GMAIL_INTEGRATED_STYLES = `
@@ -309,8 +313,13 @@ function enableSentenceAnalysis(bodyDiv) {
   bodyDiv._politeAnalysisBound = true;
 
   let analysisTimeout = null;
+  let hintTimeout = null;
   bodyDiv.addEventListener('keyup', (ev) => {
-    if (!PUNCT_KEYS.includes(ev.key)) return;
+    clearTimeout(hintTimeout);
+    if (!PUNCT_KEYS.includes(ev.key)) {
+      hintTimeout = setTimeout(() => sendPrefillHint(bodyDiv), HINT_PAUSE_MS);
+      return;
+    }
     const fullText = bodyDiv.innerText.trim();
     if (!fullText || !PUNCT_REGEX.test(fullText.slice(-1))) return;
     const sentences = fullText.split(/(?<=[.!?؟¡。？！])\s+/);
@@ -331,6 +340,19 @@ function enableSentenceAnalysis(bodyDiv) {
   });
 }
 
+// 입력이 잠깐 멈추면 아직 마침표가 없는 문장을 힌트로 보냄. 호스트가 한가할 때만 모델에 미리 올려 두어,
+// 문장이 끝나 분석 요청이 오면 뒷부분만 prefill하고 바로 디코딩합니다 (응답 없음, context는 분석 요청과 같게).
+function sendPrefillHint(bodyDiv) {
+  const fullText = bodyDiv.innerText.trim();
+  if (!fullText || PUNCT_REGEX.test(fullText.slice(-1))) return;
+  const sentences = fullText.split(/(?<=[.!?؟¡。？！])\s+/);
+  const partial = sentences.pop().trim();
+  if (partial.length < HINT_MIN_CHARS || lastHintMap.get(bodyDiv) === partial) return;
+  lastHintMap.set(bodyDiv, partial);
+  chrome.runtime.sendMessage({ type: 'prefillHint', focus: partial, context: sentences.join(' ').trim() },
+    () => void chrome.runtime.lastError);
+}
+
 function saveCursorPosition(bodyDiv) {
   const sel = window.getSelection();
   if (sel && sel.rangeCount > 0) {
@@ -342,16 +364,18 @@ function saveCursorPosition(bodyDiv) {
 }
 
 /* ===== AI call via background ===== */
-function analyzeEmailTone(bodyDiv, focus = '', context = '') {
+// alternatives: 사용자가 직접 요청한 검사 — 정중하다고 판정돼도 대안 문장을 받음
+function analyzeEmailTone(bodyDiv, focus = '', context = '', alternatives = false) {
   if (!bodyDiv) bodyDiv = ensureComposeTarget();
   if (!bodyDiv) { showError('작성창을 찾을 수 없어요. 작성창을 클릭한 후 다시 시도해주세요.'); return; }
-  if (isAnalyzing) return;
+  // 분석 중이어도 새 문장은 바로 전송 — 호스트가 이전 요청을 선점/취소합니다
 
   const emailData = {
     type: 'emailContent',
     focus: focus || bodyDiv.innerText.trim(),
     context,
     body: bodyDiv.innerText.trim(),
+    alternatives,
     timestamp: Date.now()
   };
 
@@ -378,6 +402,25 @@ function analyzeEmailTone(bodyDiv, focus = '', context = '') {
   });
 }
 
+// 본문 전체를 한 번에 검사 (Alt+D). 호스트가 문장을 나눠 문장별 판정을 오프셋과 함께 돌려줌
+function analyzeDocument(bodyDiv) {
+  if (!bodyDiv) bodyDiv = ensureComposeTarget();
+  if (!bodyDiv) { showError('작성창을 찾을 수 없어요. 작성창을 클릭한 후 다시 시도해주세요.'); return; }
+  const body = bodyDiv.innerText;
+  if (!body.trim()) return;
+  docCheck = { bodyDiv, body, flagged: [] };
+  showAnalyzingIndicator();
+  isAnalyzing = true;
+  chrome.runtime.sendMessage({ type: 'analyzeDocument', body }, (response) => {
+    if (chrome.runtime.lastError || response?.status === 'error') {
+      showError('확장 프로그램 통신 오류가 발생했습니다.');
+      hideAnalyzingIndicator();
+      isAnalyzing = false;
+      docCheck = null;
+    }
+  });
+}
+
 /* ===== Results & commands from background ===== */
 chrome.runtime.onMessage.addListener((message, sender, sendResponse) => {
   console.log('📨 Received from background:', message);
@@ -391,6 +434,49 @@ chrome.runtime.onMessage.addListener((message, sender, sendResponse) => {
     return true;
   }
 
+  // 스트리밍 중간 결과: 톤 판정을 먼저 보여주고 대안이 도착하는 대로 갱신
+  if (message.type === 'analysis_partial') {
+    hideAnalyzingIndicator();
+    suggestBuf = message.suggestions || [];
+    if (!document.getElementById('polite-popup')) {
+      showToneIndicator(message.tone, message.toneText, suggestBuf);
+    }
+    sendResponse?.({ status: 'partial_displayed' });
+    return true;
+  }
+
+  if (message.type === 'document_sentence') {
+    // 더 급한 요청에 양보했다 재개된 문서는 앞 문장들을 다시 보냄 (index로 중복 제거)
+    if (docCheck && message.tone === 'impolite' && !docCheck.flagged.some(f => f.index === message.index)) {
+      docCheck.flagged.push({
+        index: message.index,
+        start: message.start, end: message.end,
+        text: docCheck.body.slice(message.start, message.end),
+        suggestions: message.suggestions || []
+      });
+    }
+    sendResponse?.({ status: 'collected' });
+    return true;
+  }
+
+  if (message.type === 'document_result') {
+    hideAnalyzingIndicator();
+    isAnalyzing = false;
+    if (docCheck) {
+      docCheck.flagged.sort((a, b) => a.start - b.start);
+      const n = docCheck.flagged.length;
+      showToneIndicator(n ? 'impolite' : 'polite', n ? '수정을 권장해요' : '좋은 톤이에요',
+        docCheck.flagged.map(f => f.suggestions[0]).filter(Boolean));
+      if (politeIndicator && n) {
+        politeIndicator.querySelector('.indicator-subtitle').textContent = `${message.sentences}문장 중 ${n}문장`;
+        politeIndicator.onclick = () => showDocumentPopup();
+        politeIndicator.style.cursor = 'pointer';
+      }
+    }
+    sendResponse?.({ status: 'displayed' });
+    return true;
+  }
+
   if (message.type === 'error') {
     hideAnalyzingIndicator();
     showError(message.error);
@@ -518,6 +604,78 @@ function showSuggestionsPopup() {
   setupPopupKeyboard(popup);
 }
 
+// 문서 검사에서 걸린 문장과 첫 번째 제안
+function showDocumentPopup() {
+  if (!docCheck || !docCheck.flagged.length) return;
+  hideExistingPopup();
+
+  const popup = document.createElement('div');
+  popup.id = 'polite-popup';
+  popup.className = 'polite-popup';
+  popup.innerHTML = `
+    <div class="popup-header">
+      <div class="popup-title">수정을 권장하는 문장</div>
+      <button class="popup-close" onclick="this.closest('.polite-popup').remove()">×</button>
+    </div>
+    <div class="popup-body"><div class="suggestions-list" id="suggestions-container"></div></div>
+    <div class="popup-footer">Enter 적용 • Esc 닫기</div>`;
+
+  const container = popup.querySelector('#suggestions-container');
+  docCheck.flagged.forEach((f, index) => {
+    const suggestion = f.suggestions[0] || '';
+    const item = document.createElement('div');
+    item.className = 'suggestion-item';
+    item.tabIndex = 0;
+    // 메일 본문과 모델 출력은 textContent로만 넣음 (innerHTML이면 본문의 태그가 그대로 실행됨)
+    const number = document.createElement('div');
+    number.className = 'suggestion-number';
+    number.textContent = String(index + 1);
+    const text = document.createElement('div');
+    text.className = 'suggestion-text';
+    const original = document.createElement('div');
+    original.className = 'original-text';
+    original.textContent = f.text;
+    text.append(original, suggestion);
+    item.append(number, text);
+    if (suggestion) {
+      item.onclick = () => applyDocumentFix(f, suggestion);
+      item.onkeydown = (e) => { if (e.key === 'Enter') { e.preventDefault(); applyDocumentFix(f, suggestion); } };
+    }
+    container.appendChild(item);
+    if (index === 0) setTimeout(() => item.focus(), 100);
+  });
+
+  document.body.appendChild(popup);
+  positionPopup(popup);
+  setupPopupKeyboard(popup);
+}
+
+// 본문이 검사 때와 같으면 오프셋으로, 바뀌었으면 원문 문자열을 찾아 바꿈
+function applyDocumentFix(f, suggestion) {
+  const bodyDiv = docCheck?.bodyDiv;
+  if (!bodyDiv) return;
+  const current = bodyDiv.innerText;
+  let next = null;
+  if (current === docCheck.body) next = current.slice(0, f.start) + suggestion + current.slice(f.end);
+  else if (current.includes(f.text)) next = current.replace(f.text, suggestion);
+  if (next === null) { showError('문장이 바뀌어 적용할 수 없어요. 다시 검사해주세요.'); return; }
+
+  addToRollbackHistory(bodyDiv, f.text, suggestion, Date.now());
+  bodyDiv.innerText = next;
+  // 남은 문장의 오프셋을 새 본문에 맞춤
+  const delta = suggestion.length - (f.end - f.start);
+  docCheck.flagged = docCheck.flagged.filter(x => x !== f);
+  docCheck.flagged.forEach(x => { if (x.start > f.start) { x.start += delta; x.end += delta; } });
+  docCheck.body = next;
+
+  const rollbackBtn = document.querySelector('#gmail-rollback-btn');
+  if (rollbackBtn) updateRollbackButtonState(rollbackBtn, bodyDiv);
+  hideExistingPopup();
+  if (docCheck.flagged.length) showDocumentPopup();
+  else hideExistingIndicator();
+  showSuccessToast('표현이 개선되었습니다!');
+}
+
 function showRollbackPopup(bodyDiv) {
   const history = getRollbackHistory(bodyDiv);
   if (!history.length) {
@@ -687,7 +845,8 @@ function showShortcutHelp() {
       <div style="font-size:13px; line-height:1.6;">
         <div style="margin-bottom:12px;">
           <strong>🎯 톤 분석 및 제안</strong><br>
-          <code style="background:#f1f3f4; padding:2px 6px; border-radius:3px; font-family:monospace;">Alt + T</code> 톤 체크 및 제안 보기
+          <code style="background:#f1f3f4; padding:2px 6px; border-radius:3px; font-family:monospace;">Alt + T</code> 톤 체크 및 제안 보기<br>
+          <code style="background:#f1f3f4; padding:2px 6px; border-radius:3px; font-family:monospace;">Alt + D</code> 메일 전체 문장 검사
         </div>
         <div style="margin-bottom:12px;">
           <strong>🔄 되돌리기</strong><br>
@@ -848,8 +1007,9 @@ function setupKeyboardShortcuts() {
     if (!hasEditable) return;
     if (!e.altKey) return;
     const k = e.key.toLowerCase();
-    if (['t', 'z', 'q', 'h'].includes(k)) e.preventDefault();
+    if (['t', 'd', 'z', 'q', 'h'].includes(k)) e.preventDefault();
     if (k === 't') handleToneCheck();
+    if (k === 'd') analyzeDocument(lastTarget);
     if (k === 'z') handleShowRollback();
     if (k === 'q') handleQuickUndo();
     if (k === 'h') showShortcutHelp();
@@ -872,7 +1032,7 @@ function handleCommand(command) {
 function handleToneCheck() {
   if (!ensureComposeTarget()) return;
   if (suggestBuf.length > 0) showSuggestionsPopup();
-  else analyzeEmailTone(lastTarget);
+  else analyzeEmailTone(lastTarget, '', '', true);
 }
 function handleShowRollback() {
   if (ensureComposeTarget() && hasRollbackHistory(lastTarget)) showRollbackPopup(lastTarget);
@@ -0,0 +1,119 @@
+// native/bench/JsonBench.cpp — throughput of the shared JSON code (Json.hpp).
+//
+// Builds the frames the host and DLL actually exchange — an analyze request whose context is
+// --context-bytes of mixed Korean/English mail text (quotes, newlines, emoji), and a result
+// array of four suggestions — and times each operation for --seconds, printing one JSON report
+// with MB/s and ns per call:
+//   find_special   JsonFindSpecial over escape-free text (vector path) vs. a scalar byte loop
+//   escape         JsonEscape of the context
+//   unescape       JsonUnescape of the escaped context
+//   reader         JsonReader::Parse of the request frame + String("context")
+//   string_array   JsonParseStringArray of the result array
+//
+//   JsonBench [--seconds 1] [--context-bytes 2048]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    volatile size_t g_sink = 0; // keeps the timed calls from being optimized away
+
+    std::string mail_text(size_t bytes) {
+        static const char* const kLines[] = {
+            "\xec\x95\x88\xeb\x85\x95\xed\x95\x98\xec\x84\xb8\xec\x9a\x94, \xed\x8c\x80\xec\x9e\xa5\xeb\x8b\x98. ",
+            "Could you send me the \"Q3 numbers\" by tomorrow?\n",
+            "\xec\x9e\x90\xeb\xa3\x8c\xeb\x8a\x94 \xec\x9d\xb4\xeb\xb2\x88 \xec\xa3\xbc\xea\xb9\x8c\xec\xa7\x80 \xeb\xb6\x80\xed\x83\x81\xeb\x93\x9c\xeb\xa0\xa4\xec\x9a\x94. ",
+            "Thanks a lot \xf0\x9f\x98\x80\r\n\t- Kim\n",
+        };
+        std::string s;
+        for (size_t i = 0; s.size() < bytes; ++i) s += kLines[i % 4];
+        s.resize(bytes);
+        while (!s.empty() && (static_cast<unsigned char>(s.back()) & 0xC0) == 0x80) s.pop_back(); // whole chars
+        if (!s.empty() && static_cast<unsigned char>(s.back()) >= 0xC0) s.pop_back();
+        return s;
+    }
+
+    struct Result {
+        const char* name;
+        double      mb_s;
+        double      ns_per_call;
+    };
+
+    // Calls fn() for about `seconds` and returns the rate over `bytes` per call
+    template <class Fn>
+    Result measure(const char* name, size_t bytes, double seconds, Fn&& fn) {
+        for (int i = 0; i < 64; ++i) fn(); // warm caches and branch predictors
+        unsigned long long calls = 0;
+        const Clock::time_point t0 = Clock::now();
+        double elapsed = 0;
+        do {
+            for (int i = 0; i < 256; ++i) fn();
+            calls += 256;
+            elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+        } while (elapsed < seconds);
+        return { name, double(bytes) * double(calls) / elapsed / 1e6, elapsed * 1e9 / double(calls) };
+    }
+
+    size_t scalar_find_special(const char* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned char c = static_cast<unsigned char>(p[i]);
+            if (c == '"' || c == '\\' || c < 0x20) return i;
+        }
+        return n;
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 1.0;
+    size_t context_bytes = 2048;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+        if (a == "--seconds") seconds = std::atof(next());
+        else if (a == "--context-bytes") context_bytes = static_cast<size_t>(std::atoll(next()));
+        else { std::fprintf(stderr, "unknown option: %s\n", a.c_str()); return 2; }
+    }
+
+    const std::string context = mail_text(context_bytes);
+    std::string plain; // escape-free: the scan runs to the end
+    for (char c : context) {
+        if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20) plain.push_back(c);
+    }
+    const std::string escaped = AppUtils::JsonEscape(context);
+    const std::string frame = "{\"type\":\"analyze\",\"id\":42,\"session\":\"17:0\",\"focus\":\"" +
+        AppUtils::JsonEscape(mail_text(120)) + "\",\"context\":\"" + escaped +
+        "\",\"stream\":true,\"deadline_ms\":1500,\"priority\":\"live\"}";
+    std::string answer = "[\"impolite\"";
+    for (int i = 0; i < 3; ++i) answer += ",\"" + AppUtils::JsonEscape(mail_text(90 + 20 * i)) + "\"";
+    answer += "]";
+
+    std::vector<Result> results;
+    results.push_back(measure("find_special", plain.size(), seconds,
+        [&] { g_sink = g_sink + AppUtils::JsonFindSpecial(plain.data(), plain.size()); }));
+    results.push_back(measure("find_special_scalar", plain.size(), seconds,
+        [&] { g_sink = g_sink + scalar_find_special(plain.data(), plain.size()); }));
+    std::string out;
+    results.push_back(measure("escape", context.size(), seconds,
+        [&] { out.clear(); AppUtils::JsonAppendEscaped(out, context); g_sink = g_sink + out.size(); }));
+    results.push_back(measure("unescape", escaped.size(), seconds,
+        [&] { AppUtils::JsonUnescape(escaped, out); g_sink = g_sink + out.size(); }));
+    AppUtils::JsonReader reader;
+    results.push_back(measure("reader", frame.size(), seconds,
+        [&] { reader.Parse(frame); g_sink = g_sink + reader.String("context").size(); }));
+    std::vector<std::string> elements;
+    results.push_back(measure("string_array", answer.size(), seconds,
+        [&] { AppUtils::JsonParseStringArray(answer, elements); g_sink = g_sink + elements.size(); }));
+
+    std::printf("{\"context_bytes\":%zu,\"frame_bytes\":%zu", context.size(), frame.size());
+    for (const Result& r : results)
+        std::printf(",\"%s\":{\"mb_s\":%.1f,\"ns\":%.0f}", r.name, r.mb_s, r.ns_per_call);
+    std::printf("}\n");
+    return 0;
+}
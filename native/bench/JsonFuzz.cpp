@@ -0,0 +1,201 @@
+// native/bench/JsonFuzz.cpp — fuzz driver for the shared JSON code (Json.hpp).
+//
+// Every input goes through JsonReader::Parse, JsonParseStringArray, JsonUnescape, JsonFindMember
+// and JsonArrayStream (no crash, no out-of-bounds read under ASan), and through checks that
+// must hold for any byte string s:
+//   - JsonFindSpecial agrees with a scalar scan at every alignment
+//   - JsonUnescape(JsonEscape(s)) == s
+//   - {"k":"<escaped s>"}, {"<escaped s>":1} and ["<escaped s>",1,{},"<escaped s>"] read s back
+//   - JsonArrayStream reads s back from ["<escaped s>","<escaped s>"] fed in small chunks
+//   - unescaping valid UTF-8 yields valid UTF-8 (a lone surrogate becomes U+FFFD, never a hole)
+// A failed check prints the input as hex and aborts.
+//
+// With -DPC_LIBFUZZER=ON (clang) this is a libFuzzer target:
+//   JsonFuzz [libFuzzer options] [corpus dir]
+// Otherwise it carries its own mutator, seeded with host/DLL frames and any files given:
+//   JsonFuzz [--iterations 200000] [--seed 1] [--max-len 4096] [seed files...]
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+#include "JsonArrayStream.hpp"
+
+namespace {
+    bool is_special(unsigned char c) { return c == '"' || c == '\\' || c < 0x20; }
+
+    bool valid_utf8(std::string_view s) {
+        size_t i = 0;
+        while (i < s.size()) {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            size_t n = 0;
+            uint32_t cp = 0, min = 0;
+            if (c < 0x80) { ++i; continue; }
+            if ((c & 0xE0) == 0xC0) { n = 1; cp = c & 0x1F; min = 0x80; }
+            else if ((c & 0xF0) == 0xE0) { n = 2; cp = c & 0x0F; min = 0x800; }
+            else if ((c & 0xF8) == 0xF0) { n = 3; cp = c & 0x07; min = 0x10000; }
+            else return false;
+            if (i + n >= s.size()) return false;
+            for (size_t k = 1; k <= n; ++k) {
+                const unsigned char t = static_cast<unsigned char>(s[i + k]);
+                if ((t & 0xC0) != 0x80) return false;
+                cp = (cp << 6) | (t & 0x3F);
+            }
+            if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+            i += n + 1;
+        }
+        return true;
+    }
+
+    [[noreturn]] void fail(const char* what, const uint8_t* data, size_t size) {
+        std::fprintf(stderr, "JsonFuzz: %s\ninput (%zu bytes):", what, size);
+        for (size_t i = 0; i < size; ++i) std::fprintf(stderr, "%s%02x", (i % 32) ? " " : "\n  ", data[i]);
+        std::fprintf(stderr, "\n");
+        std::abort();
+    }
+
+    void check_one(const uint8_t* data, size_t size) {
+        const std::string_view in(reinterpret_cast<const char*>(data), size);
+
+        // Parsers: anything goes, but they must stay inside the input
+        AppUtils::JsonReader r;
+        if (r.Parse(in)) {
+            for (const char* key : { "type", "id", "focus", "context", "session", "suggestions" }) {
+                (void)r.String(key);
+                (void)r.Number(key, 0);
+                (void)r.Double(key, 0.0);
+                (void)r.Bool(key);
+                (void)r.Raw(key);
+            }
+        }
+        std::vector<std::string> arr;
+        (void)AppUtils::JsonParseStringArray(in, arr);
+        (void)AppUtils::JsonFindMember(in, "size");
+        {
+            const std::string text(in.data(), in.size()); // Feed wants NUL-terminated chunks
+            AppUtils::JsonArrayStream noise([](int, const std::string&) {});
+            noise.Feed(text.c_str());
+        }
+        std::string un;
+        AppUtils::JsonUnescape(in, un);
+        if (valid_utf8(in) && !valid_utf8(un)) fail("JsonUnescape turned valid UTF-8 into invalid UTF-8", data, size);
+
+        for (size_t off = 0; off < 16 && off <= size; ++off) {
+            size_t ref = off;
+            while (ref < size && !is_special(data[ref])) ++ref;
+            if (off + AppUtils::JsonFindSpecial(in.data() + off, size - off) != ref)
+                fail("JsonFindSpecial disagrees with the scalar scan", data, size);
+        }
+
+        // Escaping round-trips through every reader
+        const std::string esc = AppUtils::JsonEscape(in);
+        for (unsigned char c : esc) {
+            if (c < 0x20) fail("JsonEscape left a control byte", data, size);
+        }
+        AppUtils::JsonUnescape(esc, un);
+        if (un != in) fail("JsonUnescape(JsonEscape(s)) != s", data, size);
+
+        const std::string value_frame = "{\"k\":\"" + esc + "\"}"; // views point into the frame
+        if (!r.Parse(value_frame) || r.String("k") != in) fail("JsonReader string value != s", data, size);
+        const std::string key_frame = "{\"" + esc + "\":1}";
+        if (!r.Parse(key_frame) || r.Number(in, 0) != 1) fail("JsonReader escaped key != s", data, size);
+
+        const std::string array = "[\"" + esc + "\",1,{\"a\":[\"]\"]},\"" + esc + "\"]";
+        if (!AppUtils::JsonParseStringArray(array, arr) || arr.size() != 2 || arr[0] != in || arr[1] != in)
+            fail("JsonParseStringArray did not read s back", data, size);
+
+        // The model's output arrives in token-sized pieces: an escape may straddle two of them
+        const std::string answer = "[\"" + esc + "\",\"" + esc + "\"]";
+        std::vector<std::string> streamed;
+        AppUtils::JsonArrayStream stream([&](int, const std::string& e) { streamed.push_back(e); });
+        const size_t step = 1 + size % 7;
+        for (size_t at = 0; at < answer.size(); at += step) stream.Feed(answer.substr(at, step).c_str());
+        if (!stream.Closed() || streamed.size() != 2 || streamed[0] != in || streamed[1] != in)
+            fail("JsonArrayStream did not read s back", data, size);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    check_one(data, size);
+    return 0;
+}
+
+#ifndef PC_LIBFUZZER
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+namespace {
+    const char* const kSeeds[] = {
+        "{\"type\":\"analyze\",\"id\":7,\"session\":\"12:0\",\"focus\":\"\\uD55C\\uAD6D\\uC5B4 \\\"quoted\\\"\\n\","
+        "\"context\":\"Hi team,\\r\\n\\tplease\",\"stream\":true,\"deadline_ms\":1500,\"priority\":\"live\"}",
+        "{\"id\":3,\"type\":\"partial\",\"index\":1,\"text\":\"\\ud83d\\ude00 \\ud83d x \\ude00\"}",
+        "[\"impolite\",\"Could you send the numbers?\",\"\\u0000\\u001f\",{\"nested\":[1,2,\"]\"]},null,true,-1.5e3]",
+        "{\"dialog\":{\"context\":{\"size\":512},\"engine\":{\"backend\":{\"QnnHtp\":{\"spill-fill-bufsize\":0}}}}}",
+        "{\"a\":\"\\u12\",\"b\":\"\\q\\/\\\\\",\"c\":{},\"d\":[],\"e\":\"",
+        "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4 \xe3\x81\x82 \xf0\x9f\x98\x80",
+    };
+    const char* const kTokens[] = {
+        "\"", "\\", "\\u", "\\uD83D", "\\uDE00", "\\n", "{", "}", "[", "]", ":", ",", "null", "-0.5e+3",
+        "\xed\x95\x9c", "\xf0\x9f\x98\x80", "\x80", "\xc3", "\x01", " ",
+    };
+
+    void mutate(std::string& s, std::mt19937& rng, size_t max_len) {
+        auto pick = [&](size_t n) { return n ? static_cast<size_t>(rng() % n) : 0; };
+        const int steps = 1 + static_cast<int>(rng() % 4);
+        for (int i = 0; i < steps; ++i) {
+            const size_t at = pick(s.size() + 1);
+            switch (rng() % 6) {
+            case 0: if (!s.empty()) s[pick(s.size())] ^= static_cast<char>(1u << (rng() % 8)); break;
+            case 1: if (!s.empty()) s[pick(s.size())] = static_cast<char>(rng()); break;
+            case 2: s.insert(at, kTokens[pick(sizeof(kTokens) / sizeof(kTokens[0]))]); break;
+            case 3: s.erase(at, pick(16)); break;
+            case 4: if (at < s.size()) s.insert(pick(s.size() + 1), s.substr(at, pick(32))); break;
+            default: s.resize(pick(s.size() + 1)); break;
+            }
+        }
+        if (s.size() > max_len) s.resize(max_len);
+    }
+}
+
+int main(int argc, char** argv) {
+    long long iterations = 200000;
+    unsigned seed = 1;
+    size_t max_len = 4096;
+    std::vector<std::string> pool(std::begin(kSeeds), std::end(kSeeds));
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+        if (a == "--iterations") iterations = std::atoll(next());
+        else if (a == "--seed") seed = static_cast<unsigned>(std::atoi(next()));
+        else if (a == "--max-len") max_len = static_cast<size_t>(std::atoll(next()));
+        else if (a.compare(0, 2, "--") == 0) { std::fprintf(stderr, "unknown option: %s\n", a.c_str()); return 2; }
+        else {
+            std::ifstream f(a, std::ios::binary);
+            if (!f) { std::fprintf(stderr, "cannot read %s\n", a.c_str()); return 2; }
+            pool.emplace_back(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const std::string& s : pool) check_one(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    std::mt19937 rng(seed);
+    unsigned long long bytes = 0;
+    for (long long n = 0; n < iterations; ++n) {
+        std::string s = pool[rng() % pool.size()];
+        mutate(s, rng, max_len);
+        check_one(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+        bytes += s.size();
+        if (pool.size() < 256 && rng() % 64 == 0) pool.push_back(std::move(s)); // keep some mutants as parents
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("{\"iterations\":%lld,\"seed\":%u,\"pool\":%zu,\"bytes\":%llu,\"seconds\":%.2f}\n",
+        iterations, seed, pool.size(), bytes, secs);
+    return 0;
+}
+#endif
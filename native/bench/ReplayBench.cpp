@@ -0,0 +1,668 @@
+// native/bench/ReplayBench.cpp — end-to-end replay benchmark for PaperClipHost (Linux).
+//
+// Spawns the host, speaks the Native Messaging framing (4-byte length + JSON) over
+// its stdin/stdout, replays a corpus of analyze requests at a configurable arrival
+// rate and prints one JSON report: latency / time-to-first-frame / queueing
+// percentiles, throughput, outcome counts, latency per cascade tier, the library's
+// decode and cascade counters (speculative acceptance rate, effective tokens/s,
+// early-exit rate), the host's scheduler counters and the host's peak RSS.
+//
+//   ReplayBench --host ./PaperClipHost --lib ./libPaperClipStandIn.so
+//               --corpus ../bench/corpus.jsonl --requests 200 --rate 5 [--arrival poisson]
+//               [--sessions 0] [--no-stream] [--deadline-ms 0] [--token-us 20000]
+//               [--prefill-us 30000] [--seed 1] [--timeout-s 120] [--restarts 0]
+//               [--mix I:L:B] [--daemon]
+//
+// --rate 0 replays closed-loop (next request after the previous one finished).
+// --sessions K spreads requests over K compose sessions (0 = one per request, no preemption).
+// --mix I:L:B draws each request's priority class (interactive : live : background) with these
+//   weights and reports latency per class next to the host's queue counters (depth, drops,
+//   admission rejections). Without it every request is sent without a priority (host default).
+// --restarts N instead measures cold starts: N times, spawn a fresh host, send one analyze
+//   immediately (as the extension does after onDisconnect → connectNative) and time spawn →
+//   model ready / first frame / answer. Each request text gets a unique suffix so the
+//   result cache cannot answer it.
+// --daemon routes the host through a per-user daemon private to this run (the host's default
+//   outside benchmarks); without it the host loads the model in-process (PC_DAEMON=0). With
+//   --restarts it measures a browser reconnecting to an already warm daemon.
+// --documents N [--doc-sentences 50] instead compares whole-email checks: N emails of about
+//   50 corpus sentences each, once as a single analyze_document request and once the way the
+//   extension checks sentence by sentence (one analyze per sentence, closed loop). Both use the
+//   same native segmentation, and every sentence is tagged per path and run so no path is served
+//   from the other's cache. Needs a library with the v2 ABI (the stand-in has none).
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Json.hpp"
+#include "SentenceSplitter.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string host = "./PaperClipHost";
+        std::string lib = "./libPaperClipStandIn.so";
+        std::string corpus = "corpus.jsonl";
+        int         requests = 100;
+        double      rate = 5.0;          // req/s; 0 = closed loop
+        bool        poisson = true;
+        int         sessions = 0;
+        bool        stream = true;
+        uint32_t    deadline_ms = 0;
+        long long   token_us = -1;       // -1 = stand-in default
+        long long   prefill_us = -1;
+        unsigned    seed = 1;
+        int         timeout_s = 120;
+        int         restarts = 0;        // > 0: cold-start mode
+        int         documents = 0;       // > 0: whole-document mode
+        int         doc_sentences = 50;
+        double      mix[3] = { 0, 0, 0 }; // interactive : live : background weights (all 0 = no priority)
+        bool        daemon = false;
+    };
+
+    const char* const kPriorityNames[3] = { "interactive", "live", "background" };
+
+    struct Sample {
+        std::string lang, focus, context;
+    };
+
+    struct Record {
+        std::string        lang;
+        Clock::time_point  sent{}, first{}, done{};
+        bool               has_first = false, finished = false;
+        std::string        outcome;      // ok | superseded | deadline | cancelled | error | busy
+        std::string        tier;         // fastpath | cache | verdict | rewrite ("" = not reported)
+        std::string        priority;     // --mix class ("" = none sent)
+        long long          queue_us = -1;
+    };
+
+    std::mutex              g_mu;
+    std::condition_variable g_cv;
+    std::vector<Record>     g_records;
+    int                     g_finished = 0;
+    std::string             g_stats_frame;      // host's reply to {"type":"stats"} at the end
+
+    bool write_all(int fd, const char* p, size_t n) {
+        while (n) {
+            const ssize_t w = ::write(fd, p, n);
+            if (w <= 0) return false;
+            p += w; n -= static_cast<size_t>(w);
+        }
+        return true;
+    }
+
+    bool read_all(int fd, char* p, size_t n) {
+        while (n) {
+            const ssize_t r = ::read(fd, p, n);
+            if (r <= 0) return false;
+            p += r; n -= static_cast<size_t>(r);
+        }
+        return true;
+    }
+
+    bool send_frame(int fd, const std::string& json) {
+        const uint32_t len = static_cast<uint32_t>(json.size());
+        std::string buf(reinterpret_cast<const char*>(&len), 4);
+        buf += json;
+        return write_all(fd, buf.data(), buf.size());
+    }
+
+    std::vector<Sample> load_corpus(const std::string& path) {
+        std::vector<Sample> out;
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        AppUtils::JsonReader j;
+        while (std::getline(in, line)) {
+            if (line.empty() || !j.Parse(line)) continue;
+            Sample s;
+            s.lang = j.String("lang", "xx");
+            s.focus = j.String("focus");
+            s.context = j.String("context");
+            if (!s.focus.empty()) out.push_back(std::move(s));
+        }
+        return out;
+    }
+
+    void reader(int fd) {
+        std::string buf;
+        AppUtils::JsonReader j;
+        for (;;) {
+            uint32_t len = 0;
+            if (!read_all(fd, reinterpret_cast<char*>(&len), 4) || len == 0) return;
+            buf.resize(len);
+            if (!read_all(fd, &buf[0], len)) return;
+            const auto now = Clock::now();
+            if (!j.Parse(buf)) continue;
+            const long long id = j.Number("id", -1);
+            if (id < 0) { // diag / pong / stats
+                if (j.String("type") == "stats") {
+                    std::lock_guard<std::mutex> lk(g_mu);
+                    g_stats_frame = buf;
+                    g_cv.notify_all();
+                }
+                continue;
+            }
+            std::lock_guard<std::mutex> lk(g_mu);
+            if (id >= static_cast<long long>(g_records.size())) continue;
+            Record& r = g_records[static_cast<size_t>(id)];
+            if (r.finished) continue;
+            if (!r.has_first) { r.first = now; r.has_first = true; }
+
+            const std::string_view type = j.String("type");
+            std::string outcome;
+            if (type == "aborted") outcome = std::string(j.String("reason", "aborted"));
+            else if (j.Has("suggestions")) outcome = "ok";
+            else if (j.Has("error")) outcome = j.String("error") == "busy" ? "busy" : "error";
+            if (outcome.empty()) continue; // partial frame
+            r.outcome = outcome;
+            r.done = now;
+            r.queue_us = j.Number("queue_us", -1);
+            r.tier = std::string(j.String("tier"));
+            r.finished = true;
+            ++g_finished;
+            g_cv.notify_all();
+        }
+    }
+
+    double ms_between(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+
+    double percentile(std::vector<double> v, double p) {
+        if (v.empty()) return 0.0;
+        std::sort(v.begin(), v.end());
+        size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(v.size()) + 0.999999);
+        rank = std::min(std::max<size_t>(rank, 1), v.size());
+        return v[rank - 1];
+    }
+
+    std::string dist_json(const std::vector<double>& v) {
+        double sum = 0, mx = 0;
+        for (double x : v) { sum += x; mx = std::max(mx, x); }
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+            "{\"n\":%zu,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"mean\":%.3f,\"max\":%.3f}",
+            v.size(), percentile(v, 50), percentile(v, 95), percentile(v, 99),
+            v.empty() ? 0.0 : sum / static_cast<double>(v.size()), mx);
+        return buf;
+    }
+
+    long vm_hwm_kb(pid_t pid) {
+        std::ifstream in("/proc/" + std::to_string(pid) + "/status");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) return std::strtol(line.c_str() + 6, nullptr, 10);
+        }
+        return 0;
+    }
+
+    bool parse_args(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string a = argv[i];
+            auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+            if (a == "--host") o.host = next();
+            else if (a == "--lib") o.lib = next();
+            else if (a == "--corpus") o.corpus = next();
+            else if (a == "--requests") o.requests = std::atoi(next());
+            else if (a == "--rate") o.rate = std::atof(next());
+            else if (a == "--arrival") o.poisson = std::string(next()) != "fixed";
+            else if (a == "--sessions") o.sessions = std::atoi(next());
+            else if (a == "--no-stream") o.stream = false;
+            else if (a == "--deadline-ms") o.deadline_ms = static_cast<uint32_t>(std::atoi(next()));
+            else if (a == "--token-us") o.token_us = std::atoll(next());
+            else if (a == "--prefill-us") o.prefill_us = std::atoll(next());
+            else if (a == "--seed") o.seed = static_cast<unsigned>(std::atoi(next()));
+            else if (a == "--timeout-s") o.timeout_s = std::atoi(next());
+            else if (a == "--restarts") o.restarts = std::atoi(next());
+            else if (a == "--documents") o.documents = std::atoi(next());
+            else if (a == "--doc-sentences") o.doc_sentences = std::max(1, std::atoi(next()));
+            else if (a == "--daemon") o.daemon = true;
+            else if (a == "--mix") {
+                if (std::sscanf(next(), "%lf:%lf:%lf", &o.mix[0], &o.mix[1], &o.mix[2]) != 3 ||
+                    o.mix[0] < 0 || o.mix[1] < 0 || o.mix[2] < 0 || o.mix[0] + o.mix[1] + o.mix[2] <= 0) {
+                    std::fprintf(stderr, "--mix wants I:L:B weights, e.g. 1:4:1\n");
+                    return false;
+                }
+            }
+            else { std::fprintf(stderr, "unknown option: %s\n", a.c_str()); return false; }
+        }
+        return o.requests > 0;
+    }
+
+    // host의 stdin/stdout을 파이프로 잡고 실행. 실패 시 -1.
+    pid_t spawn_host(const Options& opt, int& to_fd, int& from_fd) {
+        int to_host[2], from_host[2];
+        if (::pipe(to_host) != 0 || ::pipe(from_host) != 0) { std::perror("pipe"); return -1; }
+        const pid_t pid = ::fork();
+        if (pid < 0) { std::perror("fork"); return -1; }
+        if (pid == 0) {
+            ::dup2(to_host[0], STDIN_FILENO);
+            ::dup2(from_host[1], STDOUT_FILENO);
+            ::close(to_host[0]); ::close(to_host[1]);
+            ::close(from_host[0]); ::close(from_host[1]);
+            ::setenv("PC_SUGGESTION_DLL", opt.lib.c_str(), 1);
+            if (opt.token_us >= 0) ::setenv("PC_STANDIN_TOKEN_US", std::to_string(opt.token_us).c_str(), 1);
+            if (opt.prefill_us >= 0) ::setenv("PC_STANDIN_PREFILL_US", std::to_string(opt.prefill_us).c_str(), 1);
+            if (opt.daemon) { // one daemon per bench run, gone shortly after the last host exits
+                ::setenv("PC_DAEMON_ADDR", ("/tmp/replaybench-" + std::to_string(::getppid()) + "/host.sock").c_str(), 1);
+                ::setenv("PC_DAEMON_IDLE_S", "2", 1);
+            }
+            else {
+                ::setenv("PC_DAEMON", "0", 1);
+            }
+            ::execl(opt.host.c_str(), opt.host.c_str(), static_cast<char*>(nullptr));
+            std::perror("exec host");
+            ::_exit(127);
+        }
+        ::close(to_host[0]);
+        ::close(from_host[1]);
+        to_fd = to_host[1];
+        from_fd = from_host[0];
+        return pid;
+    }
+
+    std::string analyze_frame(long long id, const std::string& session, const Sample& s,
+                              const std::string& suffix, const Options& opt, const char* priority = nullptr) {
+        const std::string focus = s.focus + suffix;
+        std::string frame = "{\"type\":\"analyze\",\"id\":" + std::to_string(id) + ",\"session\":\"";
+        AppUtils::JsonAppendEscaped(frame, session);
+        frame += "\",\"focus\":\"";
+        AppUtils::JsonAppendEscaped(frame, focus);
+        frame += "\",\"context\":\"";
+        AppUtils::JsonAppendEscaped(frame, s.context);
+        frame += "\",\"body\":\"";
+        AppUtils::JsonAppendEscaped(frame, s.context.empty() ? focus : s.context + " " + focus);
+        frame += "\",\"stream\":";
+        frame += opt.stream ? "true" : "false";
+        if (opt.deadline_ms) frame += ",\"deadline_ms\":" + std::to_string(opt.deadline_ms);
+        if (priority) frame += std::string(",\"priority\":\"") + priority + "\"";
+        frame += "}";
+        return frame;
+    }
+
+    // ── cold-start mode ──
+    int run_restarts(const Options& opt, const std::vector<Sample>& corpus) {
+        std::vector<double> ready, first, answer;
+        std::map<std::string, int> outcomes, prefix;
+        for (int r = 0; r < opt.restarts; ++r) {
+            int to_fd = -1, from_fd = -1;
+            const auto t0 = Clock::now();
+            const pid_t pid = spawn_host(opt, to_fd, from_fd);
+            if (pid < 0) return 1;
+
+            const Sample& s = corpus[static_cast<size_t>(r) % corpus.size()];
+            const std::string suffix = " #" + std::to_string(static_cast<long>(::getpid())) + "-" + std::to_string(r);
+            send_frame(to_fd, analyze_frame(0, "bench:restart", s, suffix, opt));
+
+            bool got_first = false;
+            std::string outcome = "unfinished", buf;
+            AppUtils::JsonReader j, warm;
+            for (;;) {
+                uint32_t len = 0;
+                if (!read_all(from_fd, reinterpret_cast<char*>(&len), 4) || len == 0) break;
+                buf.resize(len);
+                if (!read_all(from_fd, &buf[0], len)) break;
+                const double ms = ms_between(t0, Clock::now());
+                if (!j.Parse(buf)) continue;
+                if (j.String("type") == "status" && j.String("state") == "ready") {
+                    ready.push_back(ms);
+                    if (warm.Parse(j.Raw("warmup"))) ++prefix[std::string(warm.String("prefix", "?"))];
+                    continue;
+                }
+                if (j.Number("id", -1) != 0) continue;
+                if (!got_first) { first.push_back(ms); got_first = true; }
+                if (j.Has("suggestions")) outcome = "ok";
+                else if (j.String("type") == "aborted") outcome = std::string(j.String("reason", "aborted"));
+                else if (j.Has("error")) outcome = "error";
+                else continue; // partial
+                answer.push_back(ms);
+                break;
+            }
+            ++outcomes[outcome];
+            ::close(to_fd);
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            ::close(from_fd);
+        }
+
+        std::string out = "{\"config\":{\"restarts\":" + std::to_string(opt.restarts) +
+            ",\"stream\":" + (opt.stream ? "true" : "false") + "},\"outcomes\":{";
+        bool first_key = true;
+        for (const auto& kv : outcomes) {
+            if (!first_key) out += ',';
+            first_key = false;
+            out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + std::to_string(kv.second);
+        }
+        out += "},\"prefix\":{";
+        first_key = true;
+        for (const auto& kv : prefix) {
+            if (!first_key) out += ',';
+            first_key = false;
+            out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + std::to_string(kv.second);
+        }
+        out += "},\"spawn_to_ready_ms\":" + dist_json(ready);
+        out += ",\"spawn_to_first_frame_ms\":" + dist_json(first);
+        out += ",\"spawn_to_answer_ms\":" + dist_json(answer);
+        out += "}";
+        std::printf("%s\n", out.c_str());
+        return outcomes["ok"] == opt.restarts ? 0 : 1;
+    }
+
+    // ── document mode ──
+    bool read_frame(int fd, std::string& buf) {
+        uint32_t len = 0;
+        if (!read_all(fd, reinterpret_cast<char*>(&len), 4) || len == 0) return false;
+        buf.resize(len);
+        return read_all(fd, &buf[0], len);
+    }
+
+    // About n sentences from the corpus, each tagged so it is unique to this path and run
+    std::vector<std::string> make_email(const std::vector<Sample>& corpus, int doc, int n, const std::string& tag) {
+        std::vector<std::string> out;
+        for (size_t i = static_cast<size_t>(doc) * static_cast<size_t>(n); static_cast<int>(out.size()) < n; ++i) {
+            const std::string& focus = corpus[i % corpus.size()].focus;
+            for (const AppUtils::SentenceSpan& sp : AppUtils::SplitSentences(focus))
+                out.push_back("[" + tag + "." + std::to_string(doc) + "." + std::to_string(out.size()) + "] " +
+                    focus.substr(sp.begin, sp.end - sp.begin));
+        }
+        return out;
+    }
+
+    std::string join_email(const std::vector<std::string>& sentences, size_t n) {
+        std::string body;
+        for (size_t k = 0; k < n; ++k) {
+            if (k) body += k % 5 == 0 ? "\n" : " "; // paragraphs of five
+            body += sentences[k];
+        }
+        return body;
+    }
+
+    std::string outcome_of(const AppUtils::JsonReader& j) {
+        if (j.String("type") == "aborted") return std::string(j.String("reason", "aborted"));
+        if (j.String("type") == "document" || j.Has("suggestions")) return "ok";
+        if (j.Has("error")) return "error";
+        return std::string();
+    }
+
+    std::string counts_json(const std::map<std::string, int>& m) {
+        std::string out = "{";
+        for (const auto& kv : m) {
+            if (out.size() > 1) out += ',';
+            out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + std::to_string(kv.second);
+        }
+        return out + "}";
+    }
+
+    int run_documents(const Options& opt, const std::vector<Sample>& corpus) {
+        int to_fd = -1, from_fd = -1;
+        const pid_t pid = spawn_host(opt, to_fd, from_fd);
+        if (pid < 0) return 1;
+
+        std::string buf;
+        AppUtils::JsonReader j;
+        // Both paths start on a loaded model
+        send_frame(to_fd, "{\"type\":\"status\"}");
+        while (read_frame(from_fd, buf)) {
+            if (j.Parse(buf) && j.String("type") == "status" && j.String("state") != "loading") break;
+        }
+
+        const std::string run = std::to_string(static_cast<long>(::getpid()));
+        std::vector<double> doc_ms, doc_first_ms, sent_ms, sent_first_ms;
+        std::map<std::string, int> doc_outcomes, sent_outcomes;
+        long long sentences = 0, unique = 0, flagged = 0;
+        long long id = 0;
+        for (int d = 0; d < opt.documents; ++d) {
+            // one analyze_document
+            {
+                const std::vector<std::string> email = make_email(corpus, d, opt.doc_sentences, "d" + run);
+                std::string frame = "{\"type\":\"analyze_document\",\"id\":" + std::to_string(++id) +
+                    ",\"session\":\"bench:doc\",\"body\":\"";
+                AppUtils::JsonAppendEscaped(frame, join_email(email, email.size()));
+                frame += "\"";
+                if (opt.deadline_ms) frame += ",\"deadline_ms\":" + std::to_string(opt.deadline_ms);
+                frame += "}";
+                const auto t0 = Clock::now();
+                bool got_first = false;
+                std::string outcome = "unfinished";
+                send_frame(to_fd, frame);
+                while (read_frame(from_fd, buf)) {
+                    if (!j.Parse(buf) || j.Number("id", -1) != id) continue;
+                    if (j.String("type") == "sentence") {
+                        if (!got_first) { doc_first_ms.push_back(ms_between(t0, Clock::now())); got_first = true; }
+                        continue;
+                    }
+                    outcome = outcome_of(j);
+                    if (outcome.empty()) continue;
+                    if (outcome == "ok") {
+                        doc_ms.push_back(ms_between(t0, Clock::now()));
+                        sentences += j.Number("sentences", 0);
+                        unique += j.Number("unique", 0);
+                        flagged += j.Number("flagged", 0);
+                    }
+                    break;
+                }
+                ++doc_outcomes[outcome];
+            }
+            // the same email sentence by sentence
+            {
+                const std::vector<std::string> email = make_email(corpus, d, opt.doc_sentences, "s" + run);
+                const auto t0 = Clock::now();
+                std::string outcome = "ok";
+                for (size_t k = 0; k < email.size() && outcome == "ok"; ++k) {
+                    Sample s;
+                    s.focus = email[k];
+                    s.context = join_email(email, k);
+                    Options one = opt;
+                    one.stream = false;
+                    send_frame(to_fd, analyze_frame(++id, "bench:sentences", s, std::string(), one));
+                    outcome = "unfinished";
+                    while (read_frame(from_fd, buf)) {
+                        if (!j.Parse(buf) || j.Number("id", -1) != id) continue;
+                        outcome = outcome_of(j);
+                        if (!outcome.empty()) break;
+                    }
+                    if (k == 0 && outcome == "ok") sent_first_ms.push_back(ms_between(t0, Clock::now()));
+                }
+                if (outcome == "ok") sent_ms.push_back(ms_between(t0, Clock::now()));
+                ++sent_outcomes[outcome];
+            }
+        }
+
+        ::close(to_fd);
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        ::close(from_fd);
+
+        auto total = [](const std::vector<double>& v) { double t = 0; for (double x : v) t += x; return t; };
+        char num[160];
+        std::string out = "{\"config\":{\"documents\":" + std::to_string(opt.documents) +
+            ",\"doc_sentences\":" + std::to_string(opt.doc_sentences) + "}";
+        out += ",\"document\":{\"outcomes\":" + counts_json(doc_outcomes);
+        std::snprintf(num, sizeof(num), ",\"sentences\":%lld,\"unique\":%lld,\"flagged\":%lld,\"sentences_per_s\":%.2f",
+            sentences, unique, flagged, total(doc_ms) > 0 ? sentences * 1000.0 / total(doc_ms) : 0.0);
+        out += num;
+        out += ",\"latency_ms\":" + dist_json(doc_ms) + ",\"first_sentence_ms\":" + dist_json(doc_first_ms) + "}";
+        out += ",\"per_sentence\":{\"outcomes\":" + counts_json(sent_outcomes);
+        std::snprintf(num, sizeof(num), ",\"sentences_per_s\":%.2f",
+            total(sent_ms) > 0 ? sentences * 1000.0 / total(sent_ms) : 0.0);
+        out += num;
+        out += ",\"latency_ms\":" + dist_json(sent_ms) + ",\"first_sentence_ms\":" + dist_json(sent_first_ms) + "}";
+        std::snprintf(num, sizeof(num), ",\"speedup_p50\":%.2f",
+            percentile(doc_ms, 50) > 0 ? percentile(sent_ms, 50) / percentile(doc_ms, 50) : 0.0);
+        out += num;
+        out += "}";
+        std::printf("%s\n", out.c_str());
+        return doc_outcomes["ok"] == opt.documents && sent_outcomes["ok"] == opt.documents ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 2;
+
+    const std::vector<Sample> corpus = load_corpus(opt.corpus);
+    if (corpus.empty()) {
+        std::fprintf(stderr, "empty corpus: %s\n", opt.corpus.c_str());
+        return 2;
+    }
+
+    ::signal(SIGPIPE, SIG_IGN);
+    if (opt.restarts > 0) return run_restarts(opt, corpus);
+    if (opt.documents > 0) return run_documents(opt, corpus);
+
+    int to_fd = -1, from_fd = -1;
+    const pid_t pid = spawn_host(opt, to_fd, from_fd);
+    if (pid < 0) return 1;
+
+    g_records.resize(static_cast<size_t>(opt.requests));
+    std::thread rd(reader, from_fd);
+
+    std::mt19937 rng(opt.seed);
+    std::exponential_distribution<double> gap(opt.rate > 0 ? opt.rate : 1.0);
+    const bool mixed = opt.mix[0] + opt.mix[1] + opt.mix[2] > 0;
+    std::discrete_distribution<int> pick_class(opt.mix, opt.mix + 3);
+
+    const auto t0 = Clock::now();
+    auto next_at = t0;
+    for (int i = 0; i < opt.requests; ++i) {
+        const Sample& s = corpus[static_cast<size_t>(i) % corpus.size()];
+        if (opt.rate > 0) {
+            std::this_thread::sleep_until(next_at);
+            const double dt = opt.poisson ? gap(rng) : 1.0 / opt.rate;
+            next_at += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+        }
+
+        const char* priority = mixed ? kPriorityNames[pick_class(rng)] : nullptr;
+        const std::string frame = analyze_frame(i, "bench:" + std::to_string(opt.sessions > 0 ? i % opt.sessions : i),
+            s, std::string(), opt, priority);
+
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            g_records[static_cast<size_t>(i)].lang = s.lang;
+            g_records[static_cast<size_t>(i)].priority = priority ? priority : "";
+            g_records[static_cast<size_t>(i)].sent = Clock::now();
+        }
+        if (!send_frame(to_fd, frame)) { std::fprintf(stderr, "host closed stdin\n"); break; }
+
+        if (opt.rate <= 0) { // closed loop
+            std::unique_lock<std::mutex> lk(g_mu);
+            g_cv.wait_for(lk, std::chrono::seconds(opt.timeout_s),
+                [&] { return g_records[static_cast<size_t>(i)].finished; });
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lk(g_mu);
+        g_cv.wait_for(lk, std::chrono::seconds(opt.timeout_s), [&] { return g_finished >= opt.requests; });
+    }
+    const auto t_end = Clock::now();
+    long peak_kb = vm_hwm_kb(pid);
+
+    // Library decode / cascade counters (speculative acceptance, effective tokens/s, early exits)
+    std::string decode = "{}", cascade = "{}", queue_stats = "{}";
+    if (send_frame(to_fd, "{\"type\":\"stats\"}")) {
+        std::unique_lock<std::mutex> lk(g_mu);
+        g_cv.wait_for(lk, std::chrono::seconds(5), [&] { return !g_stats_frame.empty(); });
+        AppUtils::JsonReader st;
+        if (st.Parse(g_stats_frame)) {
+            if (!st.Raw("decode").empty()) decode.assign(st.Raw("decode"));
+            if (!st.Raw("cascade").empty()) cascade.assign(st.Raw("cascade"));
+            if (!st.Raw("queue").empty()) queue_stats.assign(st.Raw("queue"));
+        }
+    }
+
+    ::close(to_fd); // EOF → host drains and exits
+    int status = 0;
+    struct rusage ru {};
+    ::wait4(pid, &status, 0, &ru);
+    peak_kb = std::max(peak_kb, static_cast<long>(ru.ru_maxrss));
+    rd.join();
+    ::close(from_fd);
+
+    // ── report ──
+    std::vector<double> latency, ttff, queue;
+    std::map<std::string, std::vector<double>> by_lang, by_tier, by_priority;
+    std::map<std::string, int> outcomes;
+    int unfinished = 0;
+    for (const Record& r : g_records) {
+        if (!r.finished) { ++unfinished; continue; }
+        ++outcomes[r.outcome];
+        if (r.queue_us >= 0) queue.push_back(static_cast<double>(r.queue_us) / 1000.0);
+        if (r.outcome != "ok") continue;
+        const double ms = ms_between(r.sent, r.done);
+        latency.push_back(ms);
+        by_lang[r.lang].push_back(ms);
+        if (!r.tier.empty()) by_tier[r.tier].push_back(ms);
+        if (!r.priority.empty()) by_priority[r.priority].push_back(ms);
+        if (r.has_first) ttff.push_back(ms_between(r.sent, r.first));
+    }
+    const double wall_s = std::chrono::duration<double>(t_end - t0).count();
+
+    std::string out = "{\"config\":{\"requests\":" + std::to_string(opt.requests);
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), ",\"rate\":%.3f,\"arrival\":\"%s\",\"sessions\":%d,\"stream\":%s,\"deadline_ms\":%u}",
+        opt.rate, opt.rate > 0 ? (opt.poisson ? "poisson" : "fixed") : "closed", opt.sessions,
+        opt.stream ? "true" : "false", opt.deadline_ms);
+    out += buf;
+    out += ",\"outcomes\":{";
+    bool first = true;
+    for (const auto& kv : outcomes) {
+        if (!first) out += ',';
+        first = false;
+        out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + std::to_string(kv.second);
+    }
+    out += "},\"unfinished\":" + std::to_string(unfinished);
+    std::snprintf(buf, sizeof(buf), ",\"wall_s\":%.3f,\"throughput_rps\":%.3f",
+        wall_s, wall_s > 0 ? static_cast<double>(latency.size()) / wall_s : 0.0);
+    out += buf;
+    out += ",\"latency_ms\":" + dist_json(latency);
+    out += ",\"ttff_ms\":" + dist_json(ttff);
+    out += ",\"queue_ms\":" + dist_json(queue);
+    out += ",\"latency_by_lang_ms\":{";
+    first = true;
+    for (const auto& kv : by_lang) {
+        if (!first) out += ',';
+        first = false;
+        out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + dist_json(kv.second);
+    }
+    out += "},\"latency_by_tier_ms\":{";
+    first = true;
+    for (const auto& kv : by_tier) {
+        if (!first) out += ',';
+        first = false;
+        out += "\"" + AppUtils::JsonEscape(kv.first) + "\":" + dist_json(kv.second);
+    }
+    out += "},\"latency_by_priority_ms\":{";
+    first = true;
+    for (const auto& kv : by_priority) {
+        if (!first) out += ',';
+        first = false;
+        out += "\"" + kv.first + "\":" + dist_json(kv.second);
+    }
+    out += "},\"decode\":" + decode;
+    out += ",\"cascade\":" + cascade;
+    out += ",\"queue\":" + queue_stats;
+    out += ",\"host_peak_rss_kb\":" + std::to_string(peak_kb);
+    out += ",\"host_exit\":" + std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    out += "}";
+    std::printf("%s\n", out.c_str());
+    return unfinished ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+// native/bench/StandInNative.cpp — stand-in for PaperClipNative with the same C ABI.
+//
+// No model: answers are synthesized from the Target, and time is spent the way
+// the real library spends it (prefill proportional to prompt bytes, then one
+// delay per decoded token) so host-side latency can be measured on any machine.
+//
+// Timing (environment, microseconds):
+//   PC_STANDIN_PREFILL_US           fixed prefill cost per request       (default 30000)
+//   PC_STANDIN_PREFILL_US_PER_BYTE  extra prefill per Target byte        (default 40)
+//   PC_STANDIN_TOKEN_US             per decoded token                    (default 20000)
+// A decoded token is ~4 bytes of answer text.
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PaperClipNative.h"
+#include "Json.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<bool>     g_active{ false };
+    std::atomic<bool>     g_abort{ false };
+    std::atomic<uint32_t> g_deadline_ms{ 0 };
+
+    long long env_us(const char* name, long long dflt) {
+        const char* v = std::getenv(name);
+        if (!v || !*v) return dflt;
+        const long long n = std::strtoll(v, nullptr, 10);
+        return n >= 0 ? n : dflt;
+    }
+
+    char* heap_dup(const std::string& s) {
+        char* c = static_cast<char*>(std::malloc(s.size() + 1));
+        if (!c) return nullptr;
+        std::memcpy(c, s.data(), s.size());
+        c[s.size()] = '\0';
+        return c;
+    }
+
+    // Sleeps in token-sized slices so abort/deadline are noticed promptly.
+    // Returns the abort reason, or nullptr when the full time elapsed.
+    const char* spend(long long us, Clock::time_point deadline) {
+        const auto until = Clock::now() + std::chrono::microseconds(us);
+        while (Clock::now() < until) {
+            if (g_abort.load()) return "cancelled";
+            if (Clock::now() >= deadline) return "deadline";
+            std::this_thread::sleep_for(std::min<Clock::duration>(until - Clock::now(), std::chrono::milliseconds(2)));
+        }
+        if (g_abort.load()) return "cancelled";
+        return Clock::now() >= deadline ? "deadline" : nullptr;
+    }
+
+    bool looks_rude(const std::string& s) {
+        static const char* kWords[] = { "idiot", "stupid", "asap", "now!", "\xEB\xB3\x91\xEC\x8B\xA0" /*병신*/,
+                                        "\xE3\x83\x90\xE3\x82\xAB" /*バカ*/ };
+        for (const char* w : kWords) if (s.find(w) != std::string::npos) return true;
+        return false;
+    }
+
+    const char* run(const char* input, pr_element_cb on_element, void* user) {
+        const std::string target = input ? input : "";
+        const uint32_t dl = g_deadline_ms.load();
+        const Clock::time_point deadline = dl ? Clock::now() + std::chrono::milliseconds(dl) : Clock::time_point::max();
+        g_abort = false;
+        g_active = true;
+        struct Reset { ~Reset() { g_active = false; } } reset;
+
+        const std::vector<std::string> elements = {
+            looks_rude(target) ? "impolite" : "polite",
+            "Could you please take a look at this: " + target,
+            "I would appreciate it if you could consider the following: " + target,
+            "When you have a moment, " + target,
+        };
+
+        const long long token_us = env_us("PC_STANDIN_TOKEN_US", 20000);
+        const long long prefill_us = env_us("PC_STANDIN_PREFILL_US", 30000) +
+            env_us("PC_STANDIN_PREFILL_US_PER_BYTE", 40) * static_cast<long long>(target.size());
+
+        auto aborted = [](const char* why) {
+            return heap_dup(std::string("{\"error\":\"") + why + "\",\"stage\":\"aborted\"}");
+        };
+
+        if (const char* why = spend(prefill_us, deadline)) return aborted(why);
+
+        std::string out = "[";
+        for (size_t i = 0; i < elements.size(); ++i) {
+            const long long tokens = static_cast<long long>(elements[i].size() / 4) + 2; // + quotes/comma
+            if (const char* why = spend(tokens * token_us, deadline)) return aborted(why);
+            if (on_element) on_element(static_cast<int>(i), elements[i].c_str(), user);
+            if (i) out += ',';
+            out += '"';
+            AppUtils::JsonAppendEscaped(out, elements[i]);
+            out += '"';
+        }
+        out += ']';
+        return heap_dup(out);
+    }
+}
+
+extern "C" PR_API const char* generate_polite_rewrite(const char* input_utf8) {
+    return run(input_utf8, nullptr, nullptr);
+}
+
+extern "C" PR_API const char* generate_polite_rewrite_stream(const char* input_utf8,
+    pr_element_cb on_element, void* user) {
+    return run(input_utf8, on_element, user);
+}
+
+extern "C" PR_API int polite_rewrite_abort() {
+    if (!g_active.load()) return 1;
+    g_abort = true;
+    return 0;
+}
+
+extern "C" PR_API void polite_rewrite_set_deadline_ms(uint32_t ms) {
+    g_deadline_ms = ms;
+}
+
+extern "C" PR_API void polite_rewrite_free(const char* str) {
+    if (str) std::free(const_cast<char*>(str));
+}
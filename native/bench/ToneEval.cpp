@@ -0,0 +1,80 @@
+// native/bench/ToneEval.cpp — labeled check of the tone fast path (ToneClassifier).
+//
+// Runs ToneClassifier::ShortCircuit over every "focus" in the corpus at each threshold and
+// prints one JSON report: per threshold, how many polite rows skipped the model (recall) and
+// how many impolite ones did. An impolite row answered "polite" without the model is a wrong
+// answer the user never gets a rewrite for, so any such row is printed and the exit code is 1.
+// Rows carry "tone":"polite"|"impolite"; rows without a label are skipped.
+//
+//   ToneEval [--corpus corpus.jsonl] [--threshold 0.9 ...]   (default: 0.5 0.7 0.8 0.9 0.95)
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+#include "ToneClassifier.hpp"
+
+namespace {
+    struct Row {
+        std::string focus;
+        bool        polite = false;
+    };
+
+    std::vector<Row> load_corpus(const std::string& path) {
+        std::vector<Row> out;
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        AppUtils::JsonReader j;
+        while (std::getline(in, line)) {
+            if (line.empty() || !j.Parse(line)) continue;
+            const std::string_view tone = j.String("tone");
+            Row r;
+            r.focus = j.String("focus");
+            r.polite = tone == "polite";
+            if (!r.focus.empty() && (r.polite || tone == "impolite")) out.push_back(std::move(r));
+        }
+        return out;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string corpus = "corpus.jsonl";
+    std::vector<double> thresholds;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+        if (a == "--corpus") corpus = next();
+        else if (a == "--threshold") thresholds.push_back(std::atof(next()));
+        else { std::fprintf(stderr, "unknown option: %s\n", a.c_str()); return 2; }
+    }
+    if (thresholds.empty()) thresholds = { 0.5, 0.7, 0.8, 0.9, 0.95 };
+
+    const std::vector<Row> rows = load_corpus(corpus);
+    if (rows.empty()) { std::fprintf(stderr, "no labeled rows in %s\n", corpus.c_str()); return 2; }
+
+    int wrong = 0;
+    std::printf("{\"rows\":%zu,\"thresholds\":[", rows.size());
+    for (size_t k = 0; k < thresholds.size(); ++k) {
+        AppUtils::ToneClassifier tone;
+        tone.SetThreshold(thresholds[k]);
+        int polite = 0, polite_short = 0, impolite = 0, impolite_short = 0;
+        for (const Row& r : rows) {
+            const bool hit = tone.ShortCircuit(r.focus);
+            if (r.polite) { ++polite; polite_short += hit; continue; }
+            ++impolite;
+            if (!hit) continue;
+            ++impolite_short;
+            ++wrong;
+            const AppUtils::ToneClassifier::Verdict v = AppUtils::ToneClassifier::Score(r.focus);
+            std::fprintf(stderr, "ToneEval: impolite row short-circuited at %.2f (p=%.3f): %s\n",
+                thresholds[k], v.p_polite, r.focus.c_str());
+        }
+        std::printf("%s{\"threshold\":%.2f,\"polite\":%d,\"polite_short\":%d,\"impolite\":%d,\"impolite_short\":%d}",
+            k ? "," : "", thresholds[k], polite, polite_short, impolite, impolite_short);
+    }
+    std::printf("]}\n");
+    return wrong ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+// ---------------------------------------------------------------------
+// Copyright ...
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+// PaperClipNative C ABI 타입 (v2). 함수 선언 없이 타입만 있어 DLL을 동적으로 여는
+// 호스트도 포함할 수 있습니다. 함수는 PaperClipNative.h.
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// polite_rewrite_abi_version()이 돌려주는 값. 구조체에 필드가 늘면 올라가며,
+// 호출자는 struct_size로 자기가 아는 크기를 알립니다 (라이브러리는 아는 필드만 읽고 씀).
+#define PR_ABI_VERSION 2
+
+// 스트리밍 콜백: index 0 = "polite"/"impolite", 1.. = 대안 문장 (unescape된 UTF-8).
+// 호출 스레드에서 동기적으로 실행되며 element 포인터는 콜백 동안만 유효.
+typedef void (*pr_element_cb)(int index, const char* element_utf8, void* user);
+
+// 캐스케이드 플래그 (generate_polite_rewrite_cascade, pr_request.flags)
+#define PR_CASCADE_ALTERNATIVES 1 // 사용자가 대안을 직접 요청 — fast path·판정 조기 종료 없이 전체 답
+#define PR_CASCADE_PEEK         2 // 모델 없이(fast path·캐시) 답할 수 있을 때만
+
+#define PR_MAX_ALTERNATIVES 3
+
+typedef enum pr_status {
+  PR_OK           = 0,
+  PR_NEED_MODEL   = 1,  // PR_CASCADE_PEEK인데 모델이 필요함 (오류 아님)
+  PR_CANCELLED    = 2,  // polite_rewrite_abort 또는 경로 변경으로 중단
+  PR_DEADLINE     = 3,  // deadline_ms 초과
+  PR_ERR_ARGS     = 10, // 잘못된 요청 (NULL, struct_size 부족, target 없음)
+  PR_ERR_INIT     = 11, // 설정/모델 로드 실패 (message에 사유)
+  PR_ERR_QUERY    = 12, // 백엔드 생성 실패
+  PR_ERR_EMPTY    = 13, // 모델이 아무것도 내지 않음
+  PR_ERR_INTERNAL = 14
+} pr_status;
+
+// 답한 단계
+typedef enum pr_tier {
+  PR_TIER_NONE     = -1,
+  PR_TIER_FASTPATH = 0,  // 경량 톤 분류기
+  PR_TIER_CACHE    = 1,  // 결과 캐시
+  PR_TIER_VERDICT  = 2,  // 톤 판정만 (대안 디코딩 없음)
+  PR_TIER_REWRITE  = 3   // 메인 모델이 대안까지 생성
+} pr_tier;
+
+// 결과 버퍼 안의 UTF-8 문자열 (NUL 종료, len은 NUL 제외). 비어 있으면 ptr = NULL, len = 0.
+typedef struct pr_span {
+  const char* ptr;
+  uint32_t    len;
+} pr_span;
+
+typedef struct pr_request {
+  uint32_t      struct_size;      // sizeof(pr_request)
+  const char*   target;           // 다듬을 문장 (UTF-8, 필수)
+  const char*   context;          // 앞 문장들 (NULL 가능)
+  const char*   session;          // 작성창 식별자, 예: "tabId:frameId" (NULL 가능)
+  const char*   language;         // 답 언어 "ko"/"en"/"ja"/... (NULL = Target에서 추정)
+  uint32_t      flags;            // PR_CASCADE_*
+  uint32_t      max_alternatives; // 1..PR_MAX_ALTERNATIVES, 0 = 전부. 다 모이면 디코딩을 멈춤
+  uint32_t      max_tokens;       // 디코딩 상한, 0 = Target 길이로 정한 예산
+  uint32_t      deadline_ms;      // 이 호출의 마감, 0 = 없음
+  pr_element_cb on_element;       // 원소가 닫힐 때마다 (NULL 가능)
+  void*         user;
+} pr_request;
+
+typedef struct pr_result {
+  uint32_t struct_size;           // sizeof(pr_result) — 호출자가 채움
+  int32_t  status;                // pr_status
+  int32_t  tier;                  // pr_tier
+  uint32_t truncated;             // 1 = 토큰 예산에 걸려 배열이 닫히기 전에 멈춤 (완성된 원소만)
+  pr_span  verdict;               // "polite" / "impolite" (판정을 못 얻었으면 빈 span)
+  uint32_t n_alternatives;
+  pr_span  alternatives[PR_MAX_ALTERNATIVES];
+  pr_span  message;               // status != PR_OK: 사유, PR_OK인데 배열이 없으면 모델 원문
+  pr_span  stage;                 // 실패한 단계 (진단용)
+  // 시간 (µs): 전체, 인스턴스 대기, prefill(생성 호출 → 첫 토큰), 첫 토큰(호출 시작 기준), 디코딩
+  uint32_t total_us, wait_us, prefill_us, first_token_us, decode_us;
+  uint32_t tokens;                // 디코딩한 토큰 수
+  uint32_t bytes;                 // span들이 차지한 바이트 (다음 호출의 버퍼 크기 힌트)
+  void*    arena;                 // 라이브러리가 할당한 span 저장소 (NULL = 호출자 버퍼) — polite_rewrite_result_free
+} pr_result;
+
+// polite_rewrite_batch의 문장 하나 (UTF-8, NUL 종료 불필요)
+typedef struct pr_batch_item {
+  pr_span target;                 // 다듬을 문장
+  pr_span context;                // 앞 문장들 (비어 있어도 됨)
+} pr_batch_item;
+
+// 배치의 문장 하나가 끝날 때마다. result와 그 span은 콜백 동안만 유효.
+typedef void (*pr_batch_cb)(uint32_t index, const pr_result* result, void* user);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
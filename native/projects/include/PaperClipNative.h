@@ -4,6 +4,7 @@
 // ---------------------------------------------------------------------
 #pragma once
 #include <stdint.h>
+#include "PaperClipAbi.h"
 
 #ifdef _WIN32
   #define PR_API __declspec(dllexport)
@@ -18,21 +19,199 @@ extern "C" {
 // 단일 호출 API:
 // - input_utf8: 입력 문장(UTF-8)
 // - 반환: 힙에 할당된 UTF-8 문자열 포인터. 사용 후 반드시 polite_rewrite_free()로 해제.
+// - 성공 시 JSON 배열 ["polite"|"impolite", 대안1, 대안2, 대안3]. 배열이 닫히면 즉시 디코딩을 멈추고,
+//   Target 길이에 비례한 토큰 예산을 넘으면 완성된 원소만 모아
+//   {"suggestions":[...],"truncated":true}로 반환합니다.
+// - 캐스케이드(설정 "cascade", 아래 generate_polite_rewrite_cascade 참고)가 기본으로 켜져 있어
+//   "polite" 판정이면 대안을 디코딩하지 않고 ["polite"]만 반환합니다.
 PR_API const char* generate_polite_rewrite(const char* input_utf8);
 
+// 스트리밍 API: generate_polite_rewrite와 같지만, 모델 출력의 JSON 배열 원소가
+// 닫힐 때마다 on_element(index, element_utf8, user)를 호출합니다.
+// - index 0 = "polite"/"impolite", 1.. = 대안 문장 (이미 unescape된 UTF-8)
+// - 콜백은 호출 스레드에서 동기적으로 실행되며, element 포인터는 콜백 동안만 유효.
+// - 반환값은 generate_polite_rewrite와 동일 (전체 원문, polite_rewrite_free로 해제).
+// (pr_element_cb는 PaperClipAbi.h)
+PR_API const char* generate_polite_rewrite_stream(const char* input_utf8,
+                                                  pr_element_cb on_element, void* user);
+
+// 작성 중인 메일의 앞 문장(context)과 작성창 식별자(session_utf8, 예: "tabId:frameId")를 함께 전달.
+// DLL은 세션별로 이미 prefill한 context의 KV를 유지하고, 지난 요청 이후 추가된 문장만 prefill합니다.
+// 여러 작성창은 LRU 스냅샷으로 풀의 인스턴스를 공유합니다. context/session/on_element는 NULL 가능.
+// 결과 캐시 키에는 실제로 프롬프트에 들어가는 context 창이 들어갑니다: 창 안의 앞 문장이 다르면 따로 답하고,
+// 창이 context를 담지 못하는 모델(창 0바이트)에서는 같은 Target이면 context와 무관하게 한 답을 공유합니다.
+PR_API const char* generate_polite_rewrite_ctx(const char* target_utf8, const char* context_utf8,
+                                               const char* session_utf8,
+                                               pr_element_cb on_element, void* user);
+
+// 모델 없이 답할 수 있을 때만 답함: fast path 판정 또는 결과 캐시 적중이면 generate_polite_rewrite와
+// 같은 결과(on_element도 동일), 모델이 필요하면 NULL. 초기화/모델 로딩을 기다리지 않습니다.
+PR_API const char* generate_polite_rewrite_peek(const char* target_utf8,
+                                                pr_element_cb on_element, void* user);
+
+// 2단 캐스케이드: 톤 판정(배열 0번)으로 답이 끝나면 대안 문장은 디코딩하지 않습니다.
+// 설정 최상위 "cascade": {"escalate": "impolite"|"always"|"never", "verdict-config": "<파일>"}
+// - escalate "impolite"(기본): "polite"이면 판정에서 멈춤, "impolite"나 알 수 없는 판정은 대안까지 생성
+//   "always": 항상 대안까지 (캐스케이드 끔), "never": 판정만 (대안은 PR_CASCADE_ALTERNATIVES일 때만)
+// - verdict-config: 판정용 작은 모델의 백엔드 설정 (메인 설정 폴더 기준). 있으면 작은 모델이 같은 프롬프트로
+//   판정만 내고, 대안이 필요할 때만 메인 모델을 깨웁니다. 없으면 메인 모델이 판정 후 멈춥니다.
+//   (0.5B 예시: runtime/genie_config_verdict.json)
+// flags (PaperClipAbi.h): PR_CASCADE_ALTERNATIVES = 사용자가 대안을 직접 요청 (fast path·조기 종료 없이 전체 답),
+//        PR_CASCADE_PEEK = generate_polite_rewrite_peek처럼 모델 없이 답할 수 있을 때만 (아니면 NULL).
+// 반환: {"suggestions":[...],"tier":"fastpath"|"cache"|"verdict"|"rewrite","truncated":true?}
+//       tier: 답한 단계 — verdict = 판정만(작은 모델 또는 메인 모델이 판정에서 멈춤), rewrite = 대안 생성.
+//       오류·중단은 다른 API와 같은 {"error",...} 객체.
+PR_API const char* generate_polite_rewrite_cascade(const char* target_utf8, const char* context_utf8,
+                                                   const char* session_utf8, int flags,
+                                                   pr_element_cb on_element, void* user);
+
+// ── v2 구조화 ABI (PaperClipAbi.h) ──
+// 요청 구조체를 받아 결과 구조체를 채웁니다. 판정과 대안은 이미 파싱되어 UTF-8 span으로 들어오고,
+// 오류는 JSON 문자열 대신 status 코드(+ message/stage span)입니다. 반환값 = out->status.
+// - buf/buf_size: span을 담을 호출자 버퍼. NULL이거나 모자라면 라이브러리가 할당하고 out->arena에 둡니다.
+//   어느 쪽이든 결과를 다 쓴 뒤 polite_rewrite_result_free(out)를 호출하세요 (호출자 버퍼면 아무 일도 안 함).
+// - req->deadline_ms는 이 호출에만 적용 (polite_rewrite_set_deadline_ms와 무관).
+// - 캐스케이드·캐시·세션·스트리밍 동작은 generate_polite_rewrite_cascade와 같습니다.
+PR_API int polite_rewrite_v2(const pr_request* req, pr_result* out, char* buf, uint32_t buf_size);
+PR_API void polite_rewrite_result_free(pr_result* out);
+
+// 여러 문장을 한 번에 (문서 전체 검사). 메인 모델 인스턴스 하나를 첫 사용 때 임대해 끝까지 쥐고 있어
+// 시스템 prefix와 세션 KV를 문장 사이에 그대로 이어 씁니다 (문장마다 임대·세션 전환 없음).
+// - common: session/language/flags/max_alternatives/max_tokens/deadline_ms를 모든 문장에 적용.
+//   target/context/on_element는 무시 (문장별 target/context는 items, 결과는 on_result).
+//   deadline_ms는 배치 전체의 마감입니다.
+// - on_result(i, result, user): items[i]가 끝날 때마다 호출 스레드에서 동기 호출. result의 span은
+//   콜백 동안만 유효 (free 불필요).
+// - 반환: 모두 돌았으면 PR_OK (문장별 실패는 각 result->status), 중단/마감이면 PR_CANCELLED /
+//   PR_DEADLINE (남은 문장은 콜백 없음), 인자 오류면 PR_ERR_ARGS.
+PR_API int polite_rewrite_batch(const pr_request* common, const pr_batch_item* items, uint32_t n_items,
+                                pr_batch_cb on_result, void* user);
+
+// 추측 prefill: 작성 중인(아직 끝나지 않은) 문장을 req->target으로 넘기면 system 블록 + context + 그 문장까지를
+// 완성된 문장의 질의가 임대할 인스턴스(같은 session)의 KV에 미리 올려 둡니다. 디코딩·결과 없음.
+// 완성된 문장이 같은 앞부분으로 오면 그 질의는 뒷부분만 prefill합니다 (마지막 단어는 바뀌기 쉬워 빼고 올림).
+// 로드를 시작하거나 기다리지 않고, 쉬는 인스턴스가 없으면 건너뜁니다. polite_rewrite_abort로 취소됩니다.
+// 반환: PR_OK = prefill함, PR_NEED_MODEL = 건너뜀(모델 미로드·인스턴스 사용 중·이미 올라 있음),
+//       PR_CANCELLED / PR_DEADLINE, PR_ERR_QUERY (백엔드가 지원하지 않거나 실패), PR_ERR_ARGS.
+PR_API int polite_rewrite_prefill_hint(const pr_request* req);
+
+// 힌트 카운터(JSON): hints, prefilled, skipped, cancelled, prefill_bytes, prefill_ms(힌트 자체의 prefill),
+// followed(힌트가 남은 KV에서 돈 질의), hits(그중 Target까지 재사용), hit_rate, saved_bytes,
+// saved_ms(질의가 다시 하지 않은 힌트 prefill 시간), prefill_ms_avg_hit / prefill_ms_avg_cold
+// (적중 질의와 힌트 없던 질의의 첫 원소까지 시간 평균). polite_rewrite_free()로 해제.
+PR_API const char* polite_rewrite_hint_stats(void);
+
+// PR_ABI_VERSION (이 헤더로 빌드된 라이브러리가 지원하는 가장 높은 ABI). 없는 DLL은 v1만 지원.
+PR_API uint32_t polite_rewrite_abi_version(void);
+
+// 진행 중인 생성을 모두 중단합니다(다른 스레드에서 호출). 중단된 호출은
+// {"error":"cancelled","stage":"aborted",...}를 반환합니다. 프로세스의 모든 호출이 대상이므로
+// 여러 요청을 동시에 돌리는 호출자는 중단할 요청이 아직 실행 중인지 스스로 확인해야 합니다 (호스트는 한 번에 하나).
+// 반환: 0 = 중단 신호 전달, 1 = 진행 중인 생성 없음
+PR_API int polite_rewrite_abort(void);
+
+// 이후 생성 호출의 마감 시간(ms). 초과 시 DLL이 스스로 중단하고
+// {"error":"deadline","stage":"aborted",...}를 반환합니다. 0 = 제한 없음.
+PR_API void polite_rewrite_set_deadline_ms(uint32_t ms);
+
+// 결과 캐시 카운터(JSON): mem_hits, disk_hits, misses, joined(single-flight), stores,
+// evictions, hit_rate 등. polite_rewrite_free()로 해제.
+PR_API const char* polite_rewrite_cache_stats(void);
+
+// 세션 context 재사용 카운터(JSON): requests, reused_bytes, prefill_bytes, reuse_ratio,
+// switches, saves, restores, evictions, prefix_switches(KV에 없던 언어의 system 블록),
+// prefix_restores(그중 블록 스냅샷으로 복원). polite_rewrite_free()로 해제.
+PR_API const char* polite_rewrite_session_stats(void);
+
+// 인스턴스 풀 카운터(JSON): size, leased, peak, acquires, affinity_hits(같은 작성창의 KV를 가진
+// 인스턴스를 받음), waits, wait_ms_avg, wait_ms_max. polite_rewrite_free()로 해제.
+PR_API const char* polite_rewrite_pool_stats(void);
+
+// 디코딩 카운터(JSON, 로드 이후 모든 인스턴스 합): speculative, queries, tokens, tokens_per_s(첫 토큰 이후
+// 실효 디코딩 속도), drafted, accepted, acceptance(= accepted / drafted), passes(target forward),
+// tokens_per_pass. 추측 디코딩은 genie 설정의 dialog "type": "spd"(draft/target 두 엔진) 또는
+// cpu 옵션 "draft": "<작은 GGUF>"로 켭니다. genie는 수락률을 알려 주지 않아 drafted/passes가 0.
+PR_API const char* polite_rewrite_decode_stats(void);
+
+// 캐스케이드 카운터(JSON): escalate, verdict_model, 단계별 답 수(fastpath, cache, verdict, rewrite),
+// small_verdicts(작은 모델 판정), small_escalations(그중 메인 모델로 넘긴 수),
+// early_exit_rate(= verdict / (verdict + rewrite)). polite_rewrite_free()로 해제.
+PR_API const char* polite_rewrite_cascade_stats(void);
+
+// 경량 톤 분류기(fast path) 임계값. 정중할 확률이 이 값 이상이고 정중 신호가 둘 이상,
+// 무례·재촉 신호가 없으면 LLM 없이 ["polite"]를 반환 (bench/ToneEval로 검사).
+// 기본 0.90, 낮출수록 NPU 시간 절약(정확도↓), 1.0 이상이면 비활성화.
+PR_API void polite_rewrite_set_fastpath_threshold(double threshold);
+
+// fast path 카운터(JSON): checked, short_circuited, short_circuit_rate, threshold, mean_us.
+PR_API const char* polite_rewrite_fastpath_stats(void);
+
+// 단계별 지연 히스토그램(JSON): {"init"|"prefix"|"prompt"|"prefill"|"first_token"|"decode"|"decode_tps"|"total":
+//   {"n","mean","p50","p90","p99","max"}}. 단위는 µs (decode_tps만 토큰/초). 잠금 없이 어느 스레드에서든 호출 가능.
+PR_API const char* polite_rewrite_stage_stats(void);
+
 // 반환 문자열 해제 함수
 PR_API void polite_rewrite_free(const char* str);
 
 // (선택) 초기화가 먼저 필요한 경우를 위해 경로를 강제 지정하고 싶다면 아래 2개를 먼저 호출할 수 있습니다.
 // 경로는 UTF-8, 존재해야 함.
 // 지정하지 않으면 DLL 위치 기준으로 assets의 genie_config.json / genie_bundle을 자동 탐색합니다.
+// 추론 백엔드는 설정 파일 최상위 "backend": {"type": "genie"|"cpu"|"mock", ...}로 고릅니다 (없으면 genie).
+// genie = QNN HTP, cpu = GGUF 모델(llama.cpp, PC_WITH_LLAMA 빌드), mock = 설정된 토큰 스트림 재생.
+// 설정 파일 옆에 PaperClipTune이 만든 engine_profiles.json이 있으면 초기화 때 현재 전원 모드
+// (ac/dc/saver)의 프로파일(n-threads, cpu-mask, use-mmap, poll 등)을 설정 위에 덮어씁니다.
+// 설정 속 상대 경로(tokenizer, ctx-bins, extensions, cpu model)는 로드 때 base_dir 기준 절대 경로로
+// 바뀌므로 DLL은 프로세스 CWD를 바꾸지 않습니다.
+// 최상위 "pool": {"size": N} (기본 1, 최대 8)이면 인스턴스를 N개까지 로드해 동시 호출을 병렬로 처리합니다.
+// 인스턴스를 하나 더 올린 뒤에도 RAM의 1/4이 남을 때만 늘립니다. 모든 export는 스레드 안전합니다.
+// 이미 로드된 뒤의 경로 변경은 polite_rewrite_reload()와 같은 무중단 재로드를 시작합니다.
 PR_API int polite_rewrite_set_base_dir(const char* base_dir_utf8);
 PR_API int polite_rewrite_set_config_path(const char* config_path_utf8);
 
+// 무중단 재로드: 현재 경로의 모델·설정을 백그라운드 스레드에서 로드하고 system 블록까지 준비하는
+// 동안 기존 인스턴스가 계속 응답하고, 끝나면 한 번에 교체합니다. 이미 진행 중인 요청은 기존
+// 인스턴스에서 끝나고, 각 인스턴스는 마지막 요청이 돌아올 때 해제됩니다 (RCU 방식).
+// 로드가 실패하면 기존 인스턴스가 그대로 남습니다. 로드 중에 들어온 요청은 하나로 합쳐집니다.
+// 0 = 시작(또는 대기), 1 = 아직 로드 전(다음 질의가 새 경로로 로드), -1 = 오류.
+PR_API int polite_rewrite_reload(void);
+
+// {"generation":n,"state":"idle"|"loading","reloads":n,"failures":n,"discarded":n,"retiring":n,
+//  "last":{"generation":n,"ok":bool,"load_ms":n,"from":n,"swap_us":n,"swapped_at_ms":<unix ms>,
+//          "in_flight":n,"drained_ms":n|null,"error":"..."?}|null}
+// load_ms = 백그라운드 로드, swap_us = 교체에 g_mu를 잡은 시간, in_flight = 교체 시점에 기존
+// 인스턴스에서 실행 중이던 요청 수, drained_ms = 교체부터 기존 인스턴스가 모두 해제될 때까지.
+PR_API const char* polite_rewrite_reload_stats(void);
+
 
-//웜업 함수
+//웜업 함수: 결과 캐시를 먼저 연 뒤 모델을 로드.
+// 성공 시 {"ok":true,"stage":"warmup","backend":"<종류>","profile":"<적용한 프로파일 또는 빈 문자열>",
+//          "prefix":"snapshot"|"prefill"|"none","prefetched_mb":n,"pool":n,"prompt_variants":n,
+//          "context_bytes":{"<변형>":n,...},"speculative":true?,"cascade":"<escalate>","verdict_model":"<작은 모델 백엔드>"?}
+// (context_bytes = system 블록 변형별로 프롬프트에 넣는 compose 문맥 상한. 컨텍스트 창이 작아 0인 변형이
+//  있으면 "context_note":"<사유>",
+//  프로파일 파일이 있는데 쓰지 못했으면 "profile_skipped":"<사유>",
+//  풀이 요청보다 작으면 "pool_note":"<사유>", 판정 모델을 못 올렸으면 "verdict_note":"<사유>" 추가)
+// 로딩 동안 ctx-bins(cpu는 GGUF)를 별도 스레드가 순차로 미리 읽고, 시스템 프롬프트는
+// polite_rewrite_bake_prefix()가 남긴 스냅샷이 맞으면 prefill 대신 복원합니다.
+// 시스템 프롬프트는 Target 언어별 compact 블록(ko/ja/en)과 그 밖의 언어용 통합 블록이 따로
+// 상주하며, 다른 언어 질의는 그 블록의 스냅샷을 복원합니다 (설정 "prompt": {"per-language": false}면 통합 블록 하나).
+// 호스트는 시작 직후 백그라운드 스레드에서 호출합니다 (로딩 중에도 peek/통계 export는 바로 응답).
 PR_API const char* polite_rewrite_warmup();
 
+// 설치 시 1회: 모델을 로드하고 시스템 프롬프트까지 prefill한 상태를 설정 파일 옆 prefix_snapshot/에 저장.
+// backend·모델(설정+번들 파일 스탬프)·프롬프트 해시로 태그되어, 하나라도 바뀌면 init은 스냅샷을 무시합니다.
+// system 블록 변형(언어별 compact 블록 + 통합 블록)마다 하위 디렉터리 하나.
+// 성공 시 {"ok":true,"stage":"bake","dir":"...","variants":n,"prefill_ms":n,"bytes":n}
+PR_API const char* polite_rewrite_bake_prefix();
+
+// 벤치마크: system 블록 변형마다 runs번(0 = 5) Reset 후 prefill과 스냅샷 복원을 재서
+// 통합 블록("all")과 비교. 설정의 "prompt": {"per-language"}와 상관없이 모든 변형을 잽니다.
+// 성공 시 {"ok":true,"stage":"prompt_bench","backend":"...","runs":n,"per_language":bool,
+//          "variants":[{"variant":"all"|"en"|"ja"|"ko","bytes":n,"tokens":n|null,"prefill_ms":p50,
+//          "prefill_ms_min":n,"restore_ms":p50?,"restore_ms_min":n?,"vs_all":{"bytes","tokens","prefill"}}]}
+// tokens는 토크나이저를 노출하는 백엔드(cpu)만. 끝나면 인스턴스 KV는 마지막 변형의 블록.
+PR_API const char* polite_rewrite_prompt_bench(uint32_t runs);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
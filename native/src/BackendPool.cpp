@@ -0,0 +1,201 @@
+#include "BackendPool.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace AppUtils {
+
+    BackendPool::Lease& BackendPool::Lease::operator=(Lease&& o) noexcept {
+        if (this != &o) {
+            Release();
+            m_pool = o.m_pool; m_slot = o.m_slot;
+            o.m_pool = nullptr; o.m_slot = nullptr;
+        }
+        return *this;
+    }
+
+    void BackendPool::Lease::Release() {
+        if (m_pool && m_slot) m_pool->Return(m_slot);
+        m_pool = nullptr;
+        m_slot = nullptr;
+    }
+
+    void BackendPool::Open(std::vector<std::unique_ptr<Slot>> slots) {
+        Close();
+        std::lock_guard<std::mutex> lk(m_mu);
+        m_slots = std::move(slots);
+        for (size_t i = 0; i < m_slots.size(); ++i) m_slots[i]->index = i;
+        m_idle_since.assign(m_slots.size(), 0);
+        for (uint64_t& t : m_idle_since) t = ++m_clock;
+        m_leased = 0;
+        m_open = !m_slots.empty();
+    }
+
+    void BackendPool::Close(const std::function<void(Slot&)>& on_busy) {
+        std::vector<std::unique_ptr<Slot>> dead;
+        {
+            std::unique_lock<std::mutex> lk(m_mu);
+            m_open = false;
+            m_cv.notify_all(); // Acquire 대기자는 빈 Lease로 돌아감
+            if (on_busy) {
+                for (size_t i = 0; i < m_slots.size(); ++i)
+                    if (!m_idle_since[i]) on_busy(*m_slots[i]);
+                for (Retired& r : m_retired)
+                    for (size_t i = 0; i < r.slots.size(); ++i)
+                        if (r.leased[i]) on_busy(*r.slots[i]);
+            }
+            m_cv.wait(lk, [this] { return m_leased == 0 && m_retired.empty(); });
+            dead.swap(m_slots);
+            m_idle_since.clear();
+        }
+        // 인스턴스 해제(모델 언로드)는 잠금 밖에서
+    }
+
+    size_t BackendPool::Swap(std::vector<std::unique_ptr<Slot>> slots, std::function<void()> on_retired) {
+        Retired old;
+        std::vector<std::unique_ptr<Slot>> idle; // 쉬던 옛 인스턴스는 기다릴 것 없이 바로 해제
+        size_t in_flight = 0;
+        {
+            std::lock_guard<std::mutex> lk(m_mu);
+            old.slots.swap(m_slots);
+            old.leased.resize(old.slots.size());
+            for (size_t i = 0; i < old.slots.size(); ++i) {
+                old.leased[i] = !m_idle_since[i];
+                if (old.leased[i]) ++in_flight;
+                else idle.push_back(std::move(old.slots[i]));
+            }
+            old.outstanding = in_flight;
+            old.on_retired = std::move(on_retired);
+
+            m_slots = std::move(slots);
+            for (size_t i = 0; i < m_slots.size(); ++i) m_slots[i]->index = i;
+            m_idle_since.assign(m_slots.size(), 0);
+            for (uint64_t& t : m_idle_since) t = ++m_clock;
+            m_leased = 0;
+            m_open = !m_slots.empty();
+            if (in_flight) m_retired.push_back(std::move(old));
+        }
+        m_cv.notify_all(); // 옛 인스턴스를 기다리던 Acquire는 새 인스턴스로
+        idle.clear();      // 잠금 밖에서 해제
+        if (!in_flight && old.on_retired) old.on_retired();
+        return in_flight;
+    }
+
+    BackendPool::Lease BackendPool::Acquire(const std::string& session, bool wait) {
+        using Clock = std::chrono::steady_clock;
+        std::unique_lock<std::mutex> lk(m_mu);
+        const Clock::time_point t0 = Clock::now();
+        bool waited = false;
+        size_t pick = 0;
+        for (;;) {
+            if (!m_open) return Lease();
+            int best_rank = -1;
+            for (size_t i = 0; i < m_slots.size(); ++i) {
+                if (!m_idle_since[i]) continue;
+                const Slot& s = *m_slots[i];
+                const int rank = (!session.empty() && s.kv_session == session) ? 2 : s.kv_session.empty() ? 1 : 0;
+                if (rank > best_rank || (rank == best_rank && m_idle_since[i] < m_idle_since[pick])) {
+                    best_rank = rank;
+                    pick = i;
+                }
+            }
+            if (best_rank >= 0) {
+                if (best_rank == 2) ++m_affinity;
+                break;
+            }
+            if (!wait) return Lease();
+            waited = true;
+            m_cv.wait(lk);
+        }
+
+        m_idle_since[pick] = 0;
+        ++m_leased;
+        ++m_acquires;
+        if (m_leased > m_peak.load()) m_peak = m_leased;
+        if (waited) {
+            const uint64_t us = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count());
+            ++m_waits;
+            m_wait_us += us;
+            if (us > m_wait_us_max.load()) m_wait_us_max = us;
+        }
+        return Lease(this, m_slots[pick].get());
+    }
+
+    void BackendPool::Return(Slot* slot) {
+        std::unique_ptr<Slot> dead;
+        std::function<void()> on_retired;
+        {
+            std::lock_guard<std::mutex> lk(m_mu);
+            if (slot->index < m_slots.size() && m_slots[slot->index].get() == slot) {
+                m_idle_since[slot->index] = ++m_clock;
+                --m_leased;
+            }
+            else {
+                for (auto it = m_retired.begin(); it != m_retired.end(); ++it) {
+                    if (slot->index >= it->slots.size() || it->slots[slot->index].get() != slot) continue;
+                    it->leased[slot->index] = false;
+                    dead = std::move(it->slots[slot->index]);
+                    if (--it->outstanding == 0) {
+                        on_retired = std::move(it->on_retired);
+                        m_retired.erase(it);
+                    }
+                    break;
+                }
+            }
+        }
+        m_cv.notify_all();
+        dead.reset(); // 물러난 인스턴스: 잠금 밖에서 해제
+        if (on_retired) on_retired();
+    }
+
+    size_t BackendPool::ForEachLeased(const std::function<void(Slot&)>& fn) {
+        std::lock_guard<std::mutex> lk(m_mu);
+        size_t n = 0;
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_idle_since[i]) continue;
+            fn(*m_slots[i]);
+            ++n;
+        }
+        for (Retired& r : m_retired) {
+            for (size_t i = 0; i < r.slots.size(); ++i) {
+                if (!r.leased[i]) continue;
+                fn(*r.slots[i]);
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    size_t BackendPool::Size() const {
+        std::lock_guard<std::mutex> lk(m_mu);
+        return m_slots.size();
+    }
+
+    size_t BackendPool::Retiring() const {
+        std::lock_guard<std::mutex> lk(m_mu);
+        size_t n = 0;
+        for (const Retired& r : m_retired) n += r.outstanding;
+        return n;
+    }
+
+    std::string BackendPool::StatsJson() const {
+        size_t size = 0, leased = 0;
+        {
+            std::lock_guard<std::mutex> lk(m_mu);
+            size = m_slots.size();
+            leased = m_leased;
+        }
+        const uint64_t waits = m_waits.load();
+        char buf[320];
+        std::snprintf(buf, sizeof(buf),
+            "{\"size\":%llu,\"leased\":%llu,\"peak\":%llu,\"acquires\":%llu,\"affinity_hits\":%llu,"
+            "\"waits\":%llu,\"wait_ms_avg\":%.1f,\"wait_ms_max\":%.1f}",
+            (unsigned long long)size, (unsigned long long)leased, (unsigned long long)m_peak.load(),
+            (unsigned long long)m_acquires.load(), (unsigned long long)m_affinity.load(),
+            (unsigned long long)waits, waits ? m_wait_us.load() / 1000.0 / waits : 0.0,
+            m_wait_us_max.load() / 1000.0);
+        return buf;
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "InferenceBackend.hpp"
+
+namespace AppUtils {
+
+// 로드된 InferenceBackend 인스턴스 N개의 풀. 질의는 인스턴스 하나를 임대(Lease)해 혼자 쓰고,
+// Lease가 소멸하면 반납됩니다. 메모리가 허락하면 여러 작성창/브라우저의 질의가 병렬로 돕니다.
+// 스레드: 모든 메서드는 어디서든 호출 가능. Slot 내용은 임대한 스레드만 만집니다
+// (active/abort_reason은 예외 — 다른 스레드가 중단 신호를 보냄).
+class BackendPool {
+public:
+  struct Slot {
+    std::unique_ptr<InferenceBackend> backend;
+    size_t           index = 0;
+    uint64_t         generation = 0;        // 어느 로드의 인스턴스인가 (호출자가 정함, 교체 뒤 옛 것을 가려냄)
+    bool             prefix_primed = false; // 시스템 prefix가 KV에 상주
+    std::string      kv_session;            // KV가 담고 있는 작성창 ("" = 없음)
+    std::string      kv_text;               // KV가 현재 시작하는 프롬프트 원문
+    std::map<std::string, std::string> prefix_dirs; // system prefix 변형 → 그 prefix만 담은 KV 스냅샷
+    // kv_text가 입력 중 문장의 추측 prefill로 채워졌을 때 (다음 질의가 얼마나 이어 썼는지 재는 용도)
+    size_t           hint_len = 0;          // 그때의 kv_text 길이 (0 = 힌트 아님)
+    size_t           hint_mark = 0;         // kv_text 속 Target 시작
+    size_t           hint_base = 0;         // 힌트들이 prefill을 시작한 위치 (그 앞은 이미 KV에 있었음)
+    uint64_t         hint_us = 0;           // 힌트 prefill에 든 시간 (연달은 힌트는 합산)
+    std::atomic<bool> active{ false };      // Generate 진행 중
+    std::atomic<int> abort_reason{ 0 };     // 진행 중 질의의 중단 사유 (값의 의미는 호출자가 정함)
+  };
+
+  class Lease {
+  public:
+    Lease() = default;
+    Lease(Lease&& o) noexcept : m_pool(o.m_pool), m_slot(o.m_slot) { o.m_pool = nullptr; o.m_slot = nullptr; }
+    Lease& operator=(Lease&& o) noexcept;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    ~Lease() { Release(); }
+
+    explicit operator bool() const { return m_slot != nullptr; }
+    Slot* operator->() const { return m_slot; }
+    Slot& operator*() const { return *m_slot; }
+    void Release();
+
+  private:
+    friend class BackendPool;
+    Lease(BackendPool* pool, Slot* slot) : m_pool(pool), m_slot(slot) {}
+    BackendPool* m_pool = nullptr;
+    Slot*        m_slot = nullptr;
+  };
+
+  BackendPool() = default;
+  BackendPool(const BackendPool&) = delete;
+  BackendPool& operator=(const BackendPool&) = delete;
+  ~BackendPool() { Close(); }
+
+  // 로드가 끝난 인스턴스들로 풀을 엶 (열려 있던 풀은 먼저 Close)
+  void Open(std::vector<std::unique_ptr<Slot>> slots);
+
+  // RCU식 교체: 이후 임대는 바로 새 slots에서 나가고, 나가 있는 임대는 옛 인스턴스에서 끝까지 돕니다.
+  // 옛 인스턴스는 그 임대가 돌아오면(쉬고 있었으면 즉시) 잠금 밖에서 해제되고, 마지막 것 뒤에 on_retired를 부름.
+  // 반환값: 교체 시점에 옛 인스턴스를 임대 중이던 수. slots가 비면 풀은 닫힌 것과 같음 (Acquire는 빈 Lease).
+  size_t Swap(std::vector<std::unique_ptr<Slot>> slots, std::function<void()> on_retired = nullptr);
+
+  // 새 임대를 막고 나가 있는 임대가 모두 돌아올 때까지 기다린 뒤 인스턴스를 해제 (교체로 물러난 것 포함).
+  // on_busy: 기다리기 전에 임대 중인 슬롯마다 호출 (중단 신호용, 풀 잠금 아래)
+  void Close(const std::function<void(Slot&)>& on_busy = nullptr);
+
+  // 쉬는 인스턴스가 생길 때까지 대기. 고르는 순서: session의 KV를 가진 것 > 세션이 없는 것 >
+  // 가장 오래 쉰 것. 풀이 닫혀 있거나 대기 중에 닫히면 빈 Lease.
+  // wait=false: 쉬는 인스턴스가 없으면 기다리지 않고 빈 Lease (질의를 밀어내면 안 되는 추측 작업용)
+  Lease Acquire(const std::string& session, bool wait = true);
+
+  // 지금 임대 중인 슬롯마다 fn, 교체로 물러나는 중인 것 포함 (풀 잠금 아래 — 짧고 막히지 않는 일만).
+  // 호출 횟수를 돌려줌.
+  size_t ForEachLeased(const std::function<void(Slot&)>& fn);
+
+  size_t Size() const;
+  size_t Retiring() const; // 교체 뒤 아직 임대가 돌아오지 않은 옛 인스턴스 수
+  std::string StatsJson() const;
+
+private:
+  // Swap으로 물러난 한 세대: 임대가 모두 돌아오면 해제
+  struct Retired {
+    std::vector<std::unique_ptr<Slot>> slots; // 해제된 것은 nullptr (쉬던 것은 교체 때, 나머지는 반납 때)
+    std::vector<bool>     leased;
+    size_t                outstanding = 0;
+    std::function<void()> on_retired;
+  };
+
+  void Return(Slot* slot);
+
+  mutable std::mutex      m_mu;
+  std::condition_variable m_cv;
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  std::vector<uint64_t>   m_idle_since; // 0 = 임대 중, 아니면 반납 순번 (LRU)
+  uint64_t                m_clock = 0;
+  size_t                  m_leased = 0;
+  bool                    m_open = false;
+  std::vector<Retired>    m_retired;
+
+  std::atomic<uint64_t> m_acquires{ 0 }, m_waits{ 0 }, m_wait_us{ 0 }, m_wait_us_max{ 0 }, m_affinity{ 0 };
+  std::atomic<uint64_t> m_peak{ 0 };
+};
+
+} // namespace AppUtils
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace AppUtils {
+
+// Bounded MPMC ring (Vyukov). push/pop never take a lock; the mutex/cv pair
+// is only touched by a consumer that found the queue empty and wants to sleep.
+template <typename T, size_t Capacity>
+class BoundedQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+public:
+  BoundedQueue() {
+    for (size_t i = 0; i < Capacity; ++i) m_cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // false = full (caller decides: drop, retry, or report)
+  bool TryPush(T&& v) {
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = m_cells[pos & (Capacity - 1)];
+      const size_t seq = c.seq.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.value = std::move(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          Wake();
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(T& out) {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = m_cells[pos & (Capacity - 1)];
+      const size_t seq = c.seq.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          out = std::move(c.value);
+          c.seq.store(pos + Capacity, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Blocking push for frames that must not be lost (back-pressure on the producer)
+  void Push(T&& v) {
+    while (!TryPush(std::move(v))) std::this_thread::yield();
+  }
+
+  // Sleeps only while empty; the timeout bounds any missed wake-up.
+  void Pop(T& out) {
+    while (!TryPop(out)) {
+      std::unique_lock<std::mutex> lk(m_sleep_mu);
+      m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      if (!Empty()) { m_sleepers.fetch_sub(1); continue; }
+      m_sleep_cv.wait_for(lk, std::chrono::milliseconds(50));
+      m_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+  }
+
+  bool Empty() const {
+    const size_t pos = m_head.load(std::memory_order_acquire);
+    const size_t seq = m_cells[pos & (Capacity - 1)].seq.load(std::memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(pos + 1) < 0;
+  }
+
+private:
+  void Wake() {
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> lk(m_sleep_mu);
+      m_sleep_cv.notify_all();
+    }
+  }
+
+  Cell m_cells[Capacity];
+  alignas(64) std::atomic<size_t> m_head{ 0 };
+  alignas(64) std::atomic<size_t> m_tail{ 0 };
+  std::atomic<int>        m_sleepers{ 0 };
+  std::mutex              m_sleep_mu;
+  std::condition_variable m_sleep_cv;
+};
+
+} // namespace AppUtils
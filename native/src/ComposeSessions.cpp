@@ -0,0 +1,129 @@
+#include "ComposeSessions.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace AppUtils {
+
+    namespace {
+        constexpr size_t kAnchorBytes = 32;
+
+        std::string session_dir_name(const std::string& id) {
+            uint64_t h = 1469598103934665603ull; // FNV-1a
+            for (unsigned char c : id) { h ^= c; h *= 1099511628211ull; }
+            char buf[24];
+            std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+            return buf;
+        }
+
+        // 문장 끝(. ! ? 。 ！ ？ 줄바꿈) 직후 + 공백 건너뜀. 없으면 UTF-8 문자 경계.
+        size_t next_sentence_start(const std::string& s, size_t from) {
+            for (size_t i = from; i < s.size(); ++i) {
+                const unsigned char c = s[i];
+                size_t end = 0;
+                if (c == '.' || c == '!' || c == '?' || c == '\n') end = i + 1;
+                else if (c == 0xE3 && i + 2 < s.size() && (unsigned char)s[i + 1] == 0x80 && (unsigned char)s[i + 2] == 0x82) end = i + 3;
+                else if (c == 0xEF && i + 2 < s.size() && (unsigned char)s[i + 1] == 0xBC &&
+                    ((unsigned char)s[i + 2] == 0x81 || (unsigned char)s[i + 2] == 0x9F)) end = i + 3;
+                if (!end) continue;
+                if (end < s.size() && (unsigned char)s[end] > ' ' && c < 0x80 && c != '\n') continue; // "3.5", "e.g."
+                while (end < s.size() && (unsigned char)s[end] <= ' ') ++end;
+                if (end < s.size()) return end;
+            }
+            size_t i = from;
+            while (i < s.size() && ((unsigned char)s[i] & 0xC0) == 0x80) ++i;
+            return i;
+        }
+    }
+
+    ComposeSessions::ComposeSessions(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    void ComposeSessions::SetRoot(const std::string& dir_utf8) {
+        Clear();
+        m_root = dir_utf8;
+        std::error_code ec;
+        fs::remove_all(fs::u8path(m_root), ec); // 이전 프로세스의 스냅샷은 다른 KV 레이아웃일 수 있음
+        fs::create_directories(fs::u8path(m_root), ec);
+    }
+
+    ComposeSessions::Entry* ComposeSessions::Find(const std::string& id) {
+        for (auto& e : m_lru) if (e.id == id) return &e;
+        return nullptr;
+    }
+
+    ComposeSessions::Entry& ComposeSessions::Touch(const std::string& id) {
+        for (auto it = m_lru.begin(); it != m_lru.end(); ++it) {
+            if (it->id == id) {
+                m_lru.splice(m_lru.begin(), m_lru, it);
+                return m_lru.front();
+            }
+        }
+        Entry e;
+        e.id = id;
+        if (!m_root.empty()) e.dir = (fs::u8path(m_root) / session_dir_name(id)).u8string();
+        m_lru.push_front(std::move(e));
+        while (m_lru.size() > m_capacity) {
+            std::error_code ec;
+            if (!m_lru.back().dir.empty()) fs::remove_all(fs::u8path(m_lru.back().dir), ec);
+            m_lru.pop_back();
+            ++m_evictions;
+        }
+        return m_lru.front();
+    }
+
+    void ComposeSessions::Clear() {
+        std::error_code ec;
+        for (auto& e : m_lru) if (!e.dir.empty()) fs::remove_all(fs::u8path(e.dir), ec);
+        m_lru.clear();
+    }
+
+    std::string ComposeSessions::Window(Entry& e, const std::string& ctx, size_t max_bytes) {
+        // 창 시작 앞쪽이 바뀌었으면(삭제/편집) 처음부터 다시
+        if (e.ctx_skip > ctx.size() || ctx.compare(e.ctx_skip, e.anchor.size(), e.anchor) != 0)
+            e.ctx_skip = 0;
+        if (ctx.size() - e.ctx_skip > max_bytes) {
+            // 넘칠 때만 절반 크기로 앞당김 → 다음 몇 문장 동안은 창 시작이 고정
+            e.ctx_skip = next_sentence_start(ctx, ctx.size() - max_bytes / 2);
+        }
+        e.anchor = ctx.substr(e.ctx_skip, kAnchorBytes);
+        return ctx.substr(e.ctx_skip);
+    }
+
+    size_t ComposeSessions::CommonPrefix(const std::string& a, const std::string& b) {
+        const size_t n = a.size() < b.size() ? a.size() : b.size();
+        size_t i = 0;
+        while (i < n && a[i] == b[i]) ++i;
+        return i;
+    }
+
+    void ComposeSessions::RecordPrefill(size_t reused, size_t fresh) {
+        ++m_requests;
+        m_reused_bytes += reused;
+        m_fresh_bytes += fresh;
+    }
+
+    void ComposeSessions::RecordSwitch(bool saved, bool restored) {
+        ++m_switches;
+        if (saved) ++m_saves;
+        if (restored) ++m_restores;
+    }
+
+    std::string ComposeSessions::StatsJson() const {
+        const uint64_t reused = m_reused_bytes.load(), fresh = m_fresh_bytes.load();
+        const double ratio = (reused + fresh) ? double(reused) / double(reused + fresh) : 0.0;
+        char buf[384];
+        std::snprintf(buf, sizeof(buf),
+            "{\"requests\":%llu,\"reused_bytes\":%llu,\"prefill_bytes\":%llu,\"reuse_ratio\":%.4f,"
+            "\"switches\":%llu,\"saves\":%llu,\"restores\":%llu,\"evictions\":%llu,\"capacity\":%llu}",
+            (unsigned long long)m_requests.load(), (unsigned long long)reused,
+            (unsigned long long)fresh, ratio,
+            (unsigned long long)m_switches.load(), (unsigned long long)m_saves.load(),
+            (unsigned long long)m_restores.load(), (unsigned long long)m_evictions.load(),
+            (unsigned long long)m_capacity);
+        return buf;
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+
+namespace AppUtils {
+
+// 작성창(session)별 Context 상태. 풀의 인스턴스들을 여러 Gmail 작성창이 공유하므로
+// 인스턴스가 세션을 바꿀 때 현재 KV를 스냅샷 디렉터리에 저장하고, 대상 세션의 스냅샷을 복원합니다.
+// 스냅샷은 LRU로 최대 capacity개만 유지합니다.
+// 스레드: Touch/Find/Window/Clear는 호출자의 잠금 아래에서, 카운터(StatsJson)는 어디서든.
+class ComposeSessions {
+public:
+  struct Entry {
+    std::string id;
+    std::string dir;           // GenieDialog_save/restore 경로
+    bool        saved = false; // dir에 유효한 스냅샷이 있음
+    size_t      ctx_skip = 0;  // context 앞부분에서 잘라낸 바이트 수 (창 시작)
+    std::string anchor;        // 창 시작 부분 — 앞 문장이 편집되면 창을 다시 계산
+    std::string last_prompt;   // dir의 스냅샷이 담고 있는 프롬프트
+  };
+
+  explicit ComposeSessions(size_t capacity = 4);
+
+  // 스냅샷을 둘 디렉터리 (없으면 생성). 기존 스냅샷은 모두 버립니다.
+  void SetRoot(const std::string& dir_utf8);
+
+  // 최근 사용으로 갱신(없으면 생성). 밀려난 세션의 스냅샷은 삭제합니다.
+  Entry& Touch(const std::string& id);
+  Entry* Find(const std::string& id);
+  void Clear();
+
+  // 최대 max_bytes의 context 창. 창 시작은 넘칠 때만 문장 경계로 앞당기므로
+  // 문장이 뒤에 붙는 동안에는 이전 요청의 KV prefix가 그대로 유지됩니다.
+  static std::string Window(Entry& e, const std::string& context_utf8, size_t max_bytes);
+  static size_t CommonPrefix(const std::string& a, const std::string& b);
+
+  // prefill 계측: reused = KV에서 재사용된 바이트, fresh = 새로 prefill한 바이트
+  void RecordPrefill(size_t reused, size_t fresh);
+  void RecordSwitch(bool saved, bool restored);
+
+  std::string StatsJson() const;
+
+private:
+  size_t m_capacity;
+  std::string m_root;
+  std::list<Entry> m_lru; // front = most recent
+
+  std::atomic<uint64_t> m_requests{ 0 }, m_reused_bytes{ 0 }, m_fresh_bytes{ 0 };
+  std::atomic<uint64_t> m_switches{ 0 }, m_saves{ 0 }, m_restores{ 0 }, m_evictions{ 0 };
+};
+
+} // namespace AppUtils
@@ -0,0 +1,340 @@
+#include "InferenceBackend.hpp"
+
+#ifdef PC_WITH_LLAMA
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "llama.h"
+#include "Json.hpp"
+
+namespace fs = std::filesystem;
+
+namespace AppUtils {
+
+    // GGUF 양자화 소형 모델을 CPU에서 돌리는 백엔드 (llama.cpp). NPU 없는 x64/Linux용.
+    //   "backend": {"type": "cpu", "cpu": {
+    //       "model": "models/qwen2.5-1.5b-instruct-q4_k_m.gguf",   base_dir 기준 상대 경로 가능
+    //       "context-size": 2048, "threads": 0 (= 하드웨어 스레드 수), "batch": 512,
+    //       "temp": 0 (= greedy), "top-k": 40, "top-p": 0.95, "seed": 42,
+    //       "draft": "models/qwen2.5-0.5b-instruct-q4_k_m.gguf",  (선택) 추측 디코딩용 작은 모델, 같은 어휘
+    //       "draft-max": 6                                        패스마다 draft가 제안하는 최대 토큰 수
+    //   }}
+    // KV에 올라간 토큰 열을 기억해 두고, REWIND는 새 프롬프트와 공통 토큰 prefix 뒤만 지우고 prefill합니다.
+    // draft가 있으면 draft가 greedy로 토큰 몇 개를 제안하고 target이 한 번의 batch로 전부 검증합니다.
+    // 위치마다 target 샘플러로 뽑은 토큰이 제안과 같을 때까지 받아들이므로 출력은 draft 없이와 같은 분포.
+    class CpuBackend final : public InferenceBackend {
+    public:
+        ~CpuBackend() override {
+            if (m_verify.token) llama_batch_free(m_verify);
+            if (m_draft_smpl) llama_sampler_free(m_draft_smpl);
+            if (m_draft.ctx) llama_free(m_draft.ctx);
+            if (m_draft_model) llama_model_free(m_draft_model);
+            if (m_smpl) llama_sampler_free(m_smpl);
+            if (m_main.ctx) llama_free(m_main.ctx);
+            if (m_model) llama_model_free(m_model);
+        }
+
+        const char* Name() const override { return "cpu"; }
+
+        bool Load(const std::string& config_json, const std::string& base_dir, std::string& err) override {
+            const std::string options = InferenceBackendOptions(config_json, "cpu"); // opts의 view가 가리킴
+            JsonReader opts;
+            if (!opts.Parse(options)) {
+                err = "backend.cpu options are not a JSON object";
+                return false;
+            }
+            fs::path model = fs::u8path(std::string(opts.String("model")));
+            if (model.empty()) { err = "backend.cpu.model is not set"; return false; }
+            if (model.is_relative()) model = fs::u8path(base_dir) / model;
+            if (!fs::is_regular_file(model)) { err = "GGUF model not found: " + model.u8string(); return false; }
+
+            static std::once_flag once;
+            std::call_once(once, [] { llama_backend_init(); });
+
+            llama_model_params mp = llama_model_default_params();
+            mp.n_gpu_layers = 0;
+            m_model = llama_model_load_from_file(model.u8string().c_str(), mp);
+            if (!m_model) { err = "llama_model_load_from_file failed: " + model.u8string(); return false; }
+            m_vocab = llama_model_get_vocab(m_model);
+
+            const long long hw = std::max(1u, std::thread::hardware_concurrency());
+            const long long threads = opts.Number("threads", 0);
+            llama_context_params cp = llama_context_default_params();
+            cp.n_ctx = static_cast<uint32_t>(std::max(256LL, opts.Number("context-size", 2048)));
+            cp.n_batch = static_cast<uint32_t>(std::max(32LL, opts.Number("batch", 512)));
+            cp.n_threads = cp.n_threads_batch = static_cast<int32_t>(threads > 0 ? threads : hw);
+            m_main.ctx = llama_init_from_model(m_model, cp);
+            if (!m_main.ctx) { err = "llama_init_from_model failed"; return false; }
+            m_batch = cp.n_batch;
+            llama_set_abort_callback(m_main.ctx, [](void* self) {
+                return static_cast<CpuBackend*>(self)->m_abort.load();
+            }, this);
+            if (opts.Has("draft") && !LoadDraft(opts, base_dir, cp, err)) return false;
+
+            m_smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
+            const double temp = opts.Double("temp", 0.0);
+            if (temp <= 0.0) {
+                llama_sampler_chain_add(m_smpl, llama_sampler_init_greedy());
+            }
+            else {
+                llama_sampler_chain_add(m_smpl, llama_sampler_init_top_k(static_cast<int32_t>(opts.Number("top-k", 40))));
+                llama_sampler_chain_add(m_smpl, llama_sampler_init_top_p(static_cast<float>(opts.Double("top-p", 0.95)), 1));
+                llama_sampler_chain_add(m_smpl, llama_sampler_init_temp(static_cast<float>(temp)));
+                llama_sampler_chain_add(m_smpl, llama_sampler_init_dist(static_cast<uint32_t>(opts.Number("seed", 42))));
+            }
+            return true;
+        }
+
+        uint32_t ContextTokens() const override { return m_main.ctx ? llama_n_ctx(m_main.ctx) : 0; }
+
+        // draft도 같은 prefix를 KV에 올려 둠 (첫 제안 때 프롬프트 전체를 따라잡지 않도록)
+        bool Prefill(const std::string& prompt) override {
+            m_abort = false;
+            const std::vector<llama_token> tokens = Tokenize(prompt);
+            return Eval(m_main, tokens, true) && (!m_draft.ctx || Eval(m_draft, tokens, true));
+        }
+
+        // Eval이 이미 공통 prefix를 재사용 (draft도 같이 따라감)
+        bool PrefillRewind(const std::string& prompt) override { return Prefill(prompt); }
+
+        bool Generate(const std::string& prompt, bool rewind, TokenCallback on_piece, void* user) override {
+            m_abort = false;
+            m_last = DecodeStats();
+            if (!rewind) Reset();
+            if (!Eval(m_main, Tokenize(prompt), rewind)) return false;
+            llama_sampler_reset(m_smpl);
+            if (m_draft.ctx) return GenerateSpeculative(on_piece, user);
+
+            char piece[256];
+            for (uint32_t n = 0; !m_max_tokens || n < m_max_tokens; ++n) {
+                if (m_abort.load()) return false;
+                llama_token tok = llama_sampler_sample(m_smpl, m_main.ctx, -1);
+                if (llama_vocab_is_eog(m_vocab, tok)) break;
+                const int len = llama_token_to_piece(m_vocab, tok, piece, sizeof(piece) - 1, 0, false);
+                if (len < 0) return false;
+                piece[len] = '\0';
+                if (m_main.tokens.size() + 1 >= llama_n_ctx(m_main.ctx)) break; // 컨텍스트 가득 참
+                if (llama_decode(m_main.ctx, llama_batch_get_one(&tok, 1)) != 0) return false;
+                ++m_last.passes;
+                m_main.tokens.push_back(tok);
+                if (!on_piece(piece, user)) break;
+            }
+            return true;
+        }
+
+        void SetMaxTokens(uint32_t n) override { m_max_tokens = n; }
+
+        bool Reset() override {
+            for (Seq* s : { &m_main, &m_draft }) {
+                if (!s->ctx) continue;
+                llama_memory_clear(llama_get_memory(s->ctx), true);
+                s->tokens.clear();
+            }
+            return true;
+        }
+
+        // target만 저장. draft KV는 자기 토큰 열과 맞는 채로 두고 다음 제안 때 공통 prefix부터 따라잡음.
+        bool Save(const std::string& dir) override {
+            const std::string path = (fs::u8path(dir) / "cpu_state.bin").u8string();
+            return llama_state_save_file(m_main.ctx, path.c_str(), m_main.tokens.data(), m_main.tokens.size());
+        }
+
+        bool Restore(const std::string& dir) override {
+            const std::string path = (fs::u8path(dir) / "cpu_state.bin").u8string();
+            std::vector<llama_token> tokens(llama_n_ctx(m_main.ctx));
+            size_t n = 0;
+            if (!llama_state_load_file(m_main.ctx, path.c_str(), tokens.data(), tokens.size(), &n)) {
+                Reset();
+                return false;
+            }
+            tokens.resize(n);
+            m_main.tokens.swap(tokens);
+            return true;
+        }
+
+        void Abort() override { m_abort = true; }
+
+        int32_t CountTokens(const std::string& prompt) const override {
+            return m_vocab ? static_cast<int32_t>(Tokenize(prompt).size()) : -1;
+        }
+
+        bool Speculative() const override { return m_draft.ctx != nullptr; }
+        DecodeStats LastDecode() const override { return m_last; }
+
+    private:
+        // 한 모델의 컨텍스트와 그 KV(seq 0)에 올라간 토큰 열
+        struct Seq {
+            llama_context*           ctx = nullptr;
+            std::vector<llama_token> tokens;
+        };
+
+        bool LoadDraft(const JsonReader& opts, const std::string& base_dir, const llama_context_params& cp, std::string& err) {
+            fs::path draft = fs::u8path(std::string(opts.String("draft")));
+            if (draft.is_relative()) draft = fs::u8path(base_dir) / draft;
+            if (!fs::is_regular_file(draft)) { err = "draft GGUF model not found: " + draft.u8string(); return false; }
+
+            llama_model_params mp = llama_model_default_params();
+            mp.n_gpu_layers = 0;
+            m_draft_model = llama_model_load_from_file(draft.u8string().c_str(), mp);
+            if (!m_draft_model) { err = "llama_model_load_from_file failed: " + draft.u8string(); return false; }
+            // 같은 계열(Qwen2.5 0.5B/1.5B/7B)은 어휘가 같고 임베딩 패딩만 조금 다름
+            const int32_t n_main = llama_vocab_n_tokens(m_vocab);
+            const int32_t n_draft = llama_vocab_n_tokens(llama_model_get_vocab(m_draft_model));
+            if (n_main - n_draft > 128 || n_draft - n_main > 128) {
+                err = "draft model vocabulary does not match the target model";
+                return false;
+            }
+
+            m_draft.ctx = llama_init_from_model(m_draft_model, cp);
+            if (!m_draft.ctx) { err = "llama_init_from_model failed (draft)"; return false; }
+            llama_set_abort_callback(m_draft.ctx, [](void* self) {
+                return static_cast<CpuBackend*>(self)->m_abort.load();
+            }, this);
+            m_draft_smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
+            llama_sampler_chain_add(m_draft_smpl, llama_sampler_init_greedy());
+            m_draft_max = static_cast<uint32_t>(std::min(16LL, std::max(1LL, opts.Number("draft-max", 6))));
+            m_verify = llama_batch_init(static_cast<int32_t>(m_draft_max + 1), 0, 1);
+            return true;
+        }
+
+        // 한 패스: draft가 last 뒤로 최대 draft-max개를 greedy로 제안 → target이 [last, 제안...]을
+        // 한 batch로 평가 → 위치마다 target 샘플이 제안과 같은 동안 받아들이고, 처음 어긋난 위치의
+        // target 샘플(전부 맞으면 그 다음 토큰)이 다음 패스의 last. last는 KV에 아직 없는 토큰.
+        bool GenerateSpeculative(TokenCallback on_piece, void* user) {
+            const size_t n_ctx = llama_n_ctx(m_main.ctx);
+            llama_memory_t mem = llama_get_memory(m_main.ctx);
+            char piece[256];
+            uint32_t emitted = 0;
+            bool failed = false;
+            auto emit = [&](llama_token tok) { // false = 디코딩 끝
+                if (llama_vocab_is_eog(m_vocab, tok)) return false;
+                const int len = llama_token_to_piece(m_vocab, tok, piece, sizeof(piece) - 1, 0, false);
+                if (len < 0) { failed = true; return false; }
+                piece[len] = '\0';
+                ++emitted;
+                return on_piece(piece, user) && (!m_max_tokens || emitted < m_max_tokens);
+            };
+
+            llama_token last = llama_sampler_sample(m_smpl, m_main.ctx, -1);
+            if (!emit(last)) return !failed;
+            std::vector<llama_token> seq, draft;
+            for (;;) {
+                if (m_abort.load()) return false;
+                const size_t n_past = m_main.tokens.size();
+                if (n_past + 2 >= n_ctx) break; // 컨텍스트 가득 참
+
+                // draft 제안 (남은 컨텍스트와 토큰 예산 안에서)
+                size_t want = std::min<size_t>(m_draft_max, n_ctx - n_past - 2);
+                if (m_max_tokens) want = std::min<size_t>(want, m_max_tokens - emitted);
+                seq.assign(m_main.tokens.begin(), m_main.tokens.end());
+                seq.push_back(last);
+                if (!Eval(m_draft, seq, true)) return false;
+                draft.clear();
+                while (draft.size() < want) {
+                    llama_token d = llama_sampler_sample(m_draft_smpl, m_draft.ctx, -1);
+                    if (llama_vocab_is_eog(m_vocab, d)) break; // EOG는 target이 직접 정함
+                    draft.push_back(d);
+                    if (draft.size() == want) break;
+                    if (llama_decode(m_draft.ctx, llama_batch_get_one(&d, 1)) != 0) return false;
+                    m_draft.tokens.push_back(d);
+                }
+
+                // target 검증: [last, d1..dk]를 한 번에, 위치마다 logits
+                m_verify.n_tokens = 0;
+                AddToBatch(last, static_cast<llama_pos>(n_past));
+                for (size_t i = 0; i < draft.size(); ++i) AddToBatch(draft[i], static_cast<llama_pos>(n_past + 1 + i));
+                if (llama_decode(m_main.ctx, m_verify) != 0) return false;
+                ++m_last.passes;
+                m_last.drafted += static_cast<uint32_t>(draft.size());
+                m_main.tokens.push_back(last);
+
+                bool go = true;
+                size_t i = 0;
+                for (;; ++i) {
+                    const llama_token t = llama_sampler_sample(m_smpl, m_main.ctx, static_cast<int32_t>(i));
+                    if (i < draft.size() && t == draft[i]) {
+                        ++m_last.accepted;
+                        m_main.tokens.push_back(t); // 이미 KV에 있음
+                        if (!(go = emit(t))) break;
+                        continue;
+                    }
+                    last = t;
+                    break;
+                }
+                llama_memory_seq_rm(mem, 0, static_cast<llama_pos>(m_main.tokens.size()), -1); // 거절된 제안
+                if (!go || !emit(last)) return !failed;
+            }
+            return true;
+        }
+
+        void AddToBatch(llama_token tok, llama_pos pos) {
+            const int32_t k = m_verify.n_tokens++;
+            m_verify.token[k] = tok;
+            m_verify.pos[k] = pos;
+            m_verify.n_seq_id[k] = 1;
+            m_verify.seq_id[k][0] = 0;
+            m_verify.logits[k] = 1;
+        }
+
+        // ChatML 태그(<|im_start|> 등)는 special 토큰으로 파싱
+        std::vector<llama_token> Tokenize(const std::string& text) const {
+            std::vector<llama_token> out(text.size() + 8);
+            int n = llama_tokenize(m_vocab, text.data(), static_cast<int32_t>(text.size()),
+                out.data(), static_cast<int32_t>(out.size()), true, true);
+            if (n < 0) {
+                out.resize(static_cast<size_t>(-n));
+                n = llama_tokenize(m_vocab, text.data(), static_cast<int32_t>(text.size()),
+                    out.data(), static_cast<int32_t>(out.size()), true, true);
+            }
+            out.resize(static_cast<size_t>(std::max(n, 0)));
+            return out;
+        }
+
+        // 공통 prefix 뒤를 KV에서 지우고 나머지를 batch 단위로 prefill.
+        // 마지막 토큰은 항상 다시 평가해서 다음 토큰 logits를 얻음.
+        bool Eval(Seq& s, const std::vector<llama_token>& tokens, bool reuse) {
+            if (tokens.empty() || tokens.size() >= llama_n_ctx(s.ctx)) return false;
+            size_t keep = 0;
+            if (reuse) {
+                const size_t n = std::min(tokens.size(), s.tokens.size());
+                while (keep < n && tokens[keep] == s.tokens[keep]) ++keep;
+                if (keep == tokens.size()) --keep;
+            }
+            llama_memory_seq_rm(llama_get_memory(s.ctx), 0, static_cast<llama_pos>(keep), -1);
+            s.tokens.resize(keep);
+
+            for (size_t i = keep; i < tokens.size(); i += m_batch) {
+                const size_t n = std::min<size_t>(m_batch, tokens.size() - i);
+                llama_batch batch = llama_batch_get_one(const_cast<llama_token*>(tokens.data() + i), static_cast<int32_t>(n));
+                if (llama_decode(s.ctx, batch) != 0) return false; // 2 = abort 콜백
+                s.tokens.insert(s.tokens.end(), tokens.begin() + i, tokens.begin() + i + n);
+            }
+            return true;
+        }
+
+        llama_model*             m_model = nullptr;
+        Seq                      m_main;     // target
+        llama_sampler*           m_smpl = nullptr;
+        const llama_vocab*       m_vocab = nullptr;
+        uint32_t                 m_batch = 512;
+        uint32_t                 m_max_tokens = 0;
+        std::atomic<bool>        m_abort{ false };
+
+        llama_model*             m_draft_model = nullptr; // 없으면 일반 디코딩
+        Seq                      m_draft;
+        llama_sampler*           m_draft_smpl = nullptr;
+        uint32_t                 m_draft_max = 6;
+        llama_batch              m_verify{};              // [last, 제안...] 검증 batch
+        DecodeStats              m_last;
+    };
+
+    std::unique_ptr<InferenceBackend> CreateCpuBackend() {
+        return std::make_unique<CpuBackend>();
+    }
+
+} // namespace AppUtils
+#endif // PC_WITH_LLAMA
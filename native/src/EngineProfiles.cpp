@@ -0,0 +1,63 @@
+#include "EngineProfiles.hpp"
+
+#include "Json.hpp"
+
+namespace AppUtils {
+
+    const std::vector<EngineTunable>& EngineTunables() {
+        static const std::vector<EngineTunable> k = {
+            // genie: engine / QnnHtp
+            { "n-threads", 'n' }, { "cpu-mask", 's' }, { "use-mmap", 'b' }, { "mmap-budget", 'n' },
+            { "spill-fill-bufsize", 'n' }, { "poll", 'b' },
+            // genie "spd" dialog: draft 토큰 수
+            { "draft-len", 'n' },
+            // cpu: backend.cpu
+            { "threads", 'n' }, { "batch", 'n' }, { "draft-max", 'n' },
+        };
+        return k;
+    }
+
+    bool SelectEngineProfile(std::string_view profiles_json, const HardwareInfo& hw, const std::string& mode,
+                             std::string& name, std::string& profile, std::string& why) {
+        JsonReader doc, machine, profiles;
+        if (!doc.Parse(profiles_json) || !profiles.Parse(doc.Raw("profiles"))) {
+            why = "engine profiles file is not valid";
+            return false;
+        }
+        if (machine.Parse(doc.Raw("machine")) &&
+            !hw.SameMachine(static_cast<unsigned>(machine.Number("logical", 0)),
+                            static_cast<uint64_t>(machine.Number("total_mb", 0)))) {
+            why = "engine profiles were tuned on different hardware";
+            return false;
+        }
+
+        std::vector<std::string> order = { mode };
+        if (mode == "saver") order.push_back("dc");
+        if (mode != "ac") order.push_back("ac");
+        for (const std::string& m : order) {
+            const std::string_view raw = profiles.Raw(m);
+            if (raw.empty() || raw.front() != '{') continue;
+            name = m;
+            profile.assign(raw.data(), raw.size());
+            return true;
+        }
+        why = "no engine profile for power mode " + mode;
+        return false;
+    }
+
+    size_t ApplyEngineProfile(std::string& config_json, std::string_view profile) {
+        JsonReader p;
+        if (!p.Parse(profile)) return 0;
+        size_t applied = 0;
+        for (const EngineTunable& t : EngineTunables()) {
+            if (!p.Has(t.key)) continue;
+            std::string value;
+            if (t.kind == 'b') value = p.Bool(t.key) ? "true" : "false";
+            else if (t.kind == 's') value = "\"" + JsonEscape(p.String(t.key)) + "\"";
+            else value = std::to_string(p.Number(t.key, 0));
+            if (JsonSetMember(config_json, t.key, value)) ++applied;
+        }
+        return applied;
+    }
+
+} // namespace AppUtils
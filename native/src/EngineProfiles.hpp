@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HardwareProbe.hpp"
+
+namespace AppUtils {
+
+// PaperClipTune이 만든 engine_profiles.json (설정 파일과 같은 폴더):
+//   {"version":1, "machine":{HardwareInfo::Json()},
+//    "profiles":{"ac":{"n-threads":6,"cpu-mask":"0xfc0","poll":true,...,"metrics":{...}},
+//                "dc":{...}, "saver":{...}}}
+// 프로파일 값은 설정 문서 안의 같은 이름 멤버를 깊이와 상관없이 덮어씁니다 (설정에 없는 키는 무시).
+
+struct EngineTunable {
+  const char* key;
+  char        kind;   // 'n' 숫자, 'b' 불리언, 's' 문자열
+};
+
+// genie(QnnHtp/engine) + cpu(llama.cpp) 백엔드의 성능 관련 키. 출력 내용에는 영향이 없는 것만.
+const std::vector<EngineTunable>& EngineTunables();
+
+// 프로파일 파일에서 mode에 맞는 항목을 고름: mode → ("saver"면 "dc") → "ac".
+// 다른 기계에서 만든 파일(논리 코어 수/메모리 총량이 다름)이면 고르지 않음.
+// 성공 시 name = 고른 키, profile = 그 객체 원문. 실패 시 why에 사유.
+bool SelectEngineProfile(std::string_view profiles_json, const HardwareInfo& hw, const std::string& mode,
+                         std::string& name, std::string& profile, std::string& why);
+
+// profile의 튜닝 값들을 config_json에 덮어씀. 실제로 바꾼 키 수를 돌려줌.
+size_t ApplyEngineProfile(std::string& config_json, std::string_view profile);
+
+} // namespace AppUtils
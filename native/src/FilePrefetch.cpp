@@ -0,0 +1,60 @@
+#include "FilePrefetch.hpp"
+
+#include <filesystem>
+#include <memory>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace AppUtils {
+
+    namespace {
+        constexpr size_t kChunk = 4u << 20; // 4 MiB 순차 읽기
+    }
+
+    void FilePrefetch::Start(std::vector<std::string> paths) {
+        Stop();
+        m_stop = false;
+        m_bytes = 0;
+        if (paths.empty()) return;
+        m_thread = std::thread([this, paths = std::move(paths)] { Run(paths); });
+    }
+
+    void FilePrefetch::Stop() {
+        m_stop = true;
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void FilePrefetch::Run(const std::vector<std::string>& paths) {
+        std::unique_ptr<char[]> buf(new char[kChunk]);
+        for (const std::string& p : paths) {
+            if (m_stop.load()) return;
+#ifdef _WIN32
+            HANDLE h = CreateFileW(fs::u8path(p).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (h == INVALID_HANDLE_VALUE) continue;
+            DWORD got = 0;
+            while (!m_stop.load() && ReadFile(h, buf.get(), static_cast<DWORD>(kChunk), &got, nullptr) && got > 0)
+                m_bytes.fetch_add(got, std::memory_order_relaxed);
+            CloseHandle(h);
+#else
+            const int fd = ::open(p.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+#ifdef POSIX_FADV_SEQUENTIAL
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            ssize_t got = 0;
+            while (!m_stop.load() && (got = ::read(fd, buf.get(), kChunk)) > 0)
+                m_bytes.fetch_add(static_cast<uint64_t>(got), std::memory_order_relaxed);
+            ::close(fd);
+#endif
+        }
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AppUtils {
+
+// 모델 파일(ctx-bins, GGUF)을 백그라운드 스레드 하나가 순서대로 끝까지 읽어 OS 페이지 캐시에 올립니다.
+// 백엔드 Load와 겹쳐 돌리면 엔진의 읽기가 디스크 대신 캐시에서 끝납니다. 읽은 데이터는 버림.
+class FilePrefetch {
+public:
+  FilePrefetch() = default;
+  FilePrefetch(const FilePrefetch&) = delete;
+  FilePrefetch& operator=(const FilePrefetch&) = delete;
+  ~FilePrefetch() { Stop(); }
+
+  // paths: UTF-8. 없는 파일은 건너뜀.
+  void Start(std::vector<std::string> paths);
+  // 남은 읽기를 멈추고 스레드를 회수
+  void Stop();
+
+  uint64_t Bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+private:
+  void Run(const std::vector<std::string>& paths);
+
+  std::thread           m_thread;
+  std::atomic<bool>     m_stop{ false };
+  std::atomic<uint64_t> m_bytes{ 0 };
+};
+
+} // namespace AppUtils
@@ -0,0 +1,168 @@
+#include "InferenceBackend.hpp"
+
+#ifdef PC_WITH_GENIE
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "GenieCommon.h"
+#include "GenieDialog.h"
+#include "Json.hpp"
+
+namespace fs = std::filesystem;
+
+namespace AppUtils {
+
+    namespace {
+        void noop_query_cb(const char*, const GenieDialog_SentenceCode_t, const void*) {}
+
+        // Genie 콜백 → TokenCallback. false를 받으면 SDK에 ABORT를 보내고 남은 조각은 버림.
+        struct Relay {
+            InferenceBackend::TokenCallback fn;
+            void*                           user;
+            GenieDialog_Handle_t            dlg;
+            bool                            stopped;
+        };
+
+        void relay_cb(const char* resp, const GenieDialog_SentenceCode_t, const void* user_data) {
+            auto* r = static_cast<Relay*>(const_cast<void*>(user_data));
+            if (r->stopped || !resp) return;
+            if (!r->fn(resp, r->user)) {
+                r->stopped = true;
+                GenieDialog_signal(r->dlg, GENIE_DIALOG_ACTION_ABORT);
+            }
+        }
+
+        std::string absolute_under(std::string_view path, const fs::path& base) {
+            const fs::path p = fs::u8path(std::string(path));
+            return (p.is_relative() ? base / p : p).lexically_normal().u8string();
+        }
+
+        std::string quoted(const std::string& s) { return "\"" + JsonEscape(s) + "\""; }
+
+        // 설정 속 상대 경로(tokenizer.path, extensions, ctx-bins)를 base_dir 기준 절대 경로로.
+        // SDK가 CWD 기준으로 여는 경로라, 이렇게 해 두면 질의마다 chdir하지 않아도 됩니다.
+        // "spd"처럼 엔진이 여럿이면 엔진마다 따로 바꿈.
+        void absolutize_paths(std::string& json, const fs::path& base) {
+            JsonMapMembers(json, "tokenizer", [&](std::string_view raw) {
+                JsonReader t;
+                if (raw.empty() || raw.front() != '{' || !t.Parse(raw) || !t.Has("path")) return std::string(raw);
+                std::string obj(raw);
+                JsonSetMember(obj, "path", quoted(absolute_under(t.String("path"), base)));
+                return obj;
+            });
+            JsonMapMembers(json, "extensions", [&](std::string_view raw) {
+                if (raw.size() < 2 || raw.front() != '"') return std::string(raw);
+                std::string path;
+                JsonUnescape(raw.substr(1, raw.size() - 2), path);
+                return quoted(absolute_under(path, base));
+            });
+            JsonMapMembers(json, "ctx-bins", [&](std::string_view raw) {
+                std::vector<std::string> bins;
+                if (!JsonParseStringArray(raw, bins)) return std::string(raw);
+                std::string arr = "[";
+                for (size_t i = 0; i < bins.size(); ++i) {
+                    if (i) arr += ",";
+                    arr += quoted(absolute_under(bins[i], base));
+                }
+                arr += "]";
+                return arr;
+            });
+        }
+    }
+
+    // dialog "type": "basic" = 모델 하나. "spd" = 추측 디코딩: "engine"이 배열이고
+    // "role": "draft"(Qwen2.5-0.5B/1.5B 등 작은 모델)와 "role": "target"(7B) 엔진이 각자 ctx-bins를 가지며,
+    // "spd": {"draft-len": n}만큼 draft가 제안한 토큰을 target이 한 번에 검증합니다.
+    // 두 엔진 모두 이 dialog 하나가 만들고 해제합니다 (runtime/genie_config_spd.json 참고).
+    // SDK가 수락률을 내주지 않으므로 LastDecode()는 비어 있고, 효과는 DLL의 토큰/초로 봅니다.
+    class GenieBackend final : public InferenceBackend {
+    public:
+        ~GenieBackend() override {
+            if (m_dlg) GenieDialog_free(m_dlg);
+            if (m_cfg) GenieDialogConfig_free(m_cfg);
+        }
+
+        const char* Name() const override { return "genie"; }
+
+        // Genie가 아는 "dialog"만 넘김 (최상위 "backend", "pool" 등은 DLL 몫)
+        bool Load(const std::string& config_json, const std::string& base_dir, std::string& err) override {
+            const fs::path bundle = fs::u8path(base_dir) / "genie_bundle";
+            if (!fs::exists(bundle) || !fs::is_directory(bundle)) {
+                err = "genie_bundle not found under base dir: " + bundle.string();
+                return false;
+            }
+
+            JsonReader cfg, dialog, context;
+            std::string genie_json = config_json;
+            if (cfg.Parse(config_json)) {
+                const std::string_view d = cfg.Raw("dialog");
+                if (!d.empty()) genie_json = "{\"dialog\":" + std::string(d) + "}";
+                if (dialog.Parse(d)) {
+                    m_speculative = dialog.String("type") == "spd";
+                    if (context.Parse(dialog.Raw("context")))
+                        m_ctx_tokens = static_cast<uint32_t>(std::max(0LL, context.Number("size", 0)));
+                }
+            }
+
+            absolutize_paths(genie_json, fs::u8path(base_dir));
+
+            if (GENIE_STATUS_SUCCESS != GenieDialogConfig_createFromJson(genie_json.c_str(), &m_cfg)) {
+                err = "GenieDialogConfig_createFromJson failed";
+                return false;
+            }
+            if (GENIE_STATUS_SUCCESS != GenieDialog_create(m_cfg, &m_dlg)) {
+                GenieDialogConfig_free(m_cfg); m_cfg = nullptr;
+                err = "GenieDialog_create failed";
+                return false;
+            }
+            return true;
+        }
+
+        uint32_t ContextTokens() const override { return m_ctx_tokens; }
+
+        // BEGIN: 프롬프트가 다음 질의에서 이어지므로 여기서는 디코딩하지 않음
+        bool Prefill(const std::string& prompt) override {
+            return GENIE_STATUS_SUCCESS == GenieDialog_query(
+                m_dlg, prompt.c_str(), GENIE_DIALOG_SENTENCE_BEGIN, noop_query_cb, nullptr);
+        }
+
+        bool Generate(const std::string& prompt, bool rewind, TokenCallback on_piece, void* user) override {
+            Relay relay{ on_piece, user, m_dlg, false };
+            return GENIE_STATUS_SUCCESS == GenieDialog_query(m_dlg, prompt.c_str(),
+                rewind ? GENIE_DIALOG_SENTENCE_REWIND : GENIE_DIALOG_SENTENCE_COMPLETE, relay_cb, &relay);
+        }
+
+        // SDK에 "REWIND하되 디코딩 없음"이 없어 첫 조각에서 멈춤: 토큰 하나가 KV에 남지만
+        // 다음 REWIND 질의가 공통 prefix까지 되감음
+        bool PrefillRewind(const std::string& prompt) override {
+            Relay relay{ [](const char*, void*) { return false; }, nullptr, m_dlg, false };
+            const Genie_Status_t st = GenieDialog_query(m_dlg, prompt.c_str(), GENIE_DIALOG_SENTENCE_REWIND, relay_cb, &relay);
+            return st == GENIE_STATUS_SUCCESS || relay.stopped;
+        }
+
+        void SetMaxTokens(uint32_t n) override { GenieDialog_setMaxNumTokens(m_dlg, n); }
+        bool Reset() override { return GENIE_STATUS_SUCCESS == GenieDialog_reset(m_dlg); }
+        bool Save(const std::string& dir) override { return GENIE_STATUS_SUCCESS == GenieDialog_save(m_dlg, dir.c_str()); }
+        bool Restore(const std::string& dir) override { return GENIE_STATUS_SUCCESS == GenieDialog_restore(m_dlg, dir.c_str()); }
+
+        void Abort() override {
+            if (m_dlg) GenieDialog_signal(m_dlg, GENIE_DIALOG_ACTION_ABORT);
+        }
+
+        bool Speculative() const override { return m_speculative; }
+
+    private:
+        GenieDialogConfig_Handle_t m_cfg = nullptr;
+        GenieDialog_Handle_t       m_dlg = nullptr;
+        uint32_t                   m_ctx_tokens = 0;
+        bool                       m_speculative = false;
+    };
+
+    std::unique_ptr<InferenceBackend> CreateGenieBackend() {
+        return std::make_unique<GenieBackend>();
+    }
+
+} // namespace AppUtils
+#endif // PC_WITH_GENIE
@@ -0,0 +1,172 @@
+#include "HardwareProbe.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <filesystem>
+#include <unistd.h>
+#endif
+
+namespace AppUtils {
+
+    namespace {
+#ifdef _WIN32
+        unsigned popcount64(uint64_t v) { return static_cast<unsigned>(std::bitset<64>(v).count()); }
+#else
+        // sysfs 값 한 줄 (없으면 dflt)
+        long long read_sys_number(const std::string& path, long long dflt) {
+            std::ifstream in(path);
+            long long v = dflt;
+            if (!(in >> v)) return dflt;
+            return v;
+        }
+
+        std::string read_sys_word(const std::string& path) {
+            std::ifstream in(path);
+            std::string w;
+            in >> w;
+            return w;
+        }
+#endif
+    }
+
+    std::string HexMask(uint64_t mask) {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(mask));
+        return buf;
+    }
+
+#ifdef _WIN32
+    HardwareInfo HardwareInfo::Probe() {
+        HardwareInfo hw;
+        DWORD len = 0;
+        GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &len);
+        std::vector<char> buf(len);
+        if (len && GetLogicalProcessorInformationEx(RelationProcessorCore,
+            reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data()), &len)) {
+            // 첫 번째 훑기: 가장 높은 EfficiencyClass (클수록 빠른 코어)
+            BYTE top = 0;
+            for (DWORD off = 0; off < len; ) {
+                const auto* e = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data() + off);
+                if (e->Processor.EfficiencyClass > top) top = e->Processor.EfficiencyClass;
+                off += e->Size;
+            }
+            for (DWORD off = 0; off < len; ) {
+                const auto* e = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data() + off);
+                off += e->Size;
+                ++hw.cores;
+                for (WORD g = 0; g < e->Processor.GroupCount; ++g) {
+                    const GROUP_AFFINITY& ga = e->Processor.GroupMask[g];
+                    hw.logical += popcount64(ga.Mask);
+                    if (ga.Group != 0) continue;
+                    hw.all_mask |= ga.Mask;
+                    if (e->Processor.EfficiencyClass == top) { hw.perf_mask |= ga.Mask; ++hw.perf_cores; }
+                }
+            }
+        }
+        if (!hw.logical) {
+            hw.logical = hw.cores = hw.perf_cores = std::max<unsigned>(1u, std::thread::hardware_concurrency());
+            hw.all_mask = hw.perf_mask = hw.logical >= 64 ? ~0ull : ((1ull << hw.logical) - 1);
+        }
+
+        MEMORYSTATUSEX ms{};
+        ms.dwLength = sizeof(ms);
+        if (GlobalMemoryStatusEx(&ms)) {
+            hw.total_mb = ms.ullTotalPhys >> 20;
+            hw.avail_mb = ms.ullAvailPhys >> 20;
+        }
+        hw.power = PowerMode();
+        return hw;
+    }
+
+    std::string PowerMode() {
+        SYSTEM_POWER_STATUS ps{};
+        if (!GetSystemPowerStatus(&ps)) return "ac";
+        if (ps.SystemStatusFlag == 1) return "saver";
+        return ps.ACLineStatus == 0 ? "dc" : "ac";
+    }
+#else
+    HardwareInfo HardwareInfo::Probe() {
+        HardwareInfo hw;
+        // cpuN/topology로 물리 코어를, cpu_capacity(ARM big.LITTLE) 또는 최대 클럭으로 빠른 코어를 구분
+        struct Cpu { unsigned id; long long speed; std::pair<long long, long long> core; };
+        std::vector<Cpu> cpus;
+        for (unsigned i = 0; ; ++i) {
+            const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(i);
+            std::error_code ec;
+            if (!std::filesystem::exists(dir, ec)) break;
+            long long speed = read_sys_number(dir + "/cpu_capacity", -1);
+            if (speed < 0) speed = read_sys_number(dir + "/cpufreq/cpuinfo_max_freq", 0);
+            cpus.push_back({ i, speed, { read_sys_number(dir + "/topology/physical_package_id", 0),
+                                         read_sys_number(dir + "/topology/core_id", i) } });
+        }
+        if (cpus.empty()) {
+            const unsigned n = std::max<unsigned>(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < n; ++i) cpus.push_back({ i, 0, { 0, static_cast<long long>(i) } });
+        }
+
+        long long top = 0;
+        for (const Cpu& c : cpus) top = std::max<long long>(top, c.speed);
+        std::set<std::pair<long long, long long>> cores, perf;
+        for (const Cpu& c : cpus) {
+            ++hw.logical;
+            cores.insert(c.core);
+            const uint64_t bit = c.id < 64 ? (1ull << c.id) : 0;
+            hw.all_mask |= bit;
+            if (c.speed == top) { perf.insert(c.core); hw.perf_mask |= bit; }
+        }
+        hw.cores = static_cast<unsigned>(cores.size());
+        hw.perf_cores = static_cast<unsigned>(perf.size());
+
+        std::ifstream mi("/proc/meminfo");
+        std::string name;
+        uint64_t kb = 0;
+        std::string unit;
+        while (mi >> name >> kb >> unit) {
+            if (name == "MemTotal:") hw.total_mb = kb >> 10;
+            else if (name == "MemAvailable:") hw.avail_mb = kb >> 10;
+        }
+        hw.power = PowerMode();
+        return hw;
+    }
+
+    std::string PowerMode() {
+        bool battery = false, mains = false;
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator("/sys/class/power_supply", ec)) {
+            const std::string dir = e.path().string();
+            const std::string type = read_sys_word(dir + "/type");
+            if (type == "Battery") battery = true;
+            else if (type == "Mains" && read_sys_number(dir + "/online", 0) == 1) mains = true;
+        }
+        return battery && !mains ? "dc" : "ac";
+    }
+#endif
+
+    // 코어 수가 같고 메모리 총량이 1/8 이내로 같으면 같은 기계로 봄 (총량은 펌웨어 예약에 따라 조금씩 다름)
+    bool HardwareInfo::SameMachine(unsigned other_logical, uint64_t other_total_mb) const {
+        if (other_logical != logical) return false;
+        const uint64_t hi = std::max<uint64_t>(total_mb, other_total_mb), lo = std::min<uint64_t>(total_mb, other_total_mb);
+        return hi - lo <= hi / 8;
+    }
+
+    std::string HardwareInfo::Json() const {
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+            "{\"logical\":%u,\"cores\":%u,\"perf_cores\":%u,\"perf_mask\":\"%s\",\"total_mb\":%llu,\"avail_mb\":%llu,\"power\":\"%s\"}",
+            logical, cores, perf_cores, HexMask(perf_mask).c_str(),
+            static_cast<unsigned long long>(total_mb), static_cast<unsigned long long>(avail_mb), power.c_str());
+        return buf;
+    }
+
+} // namespace AppUtils
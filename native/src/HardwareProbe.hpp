@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace AppUtils {
+
+// 코어 구성 / 메모리 / 전원 상태 조회. 튜너(PaperClipTune)와 DLL의 프로파일 선택이 함께 씁니다.
+// 프로세서 그룹 0(논리 프로세서 64개)까지만 마스크로 표현합니다.
+struct HardwareInfo {
+  unsigned    logical = 0;      // 논리 프로세서
+  unsigned    cores = 0;        // 물리 코어
+  unsigned    perf_cores = 0;   // 가장 빠른 등급(EfficiencyClass / cpu_capacity 최댓값)의 코어 수
+  uint64_t    perf_mask = 0;    // 그 코어들의 논리 프로세서 비트
+  uint64_t    all_mask = 0;
+  uint64_t    total_mb = 0;
+  uint64_t    avail_mb = 0;
+  std::string power;            // PowerMode()
+
+  static HardwareInfo Probe();
+
+  // 같은 기계에서 만든 프로파일인지 판단할 때 쓰는 값만
+  bool SameMachine(unsigned other_logical, uint64_t other_total_mb) const;
+
+  // {"logical":..,"cores":..,"perf_cores":..,"perf_mask":"0x..","total_mb":..,"avail_mb":..,"power":".."}
+  std::string Json() const;
+};
+
+// "ac" (전원 연결) / "dc" (배터리) / "saver" (배터리 절약 모드). 판단할 수 없으면 "ac".
+std::string PowerMode();
+
+std::string HexMask(uint64_t mask);
+
+} // namespace AppUtils
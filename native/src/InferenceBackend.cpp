@@ -0,0 +1,37 @@
+#include "InferenceBackend.hpp"
+#include "Json.hpp"
+
+namespace AppUtils {
+
+    // "backend": "mock"  또는  "backend": {"type": "mock", "mock": {...}}
+    std::string InferenceBackendKind(const std::string& config_json) {
+        JsonReader cfg;
+        if (!cfg.Parse(config_json) || !cfg.Has("backend")) return "genie";
+        const std::string backend(cfg.Raw("backend"));
+        if (backend.empty() || backend[0] != '{') return backend.empty() ? "genie" : backend;
+        JsonReader b;
+        if (!b.Parse(backend)) return "genie";
+        return std::string(b.String("type", "genie"));
+    }
+
+    std::string InferenceBackendOptions(const std::string& config_json, const std::string& kind) {
+        JsonReader cfg, b;
+        if (!cfg.Parse(config_json)) return "{}";
+        const std::string backend(cfg.Raw("backend"));
+        if (backend.empty() || backend[0] != '{' || !b.Parse(backend)) return "{}";
+        const std::string_view opts = b.Raw(kind);
+        return (!opts.empty() && opts[0] == '{') ? std::string(opts) : "{}";
+    }
+
+    std::unique_ptr<InferenceBackend> CreateInferenceBackend(const std::string& kind) {
+#ifdef PC_WITH_GENIE
+        if (kind == "genie") return CreateGenieBackend();
+#endif
+#ifdef PC_WITH_LLAMA
+        if (kind == "cpu") return CreateCpuBackend();
+#endif
+        if (kind == "mock") return CreateMockBackend();
+        return nullptr;
+    }
+
+} // namespace AppUtils
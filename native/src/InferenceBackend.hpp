@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace AppUtils {
+
+// 마지막 Generate의 추측 디코딩(speculative decoding) 계측.
+// draft 모델이 토큰을 제안하고 target 모델이 한 번의 forward로 검증합니다.
+struct DecodeStats {
+  uint32_t drafted = 0;  // draft 모델이 제안한 토큰
+  uint32_t accepted = 0; // 그중 target이 받아들인 토큰
+  uint32_t passes = 0;   // 디코딩 중 target forward 횟수
+};
+
+// export API 뒤의 추론 엔진. PaperClipNative.cpp는 이 인터페이스만 호출합니다.
+// - "genie": Qualcomm QNN HTP (GenieDialog)          — PC_WITH_GENIE 빌드
+// - "cpu"  : GGUF 양자화 모델을 CPU에서 (llama.cpp)  — PC_WITH_LLAMA 빌드
+// - "mock" : 설정된 토큰 스트림을 정해진 타이밍으로 재생 — 항상 포함
+// 선택은 설정 파일 최상위 "backend": {"type": "...", "<type>": {...옵션}} (없으면 "genie").
+//
+// 스레드: Abort()만 아무 스레드에서 호출될 수 있고, 나머지는 인스턴스를 임대한 스레드가 순차 호출합니다
+// (BackendPool). 서로 다른 인스턴스는 동시에 Generate할 수 있습니다.
+class InferenceBackend {
+public:
+  // 디코딩된 조각(토큰 하나 분량, UTF-8 경계가 아닐 수 있음)마다 호출. false를 반환하면 디코딩 중단.
+  using TokenCallback = bool (*)(const char* piece, void* user);
+
+  virtual ~InferenceBackend() = default;
+
+  virtual const char* Name() const = 0;
+
+  // config_json: 설정 파일 전체, base_dir: 상대 경로의 기준. 실패 시 err에 사유.
+  virtual bool Load(const std::string& config_json, const std::string& base_dir, std::string& err) = 0;
+
+  // 컨텍스트 창 크기(토큰). 알 수 없으면 0.
+  virtual uint32_t ContextTokens() const = 0;
+
+  // prompt를 KV에 올리기만 하고 디코딩은 하지 않음 (고정 prefix 상주용)
+  virtual bool Prefill(const std::string& prompt) = 0;
+
+  // prompt를 prefill하고 EOS / 토큰 상한 / 중단까지 디코딩.
+  // rewind=true: 현재 KV와 토큰 prefix가 같은 부분은 재사용 (지원하지 않으면 출력 없이 false).
+  // rewind=false: 현재 KV 뒤에 이어 붙이지 않는 완전한 질의 (보통 Reset() 직후).
+  virtual bool Generate(const std::string& prompt, bool rewind, TokenCallback on_piece, void* user) = 0;
+
+  // Generate(rewind=true)처럼 KV와 토큰 prefix가 같은 부분은 재사용하고 나머지만 prefill, 디코딩 없음
+  // (입력 중인 문장의 추측 prefill — 완성된 문장의 질의는 그 뒤만 prefill). 지원하지 않으면 false.
+  virtual bool PrefillRewind(const std::string& /*prompt*/) { return false; }
+
+  virtual void SetMaxTokens(uint32_t n) = 0;
+  virtual bool Reset() = 0;
+
+  // KV 상태 스냅샷. dir은 이미 존재하는 디렉터리.
+  virtual bool Save(const std::string& dir) = 0;
+  virtual bool Restore(const std::string& dir) = 0;
+
+  // 진행 중인 Generate/Prefill을 가능한 빨리 끝냄
+  virtual void Abort() = 0;
+
+  // prompt의 토큰 수 (벤치마크용). 토크나이저를 노출하지 않는 엔진은 -1.
+  virtual int32_t CountTokens(const std::string& /*prompt*/) const { return -1; }
+
+  // draft 모델로 추측 디코딩하도록 로드되었나
+  virtual bool Speculative() const { return false; }
+  // 마지막 Generate의 계측. 엔진이 알려 주지 않으면 passes = 0.
+  virtual DecodeStats LastDecode() const { return DecodeStats(); }
+};
+
+// 설정의 backend 종류 ("genie" 기본)
+std::string InferenceBackendKind(const std::string& config_json);
+
+// "backend" 안의 해당 종류 옵션 객체 원문 (없으면 "{}")
+std::string InferenceBackendOptions(const std::string& config_json, const std::string& kind);
+
+// 이 빌드에 없는 종류면 nullptr
+std::unique_ptr<InferenceBackend> CreateInferenceBackend(const std::string& kind);
+
+// 구현별 생성 함수 (CreateInferenceBackend가 빌드 플래그에 따라 사용)
+std::unique_ptr<InferenceBackend> CreateGenieBackend();
+std::unique_ptr<InferenceBackend> CreateCpuBackend();
+std::unique_ptr<InferenceBackend> CreateMockBackend();
+
+} // namespace AppUtils
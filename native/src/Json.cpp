@@ -0,0 +1,451 @@
+#include "Json.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define PC_JSON_NEON 1
+#if defined(_MSC_VER)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#elif defined(_M_X64) || defined(__SSE2__)
+#define PC_JSON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace AppUtils {
+
+    namespace {
+        inline unsigned ctz32(uint32_t x) {
+#if defined(_MSC_VER)
+            unsigned long i; _BitScanForward(&i, x); return static_cast<unsigned>(i);
+#else
+            return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+        }
+
+        inline unsigned ctz64(uint64_t x) {
+#if defined(_MSC_VER)
+            unsigned long i; _BitScanForward64(&i, x); return static_cast<unsigned>(i);
+#else
+            return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+        }
+
+        inline bool is_special(unsigned char c) { return c == '"' || c == '\\' || c < 0x20; }
+
+        inline const char* skip_ws(const char* p, const char* end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+            return p;
+        }
+
+        int hex_val(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool read_hex4(const char* p, const char* end, unsigned& cp) {
+            if (end - p < 4) return false;
+            cp = 0;
+            for (int i = 0; i < 4; ++i) {
+                const int v = hex_val(p[i]);
+                if (v < 0) return false;
+                cp = (cp << 4) | static_cast<unsigned>(v);
+            }
+            return true;
+        }
+
+        // p는 여는 따옴표. 성공 시 raw = 따옴표 안쪽, p = 닫는 따옴표 다음.
+        bool scan_string(const char*& p, const char* end, std::string_view& raw, bool& escaped) {
+            const char* start = ++p;
+            escaped = false;
+            for (;;) {
+                p += JsonFindSpecial(p, static_cast<size_t>(end - p));
+                if (p >= end) return false;
+                if (*p == '"') {
+                    raw = std::string_view(start, static_cast<size_t>(p - start));
+                    ++p;
+                    return true;
+                }
+                if (*p == '\\') {
+                    escaped = true;
+                    if (end - p < 2) return false;
+                    p += 2;
+                    continue;
+                }
+                ++p; // raw control byte: tolerated
+            }
+        }
+
+        // 숫자/리터럴 토큰 끝까지
+        const char* scan_scalar(const char* p, const char* end) {
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') ++p;
+            return p;
+        }
+
+        // 중첩 객체/배열을 건너뜀 (문자열 속 괄호는 무시)
+        bool skip_container(const char*& p, const char* end) {
+            int depth = 0;
+            while (p < end) {
+                const char c = *p;
+                if (c == '"') {
+                    std::string_view raw; bool esc;
+                    if (!scan_string(p, end, raw, esc)) return false;
+                    continue;
+                }
+                if (c == '{' || c == '[') ++depth;
+                else if (c == '}' || c == ']') {
+                    if (--depth == 0) { ++p; return true; }
+                }
+                ++p;
+            }
+            return false;
+        }
+    }
+
+    // ─────────────────────────── scanning ───────────────────────────
+    size_t JsonFindSpecial(const char* p, size_t n) {
+        size_t i = 0;
+#if defined(PC_JSON_NEON)
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t bslash = vdupq_n_u8('\\');
+        const uint8x16_t space = vdupq_n_u8(0x20);
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i));
+            const uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)), vcltq_u8(v, space));
+            if (vmaxvq_u8(m) == 0) continue;
+            // 바이트 마스크 → 니블 마스크(64비트)로 줄여 첫 위치 계산
+            const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+            return i + (ctz64(bits) >> 2);
+        }
+#elif defined(PC_JSON_SSE2)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i bslash = _mm_set1_epi8('\\');
+        const __m128i ctl = _mm_set1_epi8(0x1F);
+        for (; i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)),
+                _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl)); // v <= 0x1F
+            const int bits = _mm_movemask_epi8(m);
+            if (bits) return i + ctz32(static_cast<uint32_t>(bits));
+        }
+#endif
+        for (; i < n; ++i) {
+            if (is_special(static_cast<unsigned char>(p[i]))) return i;
+        }
+        return n;
+    }
+
+    // ─────────────────────────── UTF-8 ──────────────────────────────
+    void Utf8Append(std::string& out, uint32_t cp) {
+        if (cp < 0x80) out.push_back(static_cast<char>(cp));
+        else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    size_t Utf8Decode(std::string_view text, size_t i, uint32_t& cp) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        const size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        if (len == 0 || i + len > text.size()) { cp = 0xFFFD; return 1; }
+        if (len == 1) { cp = c; return 1; }
+        cp = c & (0x7F >> len);
+        for (size_t k = 1; k < len; ++k) {
+            const unsigned char cc = static_cast<unsigned char>(text[i + k]);
+            if ((cc & 0xC0) != 0x80) { cp = 0xFFFD; return 1; }
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+        return len;
+    }
+
+    // ─────────────────────────── serializer ─────────────────────────
+    void JsonAppendEscaped(std::string& out, std::string_view s) {
+        out.reserve(out.size() + s.size() + 8);
+        const char* p = s.data();
+        size_t n = s.size();
+        while (n) {
+            const size_t run = JsonFindSpecial(p, n);
+            out.append(p, run);
+            if (run == n) break;
+            const unsigned char c = static_cast<unsigned char>(p[run]);
+            switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b";  break;
+            case '\f': out += "\\f";  break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default: {
+                static const char kHex[] = "0123456789ABCDEF";
+                const char esc[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+                out.append(esc, 6);
+            }
+            }
+            p += run + 1;
+            n -= run + 1;
+        }
+    }
+
+    std::string JsonEscape(std::string_view s) {
+        std::string out;
+        JsonAppendEscaped(out, s);
+        return out;
+    }
+
+    void JsonUnescape(std::string_view raw, std::string& out) {
+        out.clear();
+        out.reserve(raw.size());
+        const char* p = raw.data();
+        const char* end = p + raw.size();
+        while (p < end) {
+            const char* bs = static_cast<const char*>(std::memchr(p, '\\', static_cast<size_t>(end - p)));
+            if (!bs) { out.append(p, end); break; }
+            out.append(p, bs);
+            p = bs + 1;
+            if (p >= end) break;
+            const char e = *p++;
+            switch (e) {
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'u': {
+                unsigned cp;
+                if (!read_hex4(p, end, cp)) { out.push_back('u'); break; }
+                p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    unsigned lo;
+                    if (end - p >= 6 && p[0] == '\\' && p[1] == 'u' && read_hex4(p + 2, end, lo) &&
+                        lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p += 6;
+                    }
+                    else cp = 0xFFFD;
+                }
+                else if (cp >= 0xDC00 && cp <= 0xDFFF) cp = 0xFFFD;
+                Utf8Append(out, cp);
+                break;
+            }
+            default: out.push_back(e); break; // '"', '\\', '/', and unknown escapes
+            }
+        }
+    }
+
+    bool JsonParseStringArray(std::string_view text, std::vector<std::string>& out) {
+        out.clear();
+        const char* p = text.data();
+        const char* end = p + text.size();
+        p = skip_ws(p, end);
+        if (p >= end || *p != '[') return false;
+        ++p;
+        for (;;) {
+            p = skip_ws(p, end);
+            if (p >= end) return false;
+            if (*p == ']') return true;
+            if (*p == '"') {
+                std::string_view raw; bool esc;
+                if (!scan_string(p, end, raw, esc)) return false;
+                if (esc) { out.emplace_back(); JsonUnescape(raw, out.back()); }
+                else out.emplace_back(raw);
+            }
+            else if (*p == '{' || *p == '[') {
+                if (!skip_container(p, end)) return false;
+            }
+            else {
+                const char* q = scan_scalar(p, end);
+                if (q == p) return false;
+                p = q;
+            }
+            p = skip_ws(p, end);
+            if (p >= end) return false;
+            if (*p == ',') { ++p; continue; }
+            if (*p == ']') return true;
+            return false;
+        }
+    }
+
+    namespace {
+        // from 이후 처음 나오는 이름이 key인 멤버 값의 [at, at+len). 없으면 false.
+        bool find_member(std::string_view json, size_t from, std::string_view key, size_t& at, size_t& len) {
+            const char* base = json.data();
+            const char* end = base + json.size();
+            const char* p = base + from;
+            while (p < end) {
+                if (*p != '"') { ++p; continue; }
+                std::string_view raw; bool esc;
+                if (!scan_string(p, end, raw, esc)) return false;
+                const char* q = skip_ws(p, end);
+                if (q >= end || *q != ':' || esc || raw != key) continue;
+
+                const char* v = skip_ws(q + 1, end);
+                const char* v_end = v;
+                if (v < end && *v == '"') { if (!scan_string(v_end, end, raw, esc)) return false; }
+                else if (v < end && (*v == '{' || *v == '[')) { if (!skip_container(v_end, end)) return false; }
+                else v_end = scan_scalar(v, end);
+                if (v_end == v) return false;
+                at = static_cast<size_t>(v - base);
+                len = static_cast<size_t>(v_end - v);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    std::string_view JsonFindMember(std::string_view json, std::string_view key) {
+        size_t at = 0, len = 0;
+        if (!find_member(json, 0, key, at, len)) return std::string_view();
+        return json.substr(at, len);
+    }
+
+    size_t JsonSetMember(std::string& json, std::string_view key, std::string_view raw_value) {
+        size_t replaced = 0;
+        size_t at = 0, len = 0;
+        for (size_t from = 0; find_member(json, from, key, at, len); from = at + raw_value.size()) {
+            json.replace(at, len, raw_value.data(), raw_value.size());
+            ++replaced;
+        }
+        return replaced;
+    }
+
+    size_t JsonMapMembers(std::string& json, std::string_view key,
+                          const std::function<std::string(std::string_view raw)>& map) {
+        size_t replaced = 0;
+        size_t at = 0, len = 0;
+        for (size_t from = 0; find_member(json, from, key, at, len); ) {
+            const std::string value = map(std::string_view(json).substr(at, len));
+            json.replace(at, len, value);
+            from = at + value.size();
+            ++replaced;
+        }
+        return replaced;
+    }
+
+    // ─────────────────────────── reader ─────────────────────────────
+    bool JsonReader::Parse(std::string_view frame) {
+        m_members.clear();
+        m_arena.clear();
+        const char* p = frame.data();
+        const char* end = p + frame.size();
+        p = skip_ws(p, end);
+        if (p >= end || *p != '{') return false;
+        ++p;
+        p = skip_ws(p, end);
+        if (p < end && *p == '}') return true;
+        for (;;) {
+            p = skip_ws(p, end);
+            if (p >= end || *p != '"') return false;
+            Member m;
+            bool esc;
+            if (!scan_string(p, end, m.key, esc)) return false;
+            if (esc) {
+                m_arena.emplace_back();
+                JsonUnescape(m.key, m_arena.back());
+                m.key = m_arena.back();
+            }
+            p = skip_ws(p, end);
+            if (p >= end || *p != ':') return false;
+            p = skip_ws(p + 1, end);
+            if (p >= end) return false;
+
+            const char* v = p;
+            switch (*p) {
+            case '"':
+                m.kind = 's';
+                if (!scan_string(p, end, m.value, esc)) return false;
+                if (esc) {
+                    m_arena.emplace_back();
+                    JsonUnescape(m.value, m_arena.back());
+                    m.value = m_arena.back();
+                }
+                break;
+            case '{': case '[':
+                m.kind = *p;
+                if (!skip_container(p, end)) return false;
+                m.value = std::string_view(v, static_cast<size_t>(p - v));
+                break;
+            default:
+                p = scan_scalar(p, end);
+                if (p == v) return false;
+                m.value = std::string_view(v, static_cast<size_t>(p - v));
+                m.kind = (*v == 't') ? 't' : (*v == 'f') ? 'f' : (*v == 'n') ? 'z' : 'n';
+                break;
+            }
+            m_members.push_back(m);
+
+            p = skip_ws(p, end);
+            if (p >= end) return false;
+            if (*p == ',') { ++p; continue; }
+            if (*p == '}') return true;
+            return false;
+        }
+    }
+
+    // 중복 키는 마지막 값 (JSON.parse와 동일)
+    const JsonReader::Member* JsonReader::Find(std::string_view key) const {
+        for (size_t i = m_members.size(); i-- > 0;) {
+            if (m_members[i].key == key) return &m_members[i];
+        }
+        return nullptr;
+    }
+
+    std::string_view JsonReader::String(std::string_view key, std::string_view dflt) const {
+        const Member* m = Find(key);
+        return (m && m->kind == 's') ? m->value : dflt;
+    }
+
+    long long JsonReader::Number(std::string_view key, long long dflt) const {
+        const Member* m = Find(key);
+        if (!m || m->kind != 'n') return dflt;
+        long long v = 0;
+        const auto r = std::from_chars(m->value.data(), m->value.data() + m->value.size(), v);
+        return (r.ec == std::errc()) ? v : dflt;
+    }
+
+    double JsonReader::Double(std::string_view key, double dflt) const {
+        const Member* m = Find(key);
+        if (!m || m->kind != 'n') return dflt;
+        const std::string tmp(m->value); // strtod needs a terminator
+        char* e = nullptr;
+        const double v = std::strtod(tmp.c_str(), &e);
+        return (e && e != tmp.c_str()) ? v : dflt;
+    }
+
+    bool JsonReader::Bool(std::string_view key, bool dflt) const {
+        const Member* m = Find(key);
+        if (!m) return dflt;
+        if (m->kind == 't') return true;
+        if (m->kind == 'f') return false;
+        return dflt;
+    }
+
+    std::string_view JsonReader::Raw(std::string_view key) const {
+        const Member* m = Find(key);
+        return m ? m->value : std::string_view();
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AppUtils {
+
+// 호스트와 DLL이 함께 쓰는 JSON 유틸.
+// - JsonReader: 한 프레임(최상위 객체)을 한 번만 훑어 멤버 표를 만듭니다.
+//   escape가 없는 문자열은 프레임 버퍼를 가리키는 string_view 그대로,
+//   escape(\uXXXX 포함)가 있는 것만 풀어서 내부 arena에 보관합니다.
+// - 따옴표/역슬래시/제어 문자 탐색은 NEON(ARM64) / SSE2(x64) 16바이트 단위, 그 외는 스칼라.
+
+// [p, p+n)에서 처음 나오는 '"', '\\', 또는 0x20 미만 바이트의 위치 (없으면 n)
+size_t JsonFindSpecial(const char* p, size_t n);
+
+// JSON 문자열 내용으로 escape해서 out 뒤에 붙임 (따옴표는 붙이지 않음)
+void JsonAppendEscaped(std::string& out, std::string_view s);
+std::string JsonEscape(std::string_view s);
+
+// 따옴표 안쪽 raw 텍스트를 unescape. 잘못된 escape는 문자 그대로, 짝 없는 surrogate는 U+FFFD.
+void JsonUnescape(std::string_view raw, std::string& out);
+
+// UTF-8 한 코드 포인트. JSON 문자열과 본문 문장 분리(SentenceSplitter)가 같은 코드를 씁니다.
+// Utf8Decode: text[i]에서 하나를 읽고 소비한 바이트 수를 돌려줌 (i < text.size()). 깨진 바이트는 U+FFFD 1바이트.
+void Utf8Append(std::string& out, uint32_t cp);
+size_t Utf8Decode(std::string_view text, size_t i, uint32_t& cp);
+
+// [ "a", "b", ... ] — 문자열만 모음(숫자/불리언 등은 건너뜀). 배열 뒤의 텍스트는 무시.
+bool JsonParseStringArray(std::string_view text, std::vector<std::string>& out);
+
+// 깊이와 상관없이 이름이 key인 멤버를 찾아 값 원문(문자열이면 따옴표 포함)을 돌려줌. 없으면 빈 view.
+// genie_config.json처럼 튜닝 키 이름이 문서 안에서 유일한 설정을 읽고 고칠 때 씁니다.
+std::string_view JsonFindMember(std::string_view json, std::string_view key);
+// 이름이 key인 멤버 값을 모두 raw_value(JSON 원문)로 바꿈. 바꾼 개수를 돌려줌.
+size_t JsonSetMember(std::string& json, std::string_view key, std::string_view raw_value);
+// 이름이 key인 멤버마다 값 원문을 map(원문)의 결과로 바꿈 (여러 엔진의 ctx-bins처럼 값이 서로 다를 때).
+size_t JsonMapMembers(std::string& json, std::string_view key,
+                      const std::function<std::string(std::string_view raw)>& map);
+
+class JsonReader {
+public:
+  // frame은 reader보다 오래 살아야 합니다 (반환되는 view가 frame을 가리킴).
+  // 최상위가 객체가 아니거나 깨져 있으면 false.
+  bool Parse(std::string_view frame);
+  bool Parse(const char* frame) { return Parse(std::string_view(frame)); }
+  bool Parse(std::string&&) = delete; // 임시 문자열은 Parse가 끝나면 사라짐
+
+  bool Has(std::string_view key) const { return Find(key) != nullptr; }
+
+  // 문자열 멤버 (unescape 완료). 없거나 문자열이 아니면 dflt.
+  std::string_view String(std::string_view key, std::string_view dflt = std::string_view()) const;
+  long long Number(std::string_view key, long long dflt) const;
+  double Double(std::string_view key, double dflt) const;
+  bool Bool(std::string_view key, bool dflt = false) const;
+  // 값 텍스트: 중첩 객체/배열·숫자는 원문 그대로, 문자열은 unescape된 내용
+  std::string_view Raw(std::string_view key) const;
+
+private:
+  struct Member {
+    std::string_view key;
+    std::string_view value; // 문자열이면 unescape된 내용, 아니면 원문
+    char kind;              // 's' string, 'n' number, 't' / 'f' bool, 'z' null, '{', '['
+  };
+  const Member* Find(std::string_view key) const;
+
+  std::vector<Member>     m_members;
+  std::deque<std::string> m_arena; // unescape된 문자열 (주소 고정)
+};
+
+} // namespace AppUtils
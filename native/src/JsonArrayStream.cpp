@@ -0,0 +1,42 @@
+#include "JsonArrayStream.hpp"
+
+#include "Json.hpp"
+
+namespace AppUtils {
+
+    void JsonArrayStream::Feed(const char* chunk) {
+        if (!chunk || m_closed) return;
+        for (const char* p = chunk; *p; ++p) {
+            const char c = *p;
+
+            if (m_in_str) {
+                if (m_escape) {
+                    m_escape = false;
+                    m_raw.push_back(c);
+                    continue;
+                }
+                if (c == '\\') { m_escape = true; m_raw.push_back(c); continue; }
+                if (c == '"') {
+                    m_in_str = false;
+                    if (m_depth == 1) {
+                        JsonUnescape(m_raw, m_cur);
+                        if (m_on_element) m_on_element(m_count, m_cur);
+                        ++m_count;
+                    }
+                    m_raw.clear();
+                    continue;
+                }
+                m_raw.push_back(c);
+                continue;
+            }
+
+            if (c == '[') { ++m_depth; continue; }
+            if (c == ']') {
+                if (m_depth > 0 && --m_depth == 0) { m_closed = true; return; }
+                continue;
+            }
+            if (c == '"' && m_depth >= 1) { m_in_str = true; m_raw.clear(); }
+        }
+    }
+
+} // namespace AppUtils
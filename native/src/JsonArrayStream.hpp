@@ -0,0 +1,32 @@
+#pragma once
+#include <functional>
+#include <string>
+
+namespace AppUtils {
+
+// 모델 출력 청크를 받아 최상위 JSON 배열의 문자열 원소가 닫히는 즉시 콜백.
+// 0번 원소 = tone flag, 1.. = 대안 문장. 배열 앞뒤의 잡음은 무시합니다.
+// 원소는 escape된 채 모았다가 닫힐 때 JsonUnescape로 풉니다 (\uXXXX가 청크 경계에 걸려도 같은 결과).
+class JsonArrayStream {
+public:
+  using ElementFn = std::function<void(int index, const std::string& element_utf8)>;
+
+  explicit JsonArrayStream(ElementFn on_element) : m_on_element(std::move(on_element)) {}
+
+  void Feed(const char* chunk);
+
+  int  Elements() const { return m_count; }
+  bool Closed()   const { return m_closed; }
+
+private:
+  ElementFn   m_on_element;
+  std::string m_raw;        // 지금 원소의 escape된 원문
+  std::string m_cur;        // 닫힌 원소 (unescape 완료)
+  int  m_depth = 0;
+  int  m_count = 0;
+  bool m_in_str = false;
+  bool m_escape = false;
+  bool m_closed = false;
+};
+
+} // namespace AppUtils
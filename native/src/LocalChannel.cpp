@@ -0,0 +1,347 @@
+#include "LocalChannel.hpp"
+
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <cwctype>
+#include <sddl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace AppUtils {
+
+#ifdef _WIN32
+
+    namespace {
+        constexpr DWORD kPipeBuffer = 64u << 10;
+
+        std::wstring Widen(const std::string& s) {
+            if (s.empty()) return std::wstring();
+            const int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+            std::wstring w(static_cast<size_t>(n), L'\0');
+            MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), &w[0], n);
+            return w;
+        }
+
+        // overlapped 핸들에서 동기 I/O 한 번. done = 옮긴 바이트 (0이면 EOF·오류).
+        bool Io(HANDLE h, HANDLE ev, bool write, void* p, DWORD n, DWORD& done) {
+            done = 0;
+            OVERLAPPED ov{};
+            ov.hEvent = ev;
+            const BOOL ok = write ? WriteFile(h, p, n, nullptr, &ov) : ReadFile(h, p, n, nullptr, &ov);
+            if (!ok && GetLastError() != ERROR_IO_PENDING) return false;
+            return GetOverlappedResult(h, &ov, &done, TRUE) && done > 0;
+        }
+
+        // 프로세스 토큰의 TOKEN_USER (실패하면 빈 문자열)
+        std::string TokenUserOf(HANDLE process) {
+            HANDLE token = nullptr;
+            if (!OpenProcessToken(process, TOKEN_QUERY, &token)) return std::string();
+            DWORD size = 0;
+            GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+            std::string buf(size, '\0');
+            if (!size || !GetTokenInformation(token, TokenUser, &buf[0], size, &size)) buf.clear();
+            CloseHandle(token);
+            return buf;
+        }
+
+        PSID SidOf(std::string& token_user) { return reinterpret_cast<TOKEN_USER*>(&token_user[0])->User.Sid; }
+
+        // "D:P(A;;GA;;;<현재 사용자 SID>)" — 다른 계정은 파이프를 열 수 없음
+        void* UserOnlySecurity() {
+            std::string user = TokenUserOf(GetCurrentProcess());
+            void* sd = nullptr;
+            LPWSTR sid = nullptr;
+            if (!user.empty() && ConvertSidToStringSidW(SidOf(user), &sid)) {
+                const std::wstring sddl = L"D:P(A;;GA;;;" + std::wstring(sid) + L")";
+                if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1, &sd, nullptr))
+                    sd = nullptr;
+                LocalFree(sid);
+            }
+            return sd;
+        }
+
+        // 파이프를 만든 서버가 같은 사용자인지. 다른 계정이 먼저 같은 이름의 파이프를 만들어 두었으면
+        // 메일 본문을 보내기 전에 거부 (서버 프로세스를 열 수 없어도 거부).
+        bool ServerIsCurrentUser(HANDLE pipe) {
+            ULONG pid = 0;
+            if (!GetNamedPipeServerProcessId(pipe, &pid)) return false;
+            HANDLE proc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+            if (!proc) return false;
+            std::string theirs = TokenUserOf(proc);
+            CloseHandle(proc);
+            std::string ours = TokenUserOf(GetCurrentProcess());
+            return !theirs.empty() && !ours.empty() && EqualSid(SidOf(theirs), SidOf(ours));
+        }
+    } // namespace
+
+    std::string LocalAddress(const std::string& name) {
+        wchar_t user[128]{};
+        const DWORD n = GetEnvironmentVariableW(L"USERNAME", user, 128);
+        std::string u;
+        for (DWORD i = 0; i < n && i < 128; ++i) {
+            const wchar_t c = user[i];
+            u += (c < 128 && (iswalnum(c) || c == L'-' || c == L'.')) ? static_cast<char>(c) : '_';
+        }
+        return "\\\\.\\pipe\\" + name + "-" + (u.empty() ? std::string("user") : u);
+    }
+
+    LocalStream::LocalStream(HANDLE h)
+        : m_h(h),
+          m_read_event(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+          m_write_event(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+
+    LocalStream::~LocalStream() {
+        if (m_h != INVALID_HANDLE_VALUE) CloseHandle(m_h);
+        if (m_read_event) CloseHandle(m_read_event);
+        if (m_write_event) CloseHandle(m_write_event);
+    }
+
+    std::unique_ptr<LocalStream> LocalStream::Connect(const std::string& address) {
+        const std::wstring w = Widen(address);
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            HANDLE h = CreateFileW(w.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr);
+            if (h != INVALID_HANDLE_VALUE) {
+                if (ServerIsCurrentUser(h)) return std::make_unique<LocalStream>(h);
+                CloseHandle(h);
+                return nullptr;
+            }
+            if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(w.c_str(), 2000)) break;
+        }
+        return nullptr;
+    }
+
+    size_t LocalStream::ReadSome(void* p, size_t n) {
+        if (m_shut.load()) return 0;
+        DWORD got = 0;
+        return Io(m_h, m_read_event, false, p, static_cast<DWORD>(n), got) ? got : 0;
+    }
+
+    bool LocalStream::Read(void* p, size_t n) {
+        char* c = static_cast<char*>(p);
+        while (n > 0) {
+            const size_t got = ReadSome(c, n);
+            if (got == 0) return false;
+            c += got; n -= got;
+        }
+        return true;
+    }
+
+    bool LocalStream::Write(const void* p, size_t n) {
+        const char* c = static_cast<const char*>(p);
+        while (n > 0) {
+            if (m_shut.load()) return false;
+            DWORD wrote = 0;
+            if (!Io(m_h, m_write_event, true, const_cast<char*>(c), static_cast<DWORD>(n), wrote)) return false;
+            c += wrote; n -= wrote;
+        }
+        return true;
+    }
+
+    void LocalStream::Shutdown() {
+        m_shut = true;
+        CancelIoEx(m_h, nullptr);
+    }
+
+    bool LocalListener::Arm() {
+        SECURITY_ATTRIBUTES sa{};
+        sa.nLength = sizeof(sa);
+        sa.lpSecurityDescriptor = m_security;
+        m_pipe = CreateNamedPipeW(Widen(m_address).c_str(),
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (m_first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, kPipeBuffer, kPipeBuffer, 0, m_security ? &sa : nullptr);
+        if (m_pipe == INVALID_HANDLE_VALUE) return false;
+        m_first = false;
+        m_ov = OVERLAPPED{};
+        m_ov.hEvent = m_event;
+        ResetEvent(m_event);
+        m_ready = false;
+        m_pending = false;
+        if (!ConnectNamedPipe(m_pipe, &m_ov)) {
+            const DWORD err = GetLastError();
+            if (err == ERROR_PIPE_CONNECTED) { m_ready = true; SetEvent(m_event); }
+            else if (err == ERROR_IO_PENDING) m_pending = true;
+            else { CloseHandle(m_pipe); m_pipe = INVALID_HANDLE_VALUE; return false; }
+        }
+        return true;
+    }
+
+    bool LocalListener::Listen(const std::string& address) {
+        Close();
+        m_address = address;
+        m_first = true;
+        m_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        m_security = UserOnlySecurity();
+        return m_event && Arm(); // FILE_FLAG_FIRST_PIPE_INSTANCE: 다른 데몬이 있으면 실패
+    }
+
+    std::unique_ptr<LocalStream> LocalListener::Accept(uint32_t timeout_ms) {
+        if (m_pipe == INVALID_HANDLE_VALUE && !Arm()) { Sleep(timeout_ms); return nullptr; }
+        if (WaitForSingleObject(m_event, timeout_ms) != WAIT_OBJECT_0) return nullptr;
+        DWORD unused = 0;
+        const bool ok = m_ready || GetOverlappedResult(m_pipe, &m_ov, &unused, FALSE);
+        HANDLE h = m_pipe;
+        m_pipe = INVALID_HANDLE_VALUE;
+        m_pending = false;
+        Arm();
+        if (!ok) { CloseHandle(h); return nullptr; }
+        return std::make_unique<LocalStream>(h);
+    }
+
+    void LocalListener::Close() {
+        if (m_pipe != INVALID_HANDLE_VALUE) {
+            if (m_pending) {
+                DWORD unused = 0;
+                CancelIoEx(m_pipe, &m_ov);
+                GetOverlappedResult(m_pipe, &m_ov, &unused, TRUE);
+            }
+            CloseHandle(m_pipe);
+            m_pipe = INVALID_HANDLE_VALUE;
+        }
+        m_pending = false;
+        if (m_event) { CloseHandle(m_event); m_event = nullptr; }
+        if (m_security) { LocalFree(m_security); m_security = nullptr; }
+    }
+
+#else
+
+    namespace {
+        bool FillAddr(const std::string& path, sockaddr_un& sa) {
+            sa = sockaddr_un{};
+            sa.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(sa.sun_path)) return false;
+            path.copy(sa.sun_path, path.size());
+            return true;
+        }
+
+        // 연결 상대 프로세스가 같은 uid인지 (양쪽 모두 검사: 서버는 클라이언트를, 클라이언트는 서버를)
+        bool PeerIsCurrentUser(int fd) {
+            ucred cred{};
+            socklen_t len = sizeof(cred);
+            return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == ::getuid();
+        }
+
+        // 소켓 파일이 놓일 디렉터리가 이 사용자 전용인지 (없으면 0700으로 만듦). 심볼릭 링크,
+        // 다른 사용자의 디렉터리, 그룹/기타 권한이 있는 디렉터리(공용 /tmp 자체 포함)는 거부.
+        bool PrivateParentDir(const std::string& path) {
+            const size_t slash = path.rfind('/');
+            const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+            if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return false;
+            struct stat st {};
+            return ::lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == ::getuid() &&
+                (st.st_mode & 077) == 0;
+        }
+    } // namespace
+
+    std::string LocalAddress(const std::string& name) {
+        const char* rt = std::getenv("XDG_RUNTIME_DIR"); // 0700, 사용자 전용
+        if (rt && *rt) return std::string(rt) + "/" + name + ".sock";
+        return "/tmp/" + name + "-" + std::to_string(::getuid()) + "/" + name + ".sock"; // 디렉터리는 Listen이 0700으로
+    }
+
+    LocalStream::LocalStream(int fd) : m_fd(fd) {}
+
+    LocalStream::~LocalStream() {
+        if (m_fd >= 0) ::close(m_fd);
+    }
+
+    std::unique_ptr<LocalStream> LocalStream::Connect(const std::string& address) {
+        sockaddr_un sa;
+        if (!FillAddr(address, sa)) return nullptr;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return nullptr;
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0 || !PeerIsCurrentUser(fd)) {
+            ::close(fd);
+            return nullptr;
+        }
+        return std::make_unique<LocalStream>(fd);
+    }
+
+    size_t LocalStream::ReadSome(void* p, size_t n) {
+        for (;;) {
+            if (m_shut.load()) return 0;
+            const ssize_t got = ::read(m_fd, p, n);
+            if (got > 0) return static_cast<size_t>(got);
+            if (got < 0 && errno == EINTR) continue;
+            return 0;
+        }
+    }
+
+    bool LocalStream::Read(void* p, size_t n) {
+        char* c = static_cast<char*>(p);
+        while (n > 0) {
+            const size_t got = ReadSome(c, n);
+            if (got == 0) return false;
+            c += got; n -= got;
+        }
+        return true;
+    }
+
+    bool LocalStream::Write(const void* p, size_t n) {
+        const char* c = static_cast<const char*>(p);
+        while (n > 0) {
+            if (m_shut.load()) return false;
+            const ssize_t wrote = ::send(m_fd, c, n, MSG_NOSIGNAL); // 끊긴 피어: SIGPIPE 대신 EPIPE
+            if (wrote < 0 && errno == EINTR) continue;
+            if (wrote <= 0) return false;
+            c += wrote; n -= static_cast<size_t>(wrote);
+        }
+        return true;
+    }
+
+    void LocalStream::Shutdown() {
+        m_shut = true;
+        ::shutdown(m_fd, SHUT_RDWR);
+    }
+
+    bool LocalListener::Listen(const std::string& address) {
+        Close();
+        sockaddr_un sa;
+        if (!FillAddr(address, sa)) return false;
+        if (!PrivateParentDir(address)) return false;
+        // 잠금을 쥔 쪽만 (남은) 소켓 파일을 지우고 bind — 동시에 뜬 두 데몬이 서로를 지우지 않도록
+        m_lock_fd = ::open((address + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+        if (m_lock_fd < 0 || ::flock(m_lock_fd, LOCK_EX | LOCK_NB) != 0) { Close(); return false; }
+        ::unlink(address.c_str());
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_fd < 0) { Close(); return false; }
+        const mode_t old = ::umask(0077); // 소켓 파일 0600
+        const bool bound = ::bind(m_fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) == 0;
+        ::umask(old);
+        if (!bound || ::listen(m_fd, 16) != 0) { Close(); return false; }
+        m_address = address;
+        return true;
+    }
+
+    std::unique_ptr<LocalStream> LocalListener::Accept(uint32_t timeout_ms) {
+        if (m_fd < 0) return nullptr;
+        pollfd pfd{ m_fd, POLLIN, 0 };
+        if (::poll(&pfd, 1, static_cast<int>(timeout_ms)) <= 0) return nullptr;
+        const int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) return nullptr;
+        if (!PeerIsCurrentUser(fd)) {
+            ::close(fd);
+            return nullptr;
+        }
+        return std::make_unique<LocalStream>(fd);
+    }
+
+    void LocalListener::Close() {
+        if (m_fd >= 0) { ::close(m_fd); m_fd = -1; }
+        if (!m_address.empty()) { ::unlink(m_address.c_str()); m_address.clear(); }
+        if (m_lock_fd >= 0) { ::close(m_lock_fd); m_lock_fd = -1; } // 잠금 파일은 남김 (지우면 잠금 경쟁)
+    }
+
+#endif
+
+} // namespace AppUtils
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace AppUtils {
+
+// 같은 사용자 프로세스끼리의 로컬 바이트 스트림: Linux는 Unix 도메인 소켓, Windows는 named pipe.
+// 프레이밍은 호출자 몫 (호스트는 Native Messaging과 같은 4바이트 길이 + JSON을 그대로 씀).
+// 한 스레드가 읽고 다른 스레드가 쓰는 전이중 사용을 지원합니다 (Windows는 overlapped I/O).
+
+// 사용자별 주소. name: 영숫자/'-'/'.'만.
+//   Linux  : $XDG_RUNTIME_DIR/<name>.sock, 없으면 /tmp/<name>-<uid>/<name>.sock (0700 디렉터리)
+//   Windows: \\.\pipe\<name>-<사용자 이름>
+std::string LocalAddress(const std::string& name);
+
+class LocalStream {
+public:
+#ifdef _WIN32
+  explicit LocalStream(HANDLE h);
+#else
+  explicit LocalStream(int fd);
+#endif
+  LocalStream(const LocalStream&) = delete;
+  LocalStream& operator=(const LocalStream&) = delete;
+  ~LocalStream();
+
+  // 서버(데몬)에 연결. 없거나 받아 주지 않거나 서버가 다른 사용자의 프로세스면 nullptr.
+  static std::unique_ptr<LocalStream> Connect(const std::string& address);
+
+  // 정확히 n바이트 (EOF·오류면 false)
+  bool Read(void* p, size_t n);
+  // 도착한 만큼 (최대 n). 0 = EOF·오류
+  size_t ReadSome(void* p, size_t n);
+  bool Write(const void* p, size_t n);
+  // 다른 스레드에서 대기 중인 Read/Write를 깨워 실패시킴. 핸들 해제는 소멸자.
+  void Shutdown();
+
+private:
+  std::atomic<bool> m_shut{ false };
+#ifdef _WIN32
+  HANDLE m_h = INVALID_HANDLE_VALUE;
+  HANDLE m_read_event = nullptr, m_write_event = nullptr;
+#else
+  int m_fd = -1;
+#endif
+};
+
+// 데몬 쪽. 주소 하나에 리스너는 하나만 (두 번째 데몬의 Listen은 false).
+class LocalListener {
+public:
+  LocalListener() = default;
+  LocalListener(const LocalListener&) = delete;
+  LocalListener& operator=(const LocalListener&) = delete;
+  ~LocalListener() { Close(); }
+
+  // 현재 사용자만 연결 가능 (소켓 0600 / 파이프 DACL, 원격 클라이언트 거부).
+  // Linux: 소켓 파일의 디렉터리가 사용자 전용(0700, 본인 소유)이 아니면 false — 없으면 만듦.
+  bool Listen(const std::string& address);
+  // timeout_ms 안에 들어온 연결, 없으면 nullptr
+  std::unique_ptr<LocalStream> Accept(uint32_t timeout_ms);
+  void Close();
+
+private:
+  std::string m_address;
+#ifdef _WIN32
+  bool Arm();                       // 다음 연결을 받을 파이프 인스턴스
+  HANDLE m_pipe = INVALID_HANDLE_VALUE;
+  HANDLE m_event = nullptr;
+  OVERLAPPED m_ov{};
+  bool   m_pending = false;         // ConnectNamedPipe 진행 중
+  bool   m_ready = false;           // Arm 사이에 이미 연결됨 (ERROR_PIPE_CONNECTED)
+  void*  m_security = nullptr;      // SECURITY_DESCRIPTOR (LocalFree)
+  bool   m_first = true;
+#else
+  int m_fd = -1;
+  int m_lock_fd = -1;               // <address>.lock — 데몬 하나만
+#endif
+};
+
+} // namespace AppUtils
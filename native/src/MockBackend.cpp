@@ -0,0 +1,204 @@
+#include "InferenceBackend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Json.hpp"
+
+namespace fs = std::filesystem;
+
+namespace AppUtils {
+
+    // 모델 없이 결정적인 응답을 재생하는 백엔드 (Linux 빌드 에이전트, 파이프라인 성능 측정용).
+    //   "backend": {"type": "mock", "mock": {
+    //       "token-us": 20000,            토큰 하나 디코딩 시간
+    //       "prefill-us": 0,              질의마다 고정 prefill 시간
+    //       "prefill-us-per-byte": 40,    KV에 없던 프롬프트 바이트당 prefill 시간
+    //       "context-size": 2048,
+    //       "load-ms": 0,                 Load에 걸리는 시간 (모델 로딩 흉내)
+    //       "outputs": ["[\"impolite\",\"...\"]", ...]   순서대로 돌려가며 재생 (없으면 Target으로 합성)
+    //       "draft": {"draft-len": 6, "token-us": 2000, "accept": 0.8, "seed": 1}
+    //                                     (선택) 추측 디코딩 흉내: 패스마다 draft-len × token-us(draft) +
+    //                                     token-us(target 검증 1회)를 쓰고, 토큰마다 accept 확률로 앞에서부터
+    //                                     받아들인 개수 + 1개를 내보냄
+    //   }}
+    // REWIND는 실제 엔진처럼 직전 KV 텍스트와 공통 prefix만큼 prefill을 건너뜁니다.
+    class MockBackend final : public InferenceBackend {
+    public:
+        const char* Name() const override { return "mock"; }
+
+        bool Load(const std::string& config_json, const std::string&, std::string& err) override {
+            const std::string options = InferenceBackendOptions(config_json, "mock"); // opts의 view가 가리킴
+            JsonReader opts;
+            if (!opts.Parse(options)) {
+                err = "backend.mock options are not a JSON object";
+                return false;
+            }
+            m_token_us = std::max(0LL, opts.Number("token-us", 20000));
+            m_prefill_us = std::max(0LL, opts.Number("prefill-us", 0));
+            m_prefill_us_per_byte = std::max(0LL, opts.Number("prefill-us-per-byte", 40));
+            m_ctx_tokens = static_cast<uint32_t>(std::max(0LL, opts.Number("context-size", 2048)));
+            m_outputs.clear();
+            if (opts.Has("outputs")) JsonParseStringArray(opts.Raw("outputs"), m_outputs);
+            JsonReader draft;
+            m_draft_len = 0;
+            if (draft.Parse(opts.Raw("draft"))) {
+                m_draft_len = static_cast<uint32_t>(std::min(16LL, std::max(1LL, draft.Number("draft-len", 6))));
+                m_draft_us = std::max(0LL, draft.Number("token-us", 2000));
+                m_accept = std::bernoulli_distribution(std::min(1.0, std::max(0.0, draft.Double("accept", 0.8))));
+                m_rng.seed(static_cast<uint32_t>(draft.Number("seed", 1)));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::max(0LL, opts.Number("load-ms", 0))));
+            return true;
+        }
+
+        uint32_t ContextTokens() const override { return m_ctx_tokens; }
+
+        bool Prefill(const std::string& prompt) override {
+            m_abort = false;
+            const bool ok = Spend(PrefillUs(prompt, true));
+            if (ok) m_kv = prompt;
+            return ok;
+        }
+
+        // Prefill이 이미 공통 prefix를 재사용
+        bool PrefillRewind(const std::string& prompt) override { return Prefill(prompt); }
+
+        bool Generate(const std::string& prompt, bool rewind, TokenCallback on_piece, void* user) override {
+            m_abort = false;
+            m_last = DecodeStats();
+            if (!Spend(PrefillUs(prompt, rewind))) return false;
+            m_kv = prompt;
+
+            const std::string answer = m_outputs.empty() ? Synthesize(prompt) : m_outputs[m_next++ % m_outputs.size()];
+            uint32_t tokens = 0;
+            size_t i = 0;
+            auto emit = [&]() { // false = 끝
+                if (i >= answer.size() || (m_max_tokens && tokens >= m_max_tokens)) return false;
+                const size_t n = PieceLength(answer, i);
+                const std::string piece = answer.substr(i, n);
+                m_kv += piece;
+                ++tokens;
+                i += n;
+                return on_piece(piece.c_str(), user);
+            };
+            for (;;) {
+                if (i >= answer.size() || (m_max_tokens && tokens >= m_max_tokens)) break;
+                if (!m_draft_len) {
+                    if (!Spend(m_token_us)) return false;
+                    ++m_last.passes;
+                    if (!emit()) break;
+                    continue;
+                }
+                if (!Spend(m_draft_len * m_draft_us + m_token_us)) return false;
+                ++m_last.passes;
+                m_last.drafted += m_draft_len;
+                uint32_t ok = 0;
+                while (ok < m_draft_len && m_accept(m_rng)) ++ok;
+                bool go = true;
+                for (uint32_t k = 0; go && k <= ok; ++k) {
+                    go = emit();
+                    if (go && k < ok) ++m_last.accepted;
+                }
+                if (!go) break;
+            }
+            return true;
+        }
+
+        void SetMaxTokens(uint32_t n) override { m_max_tokens = n; }
+        bool Reset() override { m_kv.clear(); return true; }
+
+        bool Save(const std::string& dir) override {
+            std::ofstream out(fs::u8path(dir) / "mock_kv.txt", std::ios::binary | std::ios::trunc);
+            out.write(m_kv.data(), static_cast<std::streamsize>(m_kv.size()));
+            return static_cast<bool>(out);
+        }
+
+        bool Restore(const std::string& dir) override {
+            std::ifstream in(fs::u8path(dir) / "mock_kv.txt", std::ios::binary);
+            if (!in) return false;
+            m_kv.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        void Abort() override { m_abort = true; }
+
+        bool Speculative() const override { return m_draft_len > 0; }
+        DecodeStats LastDecode() const override { return m_last; }
+
+    private:
+        long long PrefillUs(const std::string& prompt, bool rewind) const {
+            size_t reused = 0;
+            if (rewind) {
+                const size_t n = std::min(prompt.size(), m_kv.size());
+                while (reused < n && prompt[reused] == m_kv[reused]) ++reused;
+            }
+            return m_prefill_us + m_prefill_us_per_byte * static_cast<long long>(prompt.size() - reused);
+        }
+
+        // 2ms 단위로 쪼개 자면서 Abort를 확인. 중단되면 false.
+        bool Spend(long long us) {
+            const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+            for (;;) {
+                if (m_abort.load()) return false;
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= until) return true;
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(until - now, std::chrono::milliseconds(2)));
+            }
+        }
+
+        // 토큰 ≈ ASCII 4바이트 또는 비ASCII 한 글자 (UTF-8 경계 유지)
+        static size_t PieceLength(const std::string& s, size_t i) {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x80) {
+                size_t n = 1;
+                while (i + n < s.size() && (static_cast<unsigned char>(s[i + n]) & 0xC0) == 0x80) ++n;
+                return n;
+            }
+            size_t n = 0;
+            while (i + n < s.size() && n < 4 && static_cast<unsigned char>(s[i + n]) < 0x80) ++n;
+            return n;
+        }
+
+        // 프롬프트 마지막 "Target: " 줄로 네 원소 배열을 만듦
+        static std::string Synthesize(const std::string& prompt) {
+            std::string target;
+            const size_t at = prompt.rfind("Target: ");
+            if (at != std::string::npos) {
+                const size_t from = at + 8;
+                target = prompt.substr(from, prompt.find('\n', from) - from);
+            }
+            const std::string t = JsonEscape(target);
+            return "[\"impolite\",\"Could you please look into this: " + t +
+                "\",\"I would appreciate your help with the following: " + t +
+                "\",\"When you have a moment, " + t + "\"]";
+        }
+
+        long long                m_token_us = 20000;
+        long long                m_prefill_us = 0;
+        long long                m_prefill_us_per_byte = 40;
+        uint32_t                 m_ctx_tokens = 2048;
+        uint32_t                 m_max_tokens = 0;
+        std::vector<std::string> m_outputs;
+        size_t                   m_next = 0;
+        std::string              m_kv;     // KV에 있다고 가정하는 텍스트
+        std::atomic<bool>        m_abort{ false };
+
+        uint32_t                 m_draft_len = 0; // 0 = 추측 디코딩 없음
+        long long                m_draft_us = 2000;
+        std::bernoulli_distribution m_accept{ 0.8 };
+        std::mt19937             m_rng{ 1 };
+        DecodeStats              m_last;
+    };
+
+    std::unique_ptr<InferenceBackend> CreateMockBackend() {
+        return std::make_unique<MockBackend>();
+    }
+
+} // namespace AppUtils
@@ -1,13 +1,120 @@
 // native/src/paperClipHost.cpp — Chrome Native Messaging host + PaperClipNative.dll
 //
 // DLL exports expected (1-arg versions):
+//   uint32_t    polite_rewrite_abi_version();                      // optional; >= 2 → v2 below is used
+//   int         polite_rewrite_v2(const pr_request*, pr_result*, buf, size); // parsed spans, status codes
+//   void        polite_rewrite_result_free(pr_result*);
+//   int         polite_rewrite_batch(common, items, n, cb, user);  // optional (analyze_document)
+//   (without v2 the v1 string exports below are used and their JSON text is re-parsed)
 //   const char* generate_polite_rewrite(const char* input_utf8);
+//   const char* generate_polite_rewrite_stream(const char* in, cb, user); // optional
+//   const char* generate_polite_rewrite_ctx(target, context, session, cb, user); // optional
 //   void        polite_rewrite_free(const char* p);
 //   int         polite_rewrite_set_base_dir(const char* dir);      // optional
 //   int         polite_rewrite_set_config_path(const char* path);  // optional
+//   int         polite_rewrite_abort();                            // optional
+//   void        polite_rewrite_set_deadline_ms(uint32_t ms);       // optional
+//   const char* polite_rewrite_cache_stats();                      // optional
+//   const char* polite_rewrite_session_stats();                    // optional
+//   const char* polite_rewrite_pool_stats();                       // optional
+//   const char* polite_rewrite_decode_stats();                     // optional
+//   void        polite_rewrite_set_fastpath_threshold(double t);   // optional (env PC_FASTPATH_THRESHOLD)
+//   const char* polite_rewrite_fastpath_stats();                   // optional
+//   const char* polite_rewrite_stage_stats();                      // optional
+//   const char* polite_rewrite_warmup();                           // optional (loaded at startup)
+//   const char* polite_rewrite_bake_prefix();                      // optional (--bake-prefix)
+//   const char* generate_polite_rewrite_peek(target, cb, user);    // optional (fast path / cache only)
+//   const char* generate_polite_rewrite_cascade(target, context, session, flags, cb, user); // optional
+//   const char* polite_rewrite_cascade_stats();                    // optional
+//   int         polite_rewrite_reload();                           // optional (hot reload)
+//   int         polite_rewrite_prefill_hint(const pr_request*);    // optional (prefill hints)
+//   const char* polite_rewrite_hint_stats();                       // optional
+//   const char* polite_rewrite_reload_stats();                     // optional
 //
-// Request : {"type":"analyze","focus":"...","context":"...","body":"..."}
-// Response: {"suggestions":[ "polite/impolite", "Suggestion1", "Suggestion2", ... ]}
+// Request : {"type":"analyze","id":n,"session":"tab:frame","focus":"...","context":"...",
+//            "body":"...","stream":true?,"deadline_ms":n?,"alternatives":true?,
+//            "language":"ko"?,"max_alternatives":n?,"max_tokens":n?,"priority":"live"?}
+//           alternatives: the user asked for rewrites — skip the tone-verdict early exit.
+//           priority: interactive (shortcut) > live (typing, default) > background (default for
+//           analyze_document). The worker runs the best class first, FIFO within a class; a running
+//           background document steps aside (and resumes later) when something more urgent arrives.
+//           deadline_ms counts from receipt, so queueing spends it; the DLL gets what is left.
+//           language / max_alternatives / max_tokens need a v2 library (ignored by v1).
+// Response: {"id":n,"suggestions":[ "polite/impolite", "Suggestion1", "Suggestion2", ... ],
+//            "tier":"fastpath"|"cache"|"verdict"|"rewrite"}
+//           + "truncated":true when the DLL hit its decode budget before the array closed.
+//           tier (cascade-capable library): verdict = tone flag only (["polite"], no rewrites
+//           decoded), rewrite = the main model wrote alternatives.
+// Error   : {"id":n,"error":"...","stage":"...","status":n} — v2 library failures (v1 failures
+//           arrive as a one-string suggestions array, as before).
+// Document: {"type":"analyze_document","id":n,"session":"tab:frame","body":"...","deadline_ms":n?,
+//            "alternatives":true?,"language":"ko"?,"max_alternatives":n?}
+//           The host splits the body into sentences (SentenceSplitter), runs each distinct sentence
+//           once in one polite_rewrite_batch call and streams, per sentence in body order of completion,
+//           {"id":n,"type":"sentence","index":i,"start":u16,"end":u16,"suggestions":[...],"tier":"..."}
+//           (start/end: UTF-16 offsets into body, i.e. JS string indices), then
+//           {"id":n,"type":"document","sentences":n,"unique":n,"flagged":n,"truncated":bool,"elapsed_ms":n}.
+//           Preemption is per session like analyze, in a lane of its own (live checks do not cancel it).
+// Stream  : {"id":n,"type":"partial","index":n,"text":"..."} per array element (stream:true),
+//           followed by the usual {"suggestions":[...]} frame.
+// Aborted : {"id":n,"type":"aborted","reason":"superseded"|"deadline"} — a newer analyze
+//           for the same session preempts queued/running work for that session. Admission
+//           rejections are deadline aborts with "admission":true,"estimate_ms":n — the learned
+//           service times say the request cannot finish in time (checked on receipt and at pickup).
+// Final suggestions/aborted frames carry "queue_us": time from receipt to worker pickup.
+// Hint    : {"type":"prefill","session":"tab:frame","focus":"<sentence so far>","context":"..."}
+//           — no reply. The sentence being typed, sent during typing pauses: when nothing else is
+//           queued the library prefills it on the instance the finished sentence will use, so that
+//           query only prefills the tail. Only the newest hint is kept; the finished sentence of the
+//           same session drops a waiting hint, and any request arriving cancels a running one.
+// Cache   : {"type":"cache_stats"} -> {"type":"cache_stats","cache":{...hit/miss counters},
+//                                      "sessions":{...context prefill reuse},
+//                                      "fastpath":{...short-circuit rate}}
+// Stats   : {"type":"stats"} -> {"type":"stats","host":{stage:{n,mean,p50,p90,p99,max}},"native":{...},
+//                                "pool":{...},"decode":{...},"cascade":{...},"queue":{...},
+//                                "reload":{...},"hints":{...}}
+//           host stages (µs): read, parse, queue, invoke, normalize, first_frame, write, total;
+//           native stages: polite_rewrite_stage_stats(); pool: polite_rewrite_pool_stats();
+//           decode: polite_rewrite_decode_stats() (speculative acceptance, effective tokens/s);
+//           cascade: polite_rewrite_cascade_stats() (answers per tier, early-exit rate);
+//           queue: depth per class, peak, admitted / superseded / rejected / yielded counts,
+//           learned service times and queue wait (µs) per class;
+//           reload: polite_rewrite_reload_stats() (generation, last reload's load time and swap point);
+//           hints: polite_rewrite_hint_stats() (prefill hints run / skipped / cancelled, hit rate,
+//           saved prefill time) plus the host's "received" / "dropped" (replaced before running).
+// Reload  : {"type":"reload"} -> {"type":"reload","state":"started"|"not_loaded"|"failed","reload":{...}}
+//           — the library loads the model/config again in the background while the current
+//           instances keep serving, then swaps (requests already running finish on the old ones).
+//           {"type":"reload_stats"} -> {"type":"reload_stats","reload":{...}}.
+// Status  : {"type":"status","state":"loading"|"ready"|"failed"|"unavailable","elapsed_ms"|"load_ms":n,
+//           "error":"..."?,"warmup":{...}?} — pushed when the background model load starts and ends,
+//           and on request; "warmup" is the library's warmup result once ready (backend, profile,
+//           prefix snapshot/prefill, prefetched_mb, pool).
+//           While loading, analyze answers that need no model (fast path / cache) go out at once;
+//           the rest wait in the queue and run when the model is ready.
+// Diag    : {"type":"diag",...} frames by level — env PC_DIAG or {"type":"set_diag","level":n}
+//           0 = off, 1 = startup / load / anomalies (default), 2 = + per-request trace.
+//
+// CLI     : PaperClipHost --bake-prefix — install-time step: loads the model, saves the
+//           post-system-prompt state beside the config (polite_rewrite_bake_prefix), prints
+//           the JSON result and exits. Uses the same PC_* environment as a browser launch.
+//           PaperClipHost --reload — asks the running daemon for a hot reload (after the model or
+//           config files were replaced), waits for it and prints the reload stats.
+//
+// Daemon  : one model per user, however many browsers. A browser-launched host is a thin client:
+//           it connects to the per-user daemon (Unix socket / named pipe, LocalChannel), starting
+//           `PaperClipHost --daemon` if none answers, and relays frames both ways unchanged. The daemon
+//           loads the DLL once — one result cache, one warmed dialog — and runs every client's
+//           requests through the same scheduler: per class, clients take turns (round robin), each
+//           client may queue at most kMaxQueuedPerClient, and sessions are scoped per client.
+//           Library calls run one at a time on the single worker thread (the pool's instances keep
+//           per-session KV, not parallel queries), and an abort — supersede, yield, client gone,
+//           hint — only reaches the request it was decided for, never the next client's. The
+//           address is keyed by executable + PC_SUGGESTION_DLL / PC_MODEL_BASE_DIR / PC_CONFIG_PATH,
+//           so differently configured hosts never share a daemon. The daemon exits after
+//           PC_DAEMON_IDLE_S (default 600) seconds without clients.
+//           Env: PC_DAEMON=0 → load the model in-process (also the fallback when no daemon can be
+//           reached); PC_DAEMON_ADDR overrides the address.
 
 #include <iostream>
 #include <string>
@@ -16,7 +123,24 @@
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "PaperClipAbi.h"
+#include "BoundedQueue.hpp"
+#include "Json.hpp"
+#include "LocalChannel.hpp"
+#include "SentenceSplitter.hpp"
+#include "StageStats.hpp"
 
 namespace fs = std::filesystem;
 
@@ -27,186 +151,320 @@ namespace fs = std::filesystem;
 #else
 #include <locale>
 #include <codecvt>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#define __cdecl
 #endif
 
 // ===================================================================
 // Native Messaging I/O
 // ===================================================================
+// Threads: reader (stdin) -> g_inbox -> worker (DLL) -> outbox -> writer (stdout).
+// The writer is the only thread that touches the framed stdout. At startup the
+// real stdout is duplicated to a private handle and fd 1 / STD_OUTPUT_HANDLE
+// are pointed at NUL for good, so DLL prints can never corrupt the framing.
+// In daemon mode every client connection has its own reader / outbox / writer and
+// shares g_inbox and the worker.
+struct Conn {
+    uint64_t id = 0;
+    std::unique_ptr<AppUtils::LocalStream> stream; // null = stdin/stdout
+    AppUtils::BoundedQueue<std::string, 256> outbox; // "" = writer stop token
+    std::atomic<bool> open{ true };
+    std::atomic<int>  queued{ 0 };  // admitted, not yet picked (per-client cap)
+    uint64_t          served = 0;   // worker only: turn of the last pick (round robin)
+};
+static std::mutex                         g_conns_mu;
+static std::vector<std::shared_ptr<Conn>> g_conns;
+static std::atomic<uint64_t>              g_frames_dropped{ 0 }; // client not reading
+// Reader: its client; worker: the running request's client; elsewhere (model load) null = all clients
+static thread_local Conn* t_conn = nullptr;
+
+// Per-stage timings (µs), recorded lock-free on the hot path and returned by {"type":"stats"}
+enum HostStage : int {
+    HS_READ, HS_PARSE, HS_QUEUE, HS_INVOKE, HS_NORMALIZE, HS_FIRST_FRAME, HS_WRITE, HS_TOTAL
+};
+static AppUtils::StageStats g_stages{ "read", "parse", "queue", "invoke", "normalize", "first_frame", "write", "total" };
+using StageClock = AppUtils::StageStats::Clock;
+
 #ifdef _WIN32
-static void ensure_binary_mode_once() {
-    static bool once = false;
-    if (!once) {
-        _setmode(_fileno(stdin), _O_BINARY);
-        _setmode(_fileno(stdout), _O_BINARY);
-        once = true;
-    }
-}
-struct StdoutSilencer {
-    int    saved_fd = -1;
-    HANDLE saved_std_handle = nullptr;
-    HANDLE hNull = nullptr;
-    StdoutSilencer() {
-        saved_std_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-        hNull = CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
-            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-        if (hNull && hNull != INVALID_HANDLE_VALUE) {
-            SetStdHandle(STD_OUTPUT_HANDLE, hNull);
-        }
-        fflush(stdout);
-        saved_fd = _dup(_fileno(stdout));
-        FILE* nul = nullptr;
-        freopen_s(&nul, "NUL", "w", stdout);
-    }
-    ~StdoutSilencer() {
-        fflush(stdout);
-        if (saved_fd != -1) {
-            _dup2(saved_fd, _fileno(stdout));
-            _close(saved_fd);
-            saved_fd = -1;
-        }
-        if (saved_std_handle) {
-            SetStdHandle(STD_OUTPUT_HANDLE, saved_std_handle);
-            saved_std_handle = nullptr;
-        }
-        if (hNull && hNull != INVALID_HANDLE_VALUE) {
-            CloseHandle(hNull);
-            hNull = nullptr;
-        }
+static HANDLE g_frame_out = INVALID_HANDLE_VALUE;
+
+static void isolate_stdout() {
+    _setmode(_fileno(stdin), _O_BINARY);
+    fflush(stdout);
+    const int fd = _dup(_fileno(stdout));
+    if (fd != -1) _setmode(fd, _O_BINARY);
+    g_frame_out = (fd != -1) ? reinterpret_cast<HANDLE>(_get_osfhandle(fd))
+                             : GetStdHandle(STD_OUTPUT_HANDLE);
+    HANDLE hNull = CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hNull && hNull != INVALID_HANDLE_VALUE) {
+        SetStdHandle(STD_OUTPUT_HANDLE, hNull); // kept open for the process lifetime
     }
-};
+    FILE* nul = nullptr;
+    freopen_s(&nul, "NUL", "w", stdout);
+}
+
+static bool write_raw(const char* p, size_t n) {
+    while (n > 0) {
+        DWORD wrote = 0;
+        if (!WriteFile(g_frame_out, p, static_cast<DWORD>(n), &wrote, nullptr) || wrote == 0) return false;
+        p += wrote; n -= wrote;
+    }
+    return true;
+}
 #else
-static void ensure_binary_mode_once() {}
+static int g_frame_fd = -1;
+
+static void isolate_stdout() {
+    fflush(stdout);
+    g_frame_fd = dup(STDOUT_FILENO);
+    const int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) { dup2(devnull, STDOUT_FILENO); close(devnull); }
+}
+
+static bool write_raw(const char* p, size_t n) {
+    while (n > 0) {
+        const ssize_t wrote = ::write(g_frame_fd, p, n);
+        if (wrote <= 0) return false;
+        p += wrote; n -= static_cast<size_t>(wrote);
+    }
+    return true;
+}
 #endif
 
-static void write_msg(const std::string& s) {
-    ensure_binary_mode_once();
-    const uint32_t len = static_cast<uint32_t>(s.size());
-    std::cout.write(reinterpret_cast<const char*>(&len), 4);
-    std::cout.write(s.data(), s.size());
-    std::cout.flush();
+// Frames queued while a write is in progress go out in one syscall
+static void writer_loop(Conn& conn) {
+    std::string msg, batch;
+    bool stop = false;
+    while (!stop) {
+        conn.outbox.Pop(msg);
+        batch.clear();
+        do {
+            if (msg.empty()) { stop = true; break; }
+            const uint32_t len = static_cast<uint32_t>(msg.size());
+            batch.append(reinterpret_cast<const char*>(&len), 4);
+            batch.append(msg);
+        } while (batch.size() < (64u << 10) && conn.outbox.TryPop(msg));
+        if (batch.empty()) continue;
+        const auto t0 = StageClock::now();
+        const bool ok = conn.stream ? conn.stream->Write(batch.data(), batch.size())
+                                    : write_raw(batch.data(), batch.size());
+        if (!ok) return; // browser / client gone
+        g_stages.Since(HS_WRITE, t0);
+    }
+}
+
+// A daemon client that stops reading loses frames instead of stalling the shared worker
+static void send_to(Conn& conn, std::string msg, bool best_effort = false) {
+    if (msg.empty() || !conn.open.load()) return;
+    if (!conn.stream && !best_effort) { conn.outbox.Push(std::move(msg)); return; }
+    if (!conn.outbox.TryPush(std::move(msg)) && conn.stream) ++g_frames_dropped;
+}
+
+static void write_msg(const std::string& s, bool best_effort = false) {
+    if (s.empty()) return;
+    if (t_conn) { send_to(*t_conn, s, best_effort); return; }
+    std::lock_guard<std::mutex> lk(g_conns_mu);
+    for (const auto& c : g_conns) send_to(*c, s, best_effort);
 }
 
-static bool read_msg(std::string& out) {
-    ensure_binary_mode_once();
+static bool read_bytes(Conn& conn, char* p, size_t n) {
+    if (conn.stream) return conn.stream->Read(p, n);
+    return static_cast<bool>(std::cin.read(p, static_cast<std::streamsize>(n)));
+}
+
+static bool read_msg(Conn& conn, std::string& out) {
     uint32_t len = 0;
-    if (!std::cin.read(reinterpret_cast<char*>(&len), 4)) return false;
+    if (!read_bytes(conn, reinterpret_cast<char*>(&len), 4)) return false;
     if (len == 0) return false;
+    const auto t0 = StageClock::now(); // payload only: the header read waits for the browser
     std::string buf(len, '\0');
-    if (!std::cin.read(&buf[0], len)) return false;
+    if (!read_bytes(conn, &buf[0], len)) return false;
     out.swap(buf);
+    g_stages.Since(HS_READ, t0);
     return true;
 }
 
 // ===================================================================
-// Tiny JSON helpers
+// JSON (shared single-pass reader / escaper: Json.hpp)
 // ===================================================================
-static std::string json_escape(const std::string& s) {
-    std::string out; out.reserve(s.size() + 8);
-    for (char c : s) {
-        switch (c) {
-        case '\"': out += "\\\""; break;
-        case '\\': out += "\\\\"; break;
-        case '\n': out += "\\n";  break;
-        case '\r': out += "\\r";  break;
-        case '\t': out += "\\t";  break;
-        default:   out.push_back(c); break;
-        }
-    }
-    return out;
-}
-
-static std::string get_json_string(const std::string& src, const std::string& key) {
-    const std::string pattern = "\"" + key + "\"";
-    size_t p = src.find(pattern);
-    if (p == std::string::npos) return "";
-    p = src.find(':', p + pattern.size());
-    if (p == std::string::npos) return "";
-    while (p < src.size() && (src[p] == ':' || (unsigned char)src[p] <= ' ')) ++p;
-    if (p >= src.size() || src[p] != '"') return "";
-    ++p;
-    std::string val;
-    while (p < src.size()) {
-        char c = src[p++];
-        if (c == '\\') {
-            if (p < src.size()) {
-                char e = src[p++];
-                if (e == 'n')      val.push_back('\n');
-                else if (e == 'r') val.push_back('\r');
-                else if (e == 't') val.push_back('\t');
-                else               val.push_back(e); // includes '"' and '\'
-            }
-        }
-        else if (c == '"') {
-            break;
-        }
-        else {
-            val.push_back(c);
-        }
-    }
-    return val;
-}
+using AppUtils::JsonEscape;
+using AppUtils::JsonReader;
 
-// Extract literal array after "suggestions": [...]
-static std::string extract_suggestions_array(const std::string& src) {
-    const std::string key = "\"suggestions\"";
-    size_t k = src.find(key);
-    if (k == std::string::npos) return "";
-    size_t colon = src.find(':', k + key.size());
-    if (colon == std::string::npos) return "";
-    size_t p = colon + 1;
-    while (p < src.size() && (unsigned char)src[p] <= ' ') ++p;
-    if (p >= src.size() || src[p] != '[') return "";
-    int depth = 0; size_t start = p;
-    for (size_t i = p; i < src.size(); ++i) {
-        char c = src[i];
-        if (c == '[') depth++;
-        else if (c == ']') {
-            depth--;
-            if (depth == 0) return src.substr(start, i - start + 1);
-        }
-    }
-    return "";
+// {"...} -> {"id":N,"...}  (responses are routed by request id in background.js)
+static std::string with_id(const std::string& json, long long id) {
+    if (id < 0 || json.empty() || json[0] != '{') return json;
+    std::string out = "{\"id\":" + std::to_string(id);
+    if (json.size() > 2) out += ",";
+    out.append(json, 1, std::string::npos);
+    return out;
 }
 
-// Normalize DLL JSON into {"suggestions":[...]}
+// Normalize DLL output into {"suggestions":[...]}: a bare array, or an object
+// carrying one. Anything else (or a malformed array) becomes a single string.
 static std::string normalize_to_suggestions(const std::string& dll_json) {
     size_t a = 0, b = dll_json.size();
     while (a < b && (unsigned char)dll_json[a] <= ' ') ++a;
     while (b > a && (unsigned char)dll_json[b - 1] <= ' ') --b;
     if (a >= b) return "{\"suggestions\":[\"Error\",\"Empty response\"]}";
-    const char first = dll_json[a];
-    if (first == '[') {
-        std::string out = "{\"suggestions\":";
-        out.append(dll_json, a, b - a);
-        out += "}";
-        return out;
+    const std::string_view text(dll_json.data() + a, b - a);
+
+    std::string_view arr;
+    if (text[0] == '[') arr = text;
+    else if (text[0] == '{') {
+        JsonReader r;
+        if (r.Parse(text)) arr = r.Raw("suggestions");
     }
-    if (first == '{') {
-        std::string arr = extract_suggestions_array(dll_json.substr(a, b - a));
-        if (!arr.empty()) {
-            std::string out = "{\"suggestions\":";
-            out += arr;
-            out += "}";
-            return out;
+
+    std::vector<std::string> items;
+    if (!arr.empty() && AppUtils::JsonParseStringArray(arr, items)) {
+        std::string out = "{\"suggestions\":[";
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (i) out += ',';
+            out += '"';
+            AppUtils::JsonAppendEscaped(out, items[i]);
+            out += '"';
         }
-        return std::string("{\"suggestions\":[\"") + json_escape(dll_json.substr(a, b - a)) + "\"]}";
+        out += "]}";
+        return out;
     }
-    return std::string("{\"suggestions\":[\"") + json_escape(dll_json.substr(a, b - a)) + "\"]}";
+    return "{\"suggestions\":[\"" + JsonEscape(text) + "\"]}";
 }
 
 // ===================================================================
-// Windows DLL glue
+// Inference library glue (PaperClipNative.dll / libPaperClipNative.so)
 // ===================================================================
-#ifdef _WIN32
 typedef const char* (__cdecl* fn_generate_t)(const char*);
+typedef void(__cdecl* fn_element_cb_t)(int, const char*, void*);
+typedef const char* (__cdecl* fn_generate_stream_t)(const char*, fn_element_cb_t, void*);
+typedef const char* (__cdecl* fn_generate_ctx_t)(const char*, const char*, const char*, fn_element_cb_t, void*);
 typedef void(__cdecl* fn_free_t)(const char*);
 typedef int(__cdecl* fn_set_path_t)(const char*);
+typedef int(__cdecl* fn_abort_t)();
+typedef void(__cdecl* fn_set_deadline_t)(uint32_t);
+typedef const char* (__cdecl* fn_stats_t)();
+typedef void(__cdecl* fn_set_threshold_t)(double);
+typedef const char* (__cdecl* fn_warmup_t)();
+typedef const char* (__cdecl* fn_peek_t)(const char*, fn_element_cb_t, void*);
+typedef const char* (__cdecl* fn_generate_cascade_t)(const char*, const char*, const char*, int, fn_element_cb_t, void*);
+typedef uint32_t(__cdecl* fn_abi_version_t)();
+typedef int(__cdecl* fn_reload_t)();
+typedef int(__cdecl* fn_prefill_hint_t)(const pr_request*);
+typedef int(__cdecl* fn_rewrite_v2_t)(const pr_request*, pr_result*, char*, uint32_t);
+typedef void(__cdecl* fn_result_free_t)(pr_result*);
+typedef int(__cdecl* fn_batch_t)(const pr_request*, const pr_batch_item*, uint32_t, pr_batch_cb, void*);
 
+#ifdef _WIN32
 static HMODULE        g_lib = nullptr;
+#else
+static void*          g_lib = nullptr;
+#endif
 static fn_generate_t  g_generate = nullptr;
+static fn_generate_stream_t g_generate_stream = nullptr;
+static fn_generate_ctx_t g_generate_ctx = nullptr;
 static fn_free_t      g_free = nullptr;
 static fn_set_path_t  g_set_base = nullptr;
 static fn_set_path_t  g_set_config = nullptr;
+static fn_abort_t     g_abort = nullptr;
+static fn_set_deadline_t g_set_deadline = nullptr;
+static fn_stats_t     g_cache_stats = nullptr;
+static fn_stats_t     g_session_stats = nullptr;
+static fn_stats_t     g_pool_stats = nullptr;
+static fn_stats_t     g_decode_stats = nullptr;
+static fn_stats_t     g_fastpath_stats = nullptr;
+static fn_set_threshold_t g_set_fastpath = nullptr;
+static fn_stats_t     g_stage_stats = nullptr;
+static fn_warmup_t    g_warmup = nullptr;
+static fn_warmup_t    g_bake_prefix = nullptr;
+static fn_peek_t      g_peek = nullptr;
+static fn_generate_cascade_t g_generate_cascade = nullptr;
+static fn_rewrite_v2_t g_rewrite_v2 = nullptr;     // null → v1 string exports
+static fn_result_free_t g_result_free = nullptr;
+static fn_batch_t g_rewrite_batch = nullptr;       // null → documents go sentence by sentence through v2
+static fn_stats_t     g_cascade_stats = nullptr;
+static fn_reload_t    g_reload = nullptr;
+static fn_stats_t     g_reload_stats = nullptr;
+static fn_prefill_hint_t g_prefill_hint = nullptr;
+static fn_stats_t     g_hint_stats = nullptr;
+
+// 0 = no diag frames, 1 = startup / load / anomalies, 2 = + per-request trace
+static std::atomic<int> g_diag_level{ 1 };
+
+static bool diag_verbose() { return g_diag_level.load(std::memory_order_relaxed) >= 2; }
+
+// Send diagnostics via NM frame (visible in BG logs)
+static void write_diag(std::string path, size_t in_len, size_t out_len, std::string note) {
+    if (g_diag_level.load(std::memory_order_relaxed) < 1) return;
+    std::string msg;
+    msg += "{\"type\":\"diag\",\"path\":\"";
+    AppUtils::JsonAppendEscaped(msg, path);
+    msg += "\",\"in_len\":";
+    msg += std::to_string(static_cast<unsigned long long>(in_len));
+    msg += ",\"out_len\":";
+    msg += std::to_string(static_cast<unsigned long long>(out_len));
+    msg += ",\"note\":\"";
+    AppUtils::JsonAppendEscaped(msg, note);
+    msg += "\"}";
+    write_msg(msg, true); // best effort: diag never blocks the pipeline
+}
+
+// Same export table on both platforms; lib_sym is the only OS-specific part
+static void* lib_sym(const char* name);
+
+static void bind_exports() {
+    g_generate = reinterpret_cast<fn_generate_t>(lib_sym("generate_polite_rewrite"));
+    g_generate_stream = reinterpret_cast<fn_generate_stream_t>(lib_sym("generate_polite_rewrite_stream"));
+    g_free = reinterpret_cast<fn_free_t>(lib_sym("polite_rewrite_free"));
+    g_set_base = reinterpret_cast<fn_set_path_t>(lib_sym("polite_rewrite_set_base_dir"));
+    g_set_config = reinterpret_cast<fn_set_path_t>(lib_sym("polite_rewrite_set_config_path"));
+    g_abort = reinterpret_cast<fn_abort_t>(lib_sym("polite_rewrite_abort"));
+    g_set_deadline = reinterpret_cast<fn_set_deadline_t>(lib_sym("polite_rewrite_set_deadline_ms"));
+    g_cache_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_cache_stats"));
+    g_session_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_session_stats"));
+    g_pool_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_pool_stats"));
+    g_decode_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_decode_stats"));
+    g_generate_ctx = reinterpret_cast<fn_generate_ctx_t>(lib_sym("generate_polite_rewrite_ctx"));
+    g_fastpath_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_fastpath_stats"));
+    g_stage_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_stage_stats"));
+    g_warmup = reinterpret_cast<fn_warmup_t>(lib_sym("polite_rewrite_warmup"));
+    g_bake_prefix = reinterpret_cast<fn_warmup_t>(lib_sym("polite_rewrite_bake_prefix"));
+    g_peek = reinterpret_cast<fn_peek_t>(lib_sym("generate_polite_rewrite_peek"));
+    g_generate_cascade = reinterpret_cast<fn_generate_cascade_t>(lib_sym("generate_polite_rewrite_cascade"));
+    g_cascade_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_cascade_stats"));
+    g_reload = reinterpret_cast<fn_reload_t>(lib_sym("polite_rewrite_reload"));
+    g_reload_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_reload_stats"));
+    g_prefill_hint = reinterpret_cast<fn_prefill_hint_t>(lib_sym("polite_rewrite_prefill_hint"));
+    g_hint_stats = reinterpret_cast<fn_stats_t>(lib_sym("polite_rewrite_hint_stats"));
+
+    // v2 only when the library says so and all of it is there; otherwise v1 as before
+    const auto abi = reinterpret_cast<fn_abi_version_t>(lib_sym("polite_rewrite_abi_version"));
+    g_rewrite_v2 = reinterpret_cast<fn_rewrite_v2_t>(lib_sym("polite_rewrite_v2"));
+    g_result_free = reinterpret_cast<fn_result_free_t>(lib_sym("polite_rewrite_result_free"));
+    g_rewrite_batch = reinterpret_cast<fn_batch_t>(lib_sym("polite_rewrite_batch"));
+    if (!abi || abi() < 2 || !g_rewrite_v2 || !g_result_free) {
+        g_rewrite_v2 = nullptr;
+        g_result_free = nullptr;
+        g_rewrite_batch = nullptr;
+    }
+    g_set_fastpath = reinterpret_cast<fn_set_threshold_t>(lib_sym("polite_rewrite_set_fastpath_threshold"));
+}
+
+// Fast-path threshold (accuracy vs NPU time); DLL default when unset
+static void apply_fastpath_threshold(const char* env_value) {
+    if (!g_set_fastpath || !env_value || !*env_value) return;
+    g_set_fastpath(std::strtod(env_value, nullptr));
+    write_diag("dll", 0, 0, std::string("fastpath threshold ") + env_value);
+}
+
+#ifdef _WIN32
+static void* lib_sym(const char* name) {
+    return reinterpret_cast<void*>(::GetProcAddress(g_lib, name));
+}
 
 static std::wstring utf8_to_w(const std::string& s) {
     if (s.empty()) return L"";
@@ -245,37 +503,6 @@ static std::string dll_dir_utf8(HMODULE hmod) {
     return w_to_utf8(dir);
 }
 
-// Send diagnostics via NM frame (visible in BG logs)
-static void write_diag(std::string path, size_t in_len, size_t out_len, std::string note) {
-    auto esc = [](const std::string& s) {
-        std::string o; o.reserve(s.size() + 8);
-        for (char c : s) {
-            switch (c) {
-            case '\"': o += "\\\""; break;
-            case '\\': o += "\\\\"; break;
-            case '\n': o += "\\n";  break;
-            case '\r': o += "\\r";  break;
-            case '\t': o += "\\t";  break;
-            default:   o.push_back(c); break;
-            }
-        }
-        return o;
-        };
-    std::string msg;
-    msg += "{\"type\":\"diag\",\"path\":\"";
-    msg += esc(path);
-    msg += "\",\"in_len\":";
-    msg += std::to_string(static_cast<unsigned long long>(in_len));
-    msg += ",\"out_len\":";
-    msg += std::to_string(static_cast<unsigned long long>(out_len));
-    msg += ",\"note\":\"";
-    msg += esc(note);
-    msg += "\"}";
-    write_msg(msg);
-}
-
-
-#ifdef _WIN32
 static void log_last_err(const char* where) {
     DWORD e = GetLastError();
     LPWSTR msg = nullptr;
@@ -285,7 +512,6 @@ static void log_last_err(const char* where) {
     if (msg) LocalFree(msg);
     write_diag("dll", 0, 0, std::string(where) + " GLE=" + std::to_string(e) + " " + s);
 }
-#endif
 
 
 static void try_load_lib() {
@@ -311,10 +537,7 @@ static void try_load_lib() {
     }
     if (!g_lib) return;
 
-    g_generate = reinterpret_cast<fn_generate_t>(::GetProcAddress(g_lib, "generate_polite_rewrite"));
-    g_free = reinterpret_cast<fn_free_t>(::GetProcAddress(g_lib, "polite_rewrite_free"));
-    g_set_base = reinterpret_cast<fn_set_path_t>(::GetProcAddress(g_lib, "polite_rewrite_set_base_dir"));
-    g_set_config = reinterpret_cast<fn_set_path_t>(::GetProcAddress(g_lib, "polite_rewrite_set_config_path"));
+    bind_exports();
 
     if (!g_generate || !g_free) {
         write_diag("dll", 0, 0, "GetProcAddress missing exports");
@@ -358,8 +581,10 @@ static void try_load_lib() {
         }
     }
 
-    //  warmup 완전 제거 (로그로 명시만)
-    write_diag("dll", 0, 0, "warmup-skipped");
+    {
+        char th_env[64] = { 0 }; size_t t = 0;
+        if (getenv_s(&t, th_env, "PC_FASTPATH_THRESHOLD") == 0 && t > 0) apply_fastpath_threshold(th_env);
+    }
 
     // === extra probe after set_base / set_config ===
     std::string base = "";
@@ -414,36 +639,267 @@ static void try_load_lib() {
     write_diag("probe", 0, 0, "SetDllDirectory(bundle) set");
 
 }
+#else
+// POSIX (Linux benchmark / stand-in library): PC_SUGGESTION_DLL or
+// libPaperClipNative.so beside the executable.
+static void* lib_sym(const char* name) {
+    return g_lib ? ::dlsym(g_lib, name) : nullptr;
+}
+
+static std::string exe_dir_utf8() {
+    char buf[PATH_MAX]{};
+    const ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+    if (n <= 0) return ".";
+    return fs::path(std::string(buf, static_cast<size_t>(n))).parent_path().string();
+}
+
+static void try_load_lib() {
+    if (g_lib) return;
+    const char* env = std::getenv("PC_SUGGESTION_DLL");
+    const std::string path = (env && *env) ? std::string(env) : exe_dir_utf8() + "/libPaperClipNative.so";
+    g_lib = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!g_lib) {
+        const char* err = ::dlerror();
+        write_diag("dll", 0, 0, "dlopen FAIL: " + path + " " + (err ? err : ""));
+        return;
+    }
+    write_diag("dll", 0, 0, "dlopen OK: " + path);
+
+    bind_exports();
+    if (!g_generate || !g_free) {
+        write_diag("dll", 0, 0, "dlsym missing exports");
+        return;
+    }
+    if (const char* base = std::getenv("PC_MODEL_BASE_DIR"); base && *base && g_set_base) g_set_base(base);
+    if (const char* cfg = std::getenv("PC_CONFIG_PATH"); cfg && *cfg && g_set_config) g_set_config(cfg);
+    apply_fastpath_threshold(std::getenv("PC_FASTPATH_THRESHOLD"));
+}
 #endif // _WIN32
 
 // ===================================================================
 // analyze
 // ===================================================================
-static std::string handle_analyze(const std::string& focus,
-    const std::string& /*context*/,
-    const std::string& body) {
-#ifdef _WIN32
+// Scheduling class: what the user is waiting on runs first
+enum Priority : int { PRIO_INTERACTIVE, PRIO_LIVE, PRIO_BACKGROUND, PRIO_COUNT };
+static const char* const kPriorityNames[PRIO_COUNT] = { "interactive", "live", "background" };
+
+struct AnalyzeRequest {
+    long long   id = -1;          // echoed back on every frame for this request
+    std::string session;          // "tabId:frameId" — newer request preempts older
+    std::string focus, context, body;
+    bool        stream = false;
+    bool        alternatives = false; // rewrites wanted even for a polite verdict
+    std::string language;         // reply language ("" = detect) — v2 only
+    uint32_t    max_alternatives = 0, max_tokens = 0; // 0 = library default — v2 only
+    uint32_t    deadline_ms = 0;  // from receipt (0 = none)
+    uint32_t    budget_ms = 0;    // what is left of it at pickup — the DLL enforces this
+    int         priority = PRIO_LIVE;
+    uint64_t    estimate_us = 0;  // expected service time at admission (0 = nothing learned yet)
+    std::chrono::steady_clock::time_point received{};
+    bool        peeked = false;   // already tried without the model (while loading)
+    bool        document = false; // analyze_document: every sentence of body
+    bool        hint = false;     // prefill: the sentence being typed, no reply
+    std::shared_ptr<Conn> conn;   // where the replies go (null only for worker tokens)
+};
+
+static AnalyzeRequest parse_analyze(const JsonReader& j) {
+    AnalyzeRequest r;
+    r.id = j.Number("id", -1);
+    r.session = j.String("session");
+    r.focus = j.String("focus");
+    r.context = j.String("context");
+    r.body = j.String("body");
+    r.stream = j.Bool("stream");
+    r.alternatives = j.Bool("alternatives");
+    r.language = j.String("language");
+    r.max_alternatives = static_cast<uint32_t>(std::min(8LL, std::max(0LL, j.Number("max_alternatives", 0))));
+    r.max_tokens = static_cast<uint32_t>(std::min(4096LL, std::max(0LL, j.Number("max_tokens", 0))));
+    const long long d = j.Number("deadline_ms", 0);
+    r.deadline_ms = d > 0 ? static_cast<uint32_t>(d) : 0;
+    const std::string_view prio = j.String("priority");
+    for (int p = 0; p < PRIO_COUNT; ++p)
+        if (prio == kPriorityNames[p]) r.priority = p;
+    r.received = std::chrono::steady_clock::now();
+    return r;
+}
+
+// {"...} -> {"...,"queue_us":N}
+static std::string with_queue_us(std::string json, long long us) {
+    if (json.size() <= 2 || json.back() != '}') return json;
+    json.insert(json.size() - 1, ",\"queue_us\":" + std::to_string(us));
+    return json;
+}
+
+static std::string aborted_frame(long long id, const std::string& reason) {
+    return with_id("{\"type\":\"aborted\",\"reason\":\"" + JsonEscape(reason) + "\"}", id);
+}
+
+// Streaming callback context: routes partial frames and times the first one
+struct StreamTarget {
+    long long                  id;
+    StageClock::time_point     received;
+    bool                       first_sent;
+};
+
+// Each closed array element goes out as its own frame (called from inside the DLL)
+static void __cdecl on_stream_element(int index, const char* element_utf8, void* user) {
+    StreamTarget& t = *static_cast<StreamTarget*>(user);
+    const long long id = t.id;
+    std::string msg = "{\"type\":\"partial\",\"index\":";
+    msg += std::to_string(index);
+    msg += ",\"text\":\"";
+    AppUtils::JsonAppendEscaped(msg, element_utf8 ? element_utf8 : "");
+    msg += "\"}";
+    write_msg(with_id(msg, id));
+    if (!t.first_sent) {
+        t.first_sent = true;
+        g_stages.Since(HS_FIRST_FRAME, t.received);
+    }
+}
+
+// The sentence to rewrite: focus, else the whole body (trimmed)
+static std::string target_of(const AnalyzeRequest& req) {
+    const std::string& s = req.focus.empty() ? req.body : req.focus;
+    size_t a = 0, b = s.size();
+    while (a < b && (unsigned char)s[a] <= ' ') ++a;
+    while (b > a && (unsigned char)s[b - 1] <= ' ') --b;
+    return a < b ? s.substr(a, b - a) : std::string("Hello.");
+}
+
+// Cascade tier reported by the DLL ("" for older libraries)
+static std::string tier_field(const JsonReader& dll) {
+    if (!dll.Has("tier")) return std::string();
+    return ",\"tier\":\"" + JsonEscape(dll.String("tier")) + "\"";
+}
+
+static std::string span_str(const pr_span& s) {
+    return s.ptr ? std::string(s.ptr, s.len) : std::string();
+}
+
+// v2: structured result → {"suggestions":...} / {"error":...} without re-parsing the model's JSON text
+static std::string result_json(const pr_result& r) {
+    static const char* const kTierNames[] = { "fastpath", "cache", "verdict", "rewrite" };
+    if (r.status != PR_OK) {
+        return "{\"error\":\"" + JsonEscape(span_str(r.message)) + "\",\"stage\":\""
+            + JsonEscape(span_str(r.stage)) + "\",\"status\":" + std::to_string(r.status) + "}";
+    }
+    std::string out = "{\"suggestions\":[\"";
+    if (!r.verdict.ptr && !r.n_alternatives) {
+        AppUtils::JsonAppendEscaped(out, span_str(r.message));
+        out += '"';
+    } else {
+        AppUtils::JsonAppendEscaped(out, span_str(r.verdict));
+        out += '"';
+        for (uint32_t i = 0; i < r.n_alternatives && i < PR_MAX_ALTERNATIVES; ++i) {
+            out += ",\"";
+            AppUtils::JsonAppendEscaped(out, span_str(r.alternatives[i]));
+            out += '"';
+        }
+    }
+    out += ']';
+    if (r.truncated) out += ",\"truncated\":true";
+    if (r.tier >= PR_TIER_FASTPATH && r.tier <= PR_TIER_REWRITE)
+        out += std::string(",\"tier\":\"") + kTierNames[r.tier] + "\"";
+    out += '}';
+    return out;
+}
+
+static std::string frame_from_result(const pr_result& r, long long id) {
+    if (r.status == PR_CANCELLED || r.status == PR_DEADLINE)
+        return aborted_frame(id, r.status == PR_DEADLINE ? "deadline" : span_str(r.message));
+    return with_id(result_json(r), id);
+}
+
+// One v2 call; spans land in the stack buffer (the library allocates only for oversized answers)
+static std::string call_v2(const AnalyzeRequest& req, const std::string& target, uint32_t flags,
+    int* status) {
+    StreamTarget st{ req.id, req.received, false };
+    pr_request rq{};
+    rq.struct_size = sizeof(rq);
+    rq.target = target.c_str();
+    rq.context = req.context.c_str();
+    rq.session = req.session.c_str();
+    rq.language = req.language.empty() ? nullptr : req.language.c_str();
+    rq.flags = flags | (req.alternatives ? PR_CASCADE_ALTERNATIVES : 0);
+    rq.max_alternatives = req.max_alternatives;
+    rq.max_tokens = req.max_tokens;
+    rq.deadline_ms = req.budget_ms;
+    rq.on_element = req.stream ? on_stream_element : nullptr;
+    rq.user = &st;
+    pr_result r{};
+    r.struct_size = sizeof(r);
+    char buf[8192];
+    *status = g_rewrite_v2(&rq, &r, buf, sizeof(buf));
+    std::string out = *status == PR_NEED_MODEL ? std::string() : frame_from_result(r, req.id);
+    g_result_free(&r);
+    return out;
+}
+
+// Answer without the model (fast-path verdict or cached result); "" when the model is needed
+static std::string peek_answer(const AnalyzeRequest& req) {
+    if (g_rewrite_v2) {
+        int status = 0;
+        std::string out = call_v2(req, target_of(req), PR_CASCADE_PEEK, &status);
+        if (diag_verbose() && !out.empty()) write_diag("dll", 0, out.size(), "peek-hit");
+        return out;
+    }
+    // the legacy peek knows no alternatives and would answer them with a bare verdict
+    if (!g_generate_cascade && (!g_peek || req.alternatives)) return std::string();
+    const std::string target = target_of(req);
+    StreamTarget st{ req.id, req.received, false };
+    fn_element_cb_t cb = req.stream ? on_stream_element : nullptr;
+    const char* p = g_generate_cascade
+        ? g_generate_cascade(target.c_str(), nullptr, nullptr,
+            PR_CASCADE_PEEK | (req.alternatives ? PR_CASCADE_ALTERNATIVES : 0), cb, &st)
+        : g_peek(target.c_str(), cb, &st);
+    if (!p) return std::string();
+    std::string dll_json(p);
+    if (g_free) g_free(p);
+    if (diag_verbose()) write_diag("dll", target.size(), dll_json.size(), "peek-hit");
+    std::string out = normalize_to_suggestions(dll_json);
+    JsonReader dll;
+    if (dll_json[0] == '{' && dll.Parse(dll_json)) out.insert(out.size() - 1, tier_field(dll));
+    return with_id(out, req.id);
+}
+
+static std::string handle_analyze(const AnalyzeRequest& req) {
+    const std::string& body = req.body;
     try_load_lib();
+    if (g_rewrite_v2) {
+        const std::string target = target_of(req);
+        int status = 0;
+        const auto t_invoke = StageClock::now();
+        std::string out = call_v2(req, target, 0, &status);
+        g_stages.Since(HS_INVOKE, t_invoke);
+        if (diag_verbose()) write_diag("dll", target.size(), out.size(), "v2 status " + std::to_string(status));
+        return out;
+    }
     if (g_generate) {
-        auto trim = [](const std::string& s) {
-            size_t a = 0, b = s.size();
-            while (a < b && (unsigned char)s[a] <= ' ') ++a;
-            while (b > a && (unsigned char)s[b - 1] <= ' ') --b;
-            return s.substr(a, b - a);
-            };
-        std::string target = trim(focus.empty() ? body : focus);
-        if (target.empty()) target = "Hello.";
+        const std::string target = target_of(req);
 
-        write_diag("dll", target.size(), 0, "invoke-before");
+        if (diag_verbose()) write_diag("dll", target.size(), 0, "invoke-before");
 
         std::string dll_json;
         {
-            StdoutSilencer mute; // DLL이 stdout 찍어도 NM 프레이밍 보호
-            const char* p = g_generate(target.c_str());
+            if (g_set_deadline) g_set_deadline(req.budget_ms);
+            // stdout은 시작 시 NUL로 영구 격리됨 (isolate_stdout)
+            StreamTarget st{ req.id, req.received, false };
+            fn_element_cb_t cb = req.stream ? on_stream_element : nullptr;
+            const auto t_invoke = StageClock::now();
+            // context + session → DLL keeps per-compose-window KV and prefills only new sentences
+            const char* p = g_generate_cascade
+                ? g_generate_cascade(target.c_str(), req.context.c_str(), req.session.c_str(),
+                    req.alternatives ? PR_CASCADE_ALTERNATIVES : 0, cb, &st)
+                : g_generate_ctx
+                ? g_generate_ctx(target.c_str(), req.context.c_str(), req.session.c_str(), cb, &st)
+                : (req.stream && g_generate_stream)
+                ? g_generate_stream(target.c_str(), on_stream_element, &st)
+                : g_generate(target.c_str());
             if (p) { dll_json.assign(p); if (g_free) g_free(p); }
+            g_stages.Since(HS_INVOKE, t_invoke);
         }
 
-        write_diag("dll", target.size(), 0, dll_json.empty() ? "invoke-return-empty"
+        if (diag_verbose()) write_diag("dll", target.size(), 0, dll_json.empty() ? "invoke-return-empty"
             : "invoke-return-nonnull");
 
         if (dll_json.empty()) {
@@ -453,16 +909,29 @@ static std::string handle_analyze(const std::string& focus,
                 "\"I would appreciate your feedback when you have a moment.\""
                 "]}";
             write_diag("dll", target.size(), s.size(), "empty->fallback");
-            return s;
+            return with_id(s, req.id);
         }
 
-        if (dll_json.size() > 900000) dll_json.resize(900000); // guard
+        const auto t_normalize = StageClock::now();
+        JsonReader dll;
+        const bool is_object = dll_json[0] == '{' && dll.Parse(dll_json);
+
+        // Preempted or past its deadline: report cleanly instead of as a suggestion
+        if (is_object && dll.String("stage") == "aborted") {
+            const std::string reason(dll.String("error"));
+            if (diag_verbose()) write_diag("dll", target.size(), 0, "aborted: " + reason);
+            return aborted_frame(req.id, reason);
+        }
 
         std::string out = normalize_to_suggestions(dll_json);
-        write_diag("dll", target.size(), out.size(), "ok");
-        return out;
+        // DLL stopped at its token budget before the array closed: the complete strings are kept
+        if (is_object && dll.Bool("truncated"))
+            out.insert(out.size() - 1, ",\"truncated\":true");
+        if (is_object) out.insert(out.size() - 1, tier_field(dll));
+        g_stages.Since(HS_NORMALIZE, t_normalize);
+        if (diag_verbose()) write_diag("dll", target.size(), out.size(), "ok");
+        return with_id(out, req.id);
     }
-#endif
     // Fallback (no DLL loaded)
     std::string low = body;
     std::transform(low.begin(), low.end(), low.begin(),
@@ -471,43 +940,949 @@ static std::string handle_analyze(const std::string& focus,
         (low.find("stupid") != std::string::npos);
 
     if (rude) {
-        return "{\"suggestions\":[\"Rude\",\"Please soften the expression.\",\"Consider acknowledging the recipient's view.\"]}";
+        return with_id("{\"suggestions\":[\"Rude\",\"Please soften the expression.\",\"Consider acknowledging the recipient's view.\"]}", req.id);
     }
-    return "{\"suggestions\":[\"Polite\",\"Adding a brief thanks at the end can help.\"]}";
+    return with_id("{\"suggestions\":[\"Polite\",\"Adding a brief thanks at the end can help.\"]}", req.id);
 }
 
 // ===================================================================
-// main
+// analyze_document
 // ===================================================================
-int main() {
-#ifdef _WIN32
+// Worker publishes what it is running; the reader compares without locking.
+static std::atomic<uint64_t> g_active_session{ 0 };  // 0 = idle
+static std::atomic<uint64_t> g_active_conn{ 0 };     // its client (Conn::id), 0 = idle
+static std::atomic<bool>     g_active_superseded{ false };
+static std::atomic<bool>     g_active_yieldable{ false }; // a background document (it can resume later)
+static std::atomic<bool>     g_active_yield{ false };     // ...asked to step aside for more urgent work
+static std::atomic<bool>     g_active_hint{ false };      // a prefill hint (any request cancels it)
+static std::atomic<uint64_t> g_hints_received{ 0 }, g_hints_dropped{ 0 }; // dropped: replaced before running
+
+// polite_rewrite_abort stops every library call in flight. The worker makes only one at a time
+// and starts/ends each request under g_abort_mu; readers decide and abort under it too, so the
+// worker cannot move on to another request (or client) between the decision and the abort.
+static std::mutex g_abort_mu;
+
+static constexpr size_t kMaxDocumentSentences = 200;
+
+// Batch callback context: one library result fans out to every occurrence of the sentence
+struct DocumentTarget {
+    long long                                  id;
+    const std::vector<AppUtils::SentenceSpan>* spans;
+    const std::vector<std::vector<size_t>>*    occurrences; // distinct sentence → indices into spans
+    StageClock::time_point                     received;
+    bool                                       first_sent;
+    size_t                                     flagged;
+};
+
+static void __cdecl on_document_result(uint32_t index, const pr_result* r, void* user) {
+    DocumentTarget& t = *static_cast<DocumentTarget*>(user);
+    const std::string result = result_json(*r);
+    const bool flagged = r->status == PR_OK && span_str(r->verdict) == "impolite";
+    for (size_t k : (*t.occurrences)[index]) {
+        const AppUtils::SentenceSpan& sp = (*t.spans)[k];
+        std::string msg = "{\"type\":\"sentence\",\"index\":" + std::to_string(k) +
+            ",\"start\":" + std::to_string(sp.u16_begin) + ",\"end\":" + std::to_string(sp.u16_end) + ",";
+        msg.append(result, 1, std::string::npos);
+        write_msg(with_id(msg, t.id));
+        if (flagged) ++t.flagged;
+    }
+    if (!t.first_sent) {
+        t.first_sent = true;
+        g_stages.Since(HS_FIRST_FRAME, t.received);
+    }
+}
+
+// status: PR_* of the batch (PR_CANCELLED when preempted); sentences: how many were checked
+static std::string handle_document(const AnalyzeRequest& req, int& status, size_t& sentences) {
+    status = PR_ERR_INIT;
+    sentences = 0;
     try_load_lib();
-    write_diag("host", 0, 0, g_lib ? "startup-load-ok" : "startup-load-fail");
-#endif
+    if (!g_rewrite_v2)
+        return with_id("{\"error\":\"document analysis needs a v2 library\",\"stage\":\"host\"}", req.id);
+
+    const auto t_start = StageClock::now();
+    std::vector<AppUtils::SentenceSpan> spans = AppUtils::SplitSentences(req.body);
+    const bool truncated = spans.size() > kMaxDocumentSentences;
+    if (truncated) spans.resize(kMaxDocumentSentences);
+    sentences = spans.size();
+
+    // Repeated sentences (greetings, sign-offs, pasted lines) run once; earlier documents and
+    // live checks are answered from the library's result cache.
+    std::unordered_map<std::string_view, size_t> seen;
+    std::vector<std::vector<size_t>> occurrences;
+    std::vector<pr_batch_item> items;
+    for (size_t k = 0; k < spans.size(); ++k) {
+        const std::string_view text(req.body.data() + spans[k].begin, spans[k].end - spans[k].begin);
+        const auto ins = seen.emplace(text, occurrences.size());
+        if (ins.second) {
+            occurrences.emplace_back();
+            pr_batch_item it{};
+            it.target = { text.data(), static_cast<uint32_t>(text.size()) };
+            it.context = { req.body.data(), spans[k].begin }; // the library keeps the tail that fits
+            items.push_back(it);
+        }
+        occurrences[ins.first->second].push_back(k);
+    }
+
+    pr_request rq{};
+    rq.struct_size = sizeof(rq);
+    rq.session = req.session.c_str();
+    rq.language = req.language.empty() ? nullptr : req.language.c_str();
+    rq.flags = req.alternatives ? PR_CASCADE_ALTERNATIVES : 0;
+    rq.max_alternatives = req.max_alternatives;
+    rq.max_tokens = req.max_tokens;
+    rq.deadline_ms = req.budget_ms;
+
+    DocumentTarget dt{ req.id, &spans, &occurrences, req.received, false, 0 };
+    status = PR_OK;
+    const auto t_invoke = StageClock::now();
+    if (g_rewrite_batch) {
+        status = g_rewrite_batch(&rq, items.data(), static_cast<uint32_t>(items.size()), on_document_result, &dt);
+    }
+    else { // older library: one v2 call per sentence (each leases and enters the session anew)
+        char buf[8192];
+        for (size_t i = 0; i < items.size() && status == PR_OK; ++i) {
+            if (g_active_superseded.load() || g_active_yield.load()) { status = PR_CANCELLED; break; }
+            const std::string target(items[i].target.ptr, items[i].target.len);
+            const std::string context(items[i].context.ptr, items[i].context.len);
+            rq.target = target.c_str();
+            rq.context = context.c_str();
+            pr_result r{};
+            r.struct_size = sizeof(r);
+            const int st = g_rewrite_v2(&rq, &r, buf, sizeof(buf));
+            if (st == PR_CANCELLED || st == PR_DEADLINE) status = st;
+            else on_document_result(static_cast<uint32_t>(i), &r, &dt);
+            g_result_free(&r);
+        }
+    }
+    g_stages.Since(HS_INVOKE, t_invoke);
+    if (diag_verbose()) write_diag("dll", req.body.size(), spans.size(), "document status " + std::to_string(status));
+
+    if (status == PR_CANCELLED || status == PR_DEADLINE)
+        return aborted_frame(req.id, status == PR_DEADLINE ? "deadline" : "cancelled");
+    if (status != PR_OK)
+        return with_id("{\"error\":\"document batch failed\",\"stage\":\"batch\",\"status\":" + std::to_string(status) + "}", req.id);
+    const long long elapsed_ms = static_cast<long long>(AppUtils::StageStats::Us(t_start, StageClock::now()) / 1000);
+    return with_id("{\"type\":\"document\",\"sentences\":" + std::to_string(spans.size()) +
+        ",\"unique\":" + std::to_string(items.size()) + ",\"flagged\":" + std::to_string(dt.flagged) +
+        ",\"truncated\":" + (truncated ? "true" : "false") + ",\"elapsed_ms\":" + std::to_string(elapsed_ms) + "}", req.id);
+}
+
+// ===================================================================
+// Request intake (reader thread) — sees new frames while the DLL runs
+// ===================================================================
+static constexpr long long kShutdownId = -2;
+static constexpr long long kWakeId = -3;       // model load finished: re-check pending work
+static constexpr int kMaxQueuedPerClient = 32;  // daemon: per connection (g_inbox holds 64)
+static AppUtils::BoundedQueue<AnalyzeRequest, 64> g_inbox;
+
+// ===================================================================
+// Scheduling: priority classes, latest-wins per session, deadline admission
+// ===================================================================
+// One worker runs one request at a time. Service times are learned per kind (EWMA) so the
+// reader can turn away a request whose estimated wait alone already exceeds its deadline,
+// and the worker can drop one whose remaining budget cannot cover its estimate.
+enum ServiceKind : int { SVC_ANALYZE, SVC_SENTENCE, SVC_COUNT }; // SVC_SENTENCE: per sentence of a document
+static std::atomic<uint64_t>  g_service_us[SVC_COUNT];  // EWMA (µs), 0 = no sample yet
+static std::atomic<uint64_t>  g_backlog_us[PRIO_COUNT]; // estimates of queued requests per class
+static std::atomic<uint64_t>  g_depth[PRIO_COUNT];      // queued (inbox + worker deque) per class
+static std::atomic<uint64_t>  g_depth_peak{ 0 };
+static std::atomic<uint64_t>  g_admitted{ 0 }, g_superseded{ 0 }, g_rejected_deadline{ 0 },
+                              g_rejected_busy{ 0 }, g_yielded{ 0 };
+static std::atomic<int>       g_active_priority{ -1 };  // class of the running request, -1 = idle
+static std::atomic<long long> g_active_until_us{ 0 };   // its estimated finish (steady clock µs)
+static AppUtils::StageStats   g_class_wait{ "interactive", "live", "background" }; // queue wait (µs)
+
+static long long steady_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(StageClock::now().time_since_epoch()).count();
+}
+
+static uint64_t estimate_for(const AnalyzeRequest& r) {
+    if (!r.document) return g_service_us[SVC_ANALYZE].load();
+    const size_t n = std::min(AppUtils::SplitSentences(r.body).size(), kMaxDocumentSentences);
+    return g_service_us[SVC_SENTENCE].load() * n;
+}
+
+static void learn_service(int kind, uint64_t us) {
+    const uint64_t old = g_service_us[kind].load();
+    g_service_us[kind] = old ? old - old / 8 + us / 8 : us;
+}
 
+static void enqueued(const AnalyzeRequest& r) {
+    g_backlog_us[r.priority] += r.estimate_us;
+    ++g_depth[r.priority];
+    ++r.conn->queued;
+    uint64_t total = 0;
+    for (const auto& d : g_depth) total += d.load();
+    if (total > g_depth_peak.load()) g_depth_peak = total;
+}
+
+// Leaves the queue: picked, superseded, answered without the model, rejected, or its client left
+static void dequeued(const AnalyzeRequest& r) {
+    g_backlog_us[r.priority] -= r.estimate_us;
+    --g_depth[r.priority];
+    --r.conn->queued;
+}
+
+static std::string deadline_rejection(const AnalyzeRequest& r, uint64_t wait_us) {
+    ++g_rejected_deadline;
+    return with_id("{\"type\":\"aborted\",\"reason\":\"deadline\",\"admission\":true,\"estimate_ms\":" +
+        std::to_string((wait_us + r.estimate_us) / 1000) + "}", r.id);
+}
+
+static std::string queue_stats_json() {
+    std::string out = "{\"depth\":{";
+    for (int p = 0; p < PRIO_COUNT; ++p) {
+        if (p) out += ',';
+        out += std::string("\"") + kPriorityNames[p] + "\":" + std::to_string(g_depth[p].load());
+    }
+    size_t clients = 0;
+    {
+        std::lock_guard<std::mutex> lk(g_conns_mu);
+        clients = g_conns.size();
+    }
+    char buf[384];
+    std::snprintf(buf, sizeof(buf),
+        "},\"peak_depth\":%llu,\"admitted\":%llu,\"superseded\":%llu,\"rejected_deadline\":%llu,"
+        "\"rejected_busy\":%llu,\"yielded\":%llu,\"clients\":%zu,\"frames_dropped\":%llu,"
+        "\"service_ms\":{\"analyze\":%.1f,\"sentence\":%.1f},\"wait\":",
+        (unsigned long long)g_depth_peak.load(), (unsigned long long)g_admitted.load(),
+        (unsigned long long)g_superseded.load(), (unsigned long long)g_rejected_deadline.load(),
+        (unsigned long long)g_rejected_busy.load(), (unsigned long long)g_yielded.load(),
+        clients, (unsigned long long)g_frames_dropped.load(),
+        g_service_us[SVC_ANALYZE].load() / 1000.0, g_service_us[SVC_SENTENCE].load() / 1000.0);
+    return out + buf + g_class_wait.Json() + "}";
+}
+
+// ===================================================================
+// Background model load (polite_rewrite_warmup on its own thread)
+// ===================================================================
+enum ModelState : int { MODEL_UNAVAILABLE, MODEL_LOADING, MODEL_READY, MODEL_FAILED };
+static std::atomic<int>       g_model_state{ MODEL_UNAVAILABLE };
+static std::atomic<long long> g_load_ms{ -1 };
+static StageClock::time_point g_load_started{};
+static std::string            g_load_error;    // written before MODEL_FAILED is published
+static std::string            g_load_info;     // warmup result JSON, written before MODEL_READY is published
+
+static std::string status_frame() {
+    static const char* kNames[] = { "unavailable", "loading", "ready", "failed" };
+    const int state = g_model_state.load();
+    std::string msg = std::string("{\"type\":\"status\",\"state\":\"") + kNames[state] + "\"";
+    if (state == MODEL_LOADING)
+        msg += ",\"elapsed_ms\":" + std::to_string(AppUtils::StageStats::Us(g_load_started, StageClock::now()) / 1000);
+    else if (g_load_ms.load() >= 0)
+        msg += ",\"load_ms\":" + std::to_string(g_load_ms.load());
+    if (state == MODEL_FAILED) msg += ",\"error\":\"" + JsonEscape(g_load_error) + "\"";
+    if (state == MODEL_READY && !g_load_info.empty()) msg += ",\"warmup\":" + g_load_info;
+    return msg + "}";
+}
+
+// Without the warmup export the library loads lazily on the first request (old behaviour)
+static void start_model_load() {
+    if (!g_lib || !g_generate) return;
+    if (!g_warmup) { g_model_state = MODEL_READY; return; }
+    g_load_started = StageClock::now();
+    g_model_state = MODEL_LOADING;
+    write_msg(status_frame());
+    std::thread([] {
+        std::string result;
+        const char* p = g_warmup();
+        if (p) { result.assign(p); if (g_free) g_free(p); }
+        g_load_ms = static_cast<long long>(AppUtils::StageStats::Us(g_load_started, StageClock::now()) / 1000);
+        JsonReader r;
+        const bool ok = r.Parse(result) && r.Bool("ok");
+        if (!ok) g_load_error = result.empty() ? std::string("warmup returned nothing") : std::string(r.String("error", result));
+        else g_load_info = result;
+        g_model_state = ok ? MODEL_READY : MODEL_FAILED;
+        write_diag("dll", 0, result.size(), ok ? "model ready" : "model load failed: " + g_load_error);
+        write_msg(status_frame());
+        AnalyzeRequest wake;
+        wake.id = kWakeId;
+        g_inbox.Push(std::move(wake));
+    }).detach();
+}
+
+static uint64_t session_key(const std::string& s) {
+    if (s.empty()) return 0;
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+    return h ? h : 1;
+}
+
+// A newer sentence from the same tab/frame preempts the running generation;
+// queued duplicates are coalesced by the worker. More urgent work makes a running
+// background document yield. Checked before the push: once queued, the worker may
+// already be running this very request.
+static void submit_analyze(AnalyzeRequest req) {
+    const uint64_t key = session_key(req.session);
+    const bool same_session = key && g_active_session.load() == key;
+
+    // Estimated wait: the running request (unless this one supersedes it) and queued work of
+    // the same or a better class. Queued requests this one will supersede are still counted.
+    req.estimate_us = estimate_for(req);
+    if (req.deadline_ms && req.estimate_us) {
+        const int active = g_active_priority.load();
+        const bool runs_first = active >= 0 && !same_session && !(g_active_yieldable.load() && req.priority < active);
+        uint64_t wait_us = runs_first ? static_cast<uint64_t>(std::max(0LL, g_active_until_us.load() - steady_us())) : 0;
+        for (int p = 0; p <= req.priority; ++p) wait_us += g_backlog_us[p].load();
+        if (wait_us / 1000 >= req.deadline_ms) {
+            write_msg(deadline_rejection(req, wait_us));
+            return;
+        }
+    }
+
+    // One browser flooding the daemon must not crowd out the other
+    if (req.conn->stream && req.conn->queued.load() >= kMaxQueuedPerClient) {
+        ++g_rejected_busy;
+        write_msg(with_id("{\"error\":\"busy\"}", req.id));
+        return;
+    }
+
+    // Admitted first, then the running request is stopped: a request turned away as busy
+    // must not cost the one in flight. Pushed under g_abort_mu, so the worker cannot start
+    // this request in between and have it taken for the one it supersedes.
+    const long long id = req.id;
+    const int priority = req.priority;
+    bool admitted = false;
+    enqueued(req);
+    {
+        std::lock_guard<std::mutex> lk(g_abort_mu);
+        admitted = g_inbox.TryPush(std::move(req)); // moves only on success
+        if (admitted) {
+            if (g_active_hint.load()) { // speculative work never delays a real request
+                if (g_abort) g_abort();
+            }
+            else if (key && g_active_session.load() == key) {
+                g_active_superseded = true;
+                if (g_abort) g_abort();
+            }
+            else if (g_active_yieldable.load() && priority < g_active_priority.load()) {
+                g_active_yield = true;
+                if (g_abort) g_abort();
+            }
+        }
+    }
+    if (!admitted) {
+        dequeued(req);
+        ++g_rejected_busy;
+        write_msg(with_id("{\"error\":\"busy\"}", id));
+        return;
+    }
+    ++g_admitted;
+}
+
+// Daemon: the same "tab:frame" can come from two browsers — preemption and the library's
+// compose sessions are per client
+static void adopt(AnalyzeRequest& r, const std::shared_ptr<Conn>& conn) {
+    r.conn = conn;
+    if (conn->stream && !r.session.empty()) r.session = "c" + std::to_string(conn->id) + "/" + r.session;
+}
+
+static void reader_loop(std::shared_ptr<Conn> conn) {
+    t_conn = conn.get();
     std::string raw;
-    while (read_msg(raw)) {
-        write_diag("host", raw.size(), 0,
+    JsonReader req; // reused across frames (member table keeps its capacity)
+    while (read_msg(*conn, raw)) {
+        if (diag_verbose()) write_diag("host", raw.size(), 0,
             std::string("recv: ") + (raw.size() > 64 ? raw.substr(0, 64) + "..." : raw));
-        const std::string type = get_json_string(raw, "type");
+        const auto t_parse = StageClock::now();
+        if (!req.Parse(raw)) {
+            write_msg("{\"error\":\"bad json\"}");
+            continue;
+        }
+        g_stages.Since(HS_PARSE, t_parse);
+        const std::string_view type = req.String("type");
         if (type == "ping") {
-#ifdef _WIN32
-            try_load_lib();
-#endif
-            write_diag("host", 0, 0, "recv-ping");
-            write_msg("{\"type\":\"pong\"}");
-            write_diag("host", 0, 0, "sent-pong");
+            write_msg("{\"type\":\"pong\"}"); // answered even mid-generation
             continue;
         }
         if (type == "analyze") {
-            const std::string focus = get_json_string(raw, "focus");
-            const std::string context = get_json_string(raw, "context");
-            const std::string body = get_json_string(raw, "body");
-            (void)context;
-            write_msg(handle_analyze(focus, context, body));
+            AnalyzeRequest r = parse_analyze(req);
+            adopt(r, conn);
+            submit_analyze(std::move(r));
+            continue;
+        }
+        if (type == "analyze_document") {
+            AnalyzeRequest r = parse_analyze(req);
+            adopt(r, conn);
+            r.document = true;
+            if (!req.Has("priority")) r.priority = PRIO_BACKGROUND;
+            // own preemption lane: a live sentence check from the same window must not cancel it
+            if (!r.session.empty()) r.session += "#doc";
+            submit_analyze(std::move(r));
+            continue;
+        }
+        if (type == "prefill") {
+            if (!g_prefill_hint || g_model_state.load() != MODEL_READY) continue; // nothing to prefill into
+            AnalyzeRequest r = parse_analyze(req);
+            if (r.focus.empty()) continue;
+            adopt(r, conn);
+            r.hint = true;
+            ++g_hints_received;
+            g_inbox.TryPush(std::move(r)); // full: a hint is never worth a busy reply
+            continue;
+        }
+        if (type == "cache_stats") {
+            std::string stats = "{}", sessions = "{}", fastpath = "{}";
+            if (g_cache_stats && g_free) { // cache has its own lock; safe off the worker thread
+                const char* p = g_cache_stats();
+                if (p) { stats.assign(p); g_free(p); }
+            }
+            if (g_session_stats && g_free) { // atomic counters only
+                const char* p = g_session_stats();
+                if (p) { sessions.assign(p); g_free(p); }
+            }
+            if (g_fastpath_stats && g_free) {
+                const char* p = g_fastpath_stats();
+                if (p) { fastpath.assign(p); g_free(p); }
+            }
+            write_msg("{\"type\":\"cache_stats\",\"cache\":" + stats + ",\"sessions\":" + sessions +
+                ",\"fastpath\":" + fastpath + "}");
+            continue;
+        }
+        if (type == "status") {
+            write_msg(status_frame());
+            continue;
+        }
+        if (type == "stats") {
+            std::string native = "{}", pool = "{}", decode = "{}", cascade = "{}", reload = "{}", hints = "{}";
+            if (g_stage_stats && g_free) { // lock-free histograms; safe off the worker thread
+                const char* p = g_stage_stats();
+                if (p) { native.assign(p); g_free(p); }
+            }
+            if (g_pool_stats && g_free) { // pool has its own lock, never held across a query
+                const char* p = g_pool_stats();
+                if (p) { pool.assign(p); g_free(p); }
+            }
+            if (g_decode_stats && g_free) { // atomic counters only
+                const char* p = g_decode_stats();
+                if (p) { decode.assign(p); g_free(p); }
+            }
+            if (g_cascade_stats && g_free) { // atomic counters only
+                const char* p = g_cascade_stats();
+                if (p) { cascade.assign(p); g_free(p); }
+            }
+            if (g_reload_stats && g_free) { // own lock, never held across a load
+                const char* p = g_reload_stats();
+                if (p) { reload.assign(p); g_free(p); }
+            }
+            if (g_hint_stats && g_free) { // atomic counters only
+                const char* p = g_hint_stats();
+                if (p) { hints.assign(p); g_free(p); }
+            }
+            if (hints.size() > 2) hints.pop_back();
+            else hints = "{";
+            hints += std::string(hints.size() > 1 ? "," : "") + "\"received\":" + std::to_string(g_hints_received.load()) +
+                ",\"dropped\":" + std::to_string(g_hints_dropped.load()) + "}";
+            write_msg("{\"type\":\"stats\",\"host\":" + g_stages.Json() + ",\"native\":" + native +
+                ",\"pool\":" + pool + ",\"decode\":" + decode + ",\"cascade\":" + cascade +
+                ",\"queue\":" + queue_stats_json() + ",\"reload\":" + reload + ",\"hints\":" + hints + "}");
+            continue;
+        }
+        if (type == "reload" || type == "reload_stats") {
+            // The load runs on the library's own thread: this reader keeps answering meanwhile
+            const char* state = nullptr;
+            if (type == "reload") {
+                const int rc = g_reload ? g_reload() : -1;
+                state = rc == 0 ? "started" : rc == 1 ? "not_loaded" : "failed";
+            }
+            std::string reload = "{}";
+            if (g_reload_stats && g_free) {
+                const char* p = g_reload_stats();
+                if (p) { reload.assign(p); g_free(p); }
+            }
+            write_msg("{\"type\":\"" + std::string(type) + "\"" +
+                (state ? ",\"state\":\"" + std::string(state) + "\"" : std::string()) + ",\"reload\":" + reload + "}");
+            continue;
+        }
+        if (type == "set_diag") {
+            const long long level = std::min(2LL, std::max(0LL, req.Number("level", 1)));
+            g_diag_level = static_cast<int>(level);
+            write_msg("{\"type\":\"diag_level\",\"level\":" + std::to_string(level) + "}");
             continue;
         }
         write_msg("{\"error\":\"unknown type\"}");
     }
+    t_conn = nullptr;
+    if (conn->stream) { // daemon client gone: its queued work is skipped, its running request stopped
+        conn->open = false;
+        std::lock_guard<std::mutex> lk(g_abort_mu);
+        if (g_active_conn.load() == conn->id) {
+            g_active_superseded = true;
+            if (g_abort) g_abort();
+        }
+        return;
+    }
+    AnalyzeRequest stop;
+    stop.id = kShutdownId;
+    g_inbox.Push(std::move(stop));
+}
+
+// Keep only the newest request per session; report the rest as superseded.
+// Prefill hints wait outside the queue: only the newest is worth running, and only when idle
+static std::unique_ptr<AnalyzeRequest> g_next_hint; // worker thread only
+
+// true when r was a hint (now held)
+static bool hold_hint(AnalyzeRequest& r) {
+    if (!r.hint) {
+        if (g_next_hint && g_next_hint->session == r.session) { // the finished sentence is here
+            ++g_hints_dropped;
+            g_next_hint.reset();
+        }
+        return false;
+    }
+    if (g_next_hint) ++g_hints_dropped;
+    g_next_hint = std::make_unique<AnalyzeRequest>(std::move(r));
+    return true;
+}
+
+static bool drain_inbox(std::deque<AnalyzeRequest>& pending) {
+    bool shutdown = false;
+    AnalyzeRequest r;
+    while (g_inbox.TryPop(r)) {
+        if (r.id == kShutdownId) { shutdown = true; continue; }
+        if (r.id == kWakeId) continue;
+        if (hold_hint(r)) continue;
+        if (!r.session.empty()) {
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (it->session == r.session) {
+                    send_to(*it->conn, aborted_frame(it->id, "superseded"));
+                    dequeued(*it);
+                    ++g_superseded;
+                    it = pending.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        pending.push_back(std::move(r));
+    }
+    return shutdown;
+}
+
+// While the model loads: answer what needs no model, leave the rest queued
+static void serve_without_model(std::deque<AnalyzeRequest>& pending) {
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->peeked || it->document) { ++it; continue; } // documents wait for the model
+        it->peeked = true;
+        t_conn = it->conn.get();
+        std::string reply = peek_answer(*it);
+        t_conn = nullptr;
+        if (reply.empty()) { ++it; continue; }
+        const long long queue_us = static_cast<long long>(AppUtils::StageStats::Us(it->received, StageClock::now()));
+        send_to(*it->conn, with_queue_us(std::move(reply), queue_us));
+        g_stages.Since(HS_TOTAL, it->received);
+        dequeued(*it);
+        it = pending.erase(it);
+    }
+}
+
+// Runs the held hint on the idle worker. No reply; a request arriving meanwhile aborts it.
+static void run_next_hint() {
+    std::unique_ptr<AnalyzeRequest> hint = std::move(g_next_hint);
+    if (!hint->conn->open.load()) return;
+    pr_request rq{};
+    rq.struct_size = sizeof(rq);
+    rq.target = hint->focus.c_str();
+    rq.context = hint->context.c_str();
+    rq.session = hint->session.c_str();
+    rq.language = hint->language.empty() ? nullptr : hint->language.c_str();
+    {
+        std::lock_guard<std::mutex> lk(g_abort_mu);
+        g_active_hint = true;
+    }
+    const int status = g_inbox.Empty() ? g_prefill_hint(&rq) : PR_CANCELLED; // raced a request
+    {
+        std::lock_guard<std::mutex> lk(g_abort_mu);
+        g_active_hint = false;
+    }
+    if (diag_verbose()) write_diag("dll", hint->focus.size(), 0, "prefill hint status " + std::to_string(status));
+}
+
+static void worker_loop() {
+    std::deque<AnalyzeRequest> pending;
+    uint64_t turn = 0;
+    bool shutdown = false;
+    for (;;) {
+        t_conn = nullptr;
+        const bool loading = g_model_state.load() == MODEL_LOADING;
+        if (loading) serve_without_model(pending);
+        if ((pending.empty() || loading) && !shutdown && (loading || !g_next_hint)) {
+            AnalyzeRequest r;
+            g_inbox.Pop(r);
+            if (r.id == kShutdownId) shutdown = true;
+            else if (r.id != kWakeId && !hold_hint(r)) pending.push_back(std::move(r));
+        }
+        shutdown |= drain_inbox(pending);
+        if (loading && !shutdown) continue; // wait for more requests or the wake token
+        if (pending.empty()) {
+            if (shutdown) return;
+            if (g_next_hint) run_next_hint();
+            continue;
+        }
+
+        // Most urgent class first; within a class clients take turns, each in arrival order.
+        // Work of clients that left is dropped here.
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->conn->open.load()) { ++it; continue; }
+            dequeued(*it);
+            it = pending.erase(it);
+        }
+        if (pending.empty()) continue;
+        auto next = pending.begin();
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+            if (it->priority < next->priority ||
+                (it->priority == next->priority && it->conn->served < next->conn->served)) next = it;
+        AnalyzeRequest req = std::move(*next);
+        pending.erase(next);
+        dequeued(req);
+        req.conn->served = ++turn;
+        t_conn = req.conn.get();
+        const long long queue_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - req.received).count();
+        g_stages.Record(HS_QUEUE, static_cast<uint64_t>(std::max(0LL, queue_us)));
+        g_class_wait.Record(req.priority, static_cast<uint64_t>(std::max(0LL, queue_us)));
+
+        // Deadline spent in the queue, or what is left cannot cover the learned service time:
+        // answer without the model if possible, otherwise drop it before it costs a generation.
+        const uint64_t need_us = estimate_for(req);
+        const long long left_ms = req.deadline_ms ? static_cast<long long>(req.deadline_ms) - queue_us / 1000 : 0;
+        if (req.deadline_ms && (left_ms <= 0 || static_cast<uint64_t>(left_ms) * 1000 < need_us)) {
+            std::string reply = req.document || req.peeked ? std::string() : peek_answer(req);
+            if (reply.empty()) reply = deadline_rejection(req, static_cast<uint64_t>(queue_us));
+            write_msg(with_queue_us(std::move(reply), queue_us));
+            g_stages.Since(HS_TOTAL, req.received);
+            continue;
+        }
+        req.budget_ms = req.deadline_ms ? static_cast<uint32_t>(left_ms) : 0;
+
+        // Publish first, then re-drain: a newer request that raced the publish
+        // is either seen here or sees us in submit_analyze.
+        {
+            std::lock_guard<std::mutex> lk(g_abort_mu);
+            g_active_superseded = false;
+            g_active_yield = false;
+            g_active_until_us = steady_us() + static_cast<long long>(need_us);
+            g_active_yieldable = req.document && req.priority == PRIO_BACKGROUND;
+            g_active_priority = req.priority;
+            g_active_session = session_key(req.session);
+            g_active_conn = req.conn->id;
+        }
+        shutdown |= drain_inbox(pending);
+        // (a client that left just before the publish counts as superseded)
+        const bool newer_queued = !req.conn->open.load() || (!req.session.empty() &&
+            std::any_of(pending.begin(), pending.end(),
+                [&](const AnalyzeRequest& p) { return p.session == req.session; }));
+        const bool urgent_queued = g_active_yieldable.load() &&
+            std::any_of(pending.begin(), pending.end(),
+                [&](const AnalyzeRequest& p) { return p.priority < req.priority; });
+
+        const auto t_service = StageClock::now();
+        int status = PR_OK;
+        size_t sentences = 0;
+        std::string reply;
+        if (newer_queued) reply = aborted_frame(req.id, "superseded");
+        else if (!urgent_queued) reply = req.document ? handle_document(req, status, sentences) : handle_analyze(req);
+        bool superseded = false, yielded = false;
+        {
+            std::lock_guard<std::mutex> lk(g_abort_mu);
+            superseded = g_active_superseded.exchange(false);
+            yielded = !newer_queued && !superseded && (urgent_queued ||
+                (g_active_yield.load() && status == PR_CANCELLED));
+            g_active_session = 0;
+            g_active_conn = 0;
+            g_active_priority = -1;
+            g_active_yieldable = false;
+            g_active_yield = false;
+        }
+
+        // Stepped aside for more urgent work: back to the head of its class, no reply yet
+        // (sentences already reported come back from the result cache on resume).
+        if (yielded) {
+            enqueued(req);
+            pending.push_front(std::move(req));
+            ++g_yielded;
+            continue;
+        }
+        if (superseded || newer_queued) ++g_superseded;
+        if (superseded) reply = aborted_frame(req.id, "superseded");
+        else if (!newer_queued) {
+            const uint64_t service_us = AppUtils::StageStats::Us(t_service, StageClock::now());
+            if (!req.document && reply.find("\"type\":\"aborted\"") == std::string::npos) learn_service(SVC_ANALYZE, service_us);
+            if (req.document && status == PR_OK && sentences) learn_service(SVC_SENTENCE, service_us / sentences);
+        }
+        write_msg(with_queue_us(std::move(reply), queue_us));
+        g_stages.Since(HS_TOTAL, req.received);
+    }
+}
+
+// ===================================================================
+// main
+// ===================================================================
+// Install-time prefix snapshot; plain stdout (no Native Messaging framing)
+static int bake_prefix_main() {
+    g_diag_level = 0;
+    try_load_lib();
+    if (!g_lib || !g_bake_prefix) {
+        std::printf("{\"ok\":false,\"error\":\"%s\"}\n", g_lib ? "polite_rewrite_bake_prefix not exported" : "library not loaded");
+        return 1;
+    }
+    const char* p = g_bake_prefix();
+    const std::string result = p ? p : "";
+    if (p && g_free) g_free(p);
+    std::printf("%s\n", result.c_str());
+    JsonReader r;
+    return r.Parse(result) && r.Bool("ok") ? 0 : 1;
+}
+
+// ===================================================================
+// Per-user daemon / thin client
+// ===================================================================
+static std::string env_value(const char* name) {
+#ifdef _WIN32
+    char buf[1024]{}; size_t n = 0;
+    if (getenv_s(&n, buf, name) != 0 || n == 0) return std::string();
+    return buf;
+#else
+    const char* v = std::getenv(name);
+    return v ? v : "";
+#endif
+}
+
+static std::string exe_path_utf8() {
+#ifdef _WIN32
+    wchar_t buf[MAX_PATH]{};
+    const DWORD n = GetModuleFileNameW(nullptr, buf, MAX_PATH);
+    return (n && n < MAX_PATH) ? w_to_utf8(std::wstring(buf, n)) : std::string();
+#else
+    char buf[PATH_MAX]{};
+    const ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+    return n > 0 ? std::string(buf, static_cast<size_t>(n)) : std::string();
+#endif
+}
+
+// Keyed by what decides the model the daemon loads: hosts that differ never share one
+static std::string daemon_address() {
+    std::string addr = env_value("PC_DAEMON_ADDR");
+    if (!addr.empty()) return addr;
+    const uint64_t h = session_key(exe_path_utf8() + '\n' + env_value("PC_SUGGESTION_DLL") + '\n' +
+        env_value("PC_MODEL_BASE_DIR") + '\n' + env_value("PC_CONFIG_PATH"));
+    char name[40];
+    std::snprintf(name, sizeof(name), "PaperClip-%08llx", static_cast<unsigned long long>(h & 0xffffffffull));
+    return AppUtils::LocalAddress(name);
+}
+
+// Detached `PaperClipHost --daemon` that outlives this client
+static bool spawn_daemon() {
+#ifdef _WIN32
+    wchar_t exe[MAX_PATH]{};
+    const DWORD n = GetModuleFileNameW(nullptr, exe, MAX_PATH);
+    if (!n || n >= MAX_PATH) return false;
+    std::wstring cmd = L"\"" + std::wstring(exe, n) + L"\" --daemon";
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi{};
+    // The browser may keep hosts in a job that is closed with them; break away when allowed
+    const DWORD flags = DETACHED_PROCESS | CREATE_NEW_PROCESS_GROUP;
+    if (!CreateProcessW(exe, &cmd[0], nullptr, nullptr, FALSE, flags | CREATE_BREAKAWAY_FROM_JOB, nullptr, nullptr, &si, &pi) &&
+        !CreateProcessW(exe, &cmd[0], nullptr, nullptr, FALSE, flags, nullptr, nullptr, &si, &pi)) {
+        log_last_err("CreateProcessW(--daemon)");
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return true;
+#else
+    const std::string exe = exe_path_utf8();
+    if (exe.empty()) return false;
+    const pid_t pid = ::fork();
+    if (pid < 0) return false;
+    if (pid == 0) { // only async-signal-safe calls until exec
+        ::setsid();
+        if (::fork() != 0) ::_exit(0); // the daemon is reparented: no zombie left to this client
+        const int null_fd = ::open("/dev/null", O_RDWR);
+        if (null_fd >= 0) { ::dup2(null_fd, 0); ::dup2(null_fd, 1); ::dup2(null_fd, 2); }
+        for (int fd = 3; fd < 1024; ++fd) ::close(fd); // the browser's pipes must not stay open in it
+        ::execl(exe.c_str(), exe.c_str(), "--daemon", static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return true;
+#endif
+}
+
+static size_t read_stdin(char* p, size_t n) {
+#ifdef _WIN32
+    DWORD got = 0;
+    return ReadFile(GetStdHandle(STD_INPUT_HANDLE), p, static_cast<DWORD>(n), &got, nullptr) ? got : 0;
+#else
+    for (;;) {
+        const ssize_t got = ::read(STDIN_FILENO, p, n);
+        if (got < 0 && errno == EINTR) continue;
+        return got > 0 ? static_cast<size_t>(got) : 0;
+    }
+#endif
+}
+
+// Thin client: bytes both ways, framing untouched. Either side closing ends the process;
+// the extension reconnects (and a daemon that died is started again).
+static int relay_main(AppUtils::LocalStream* stream) { // owned until process exit
+    std::thread([stream] {
+        std::vector<char> buf(64u << 10);
+        for (;;) {
+            const size_t n = stream->ReadSome(buf.data(), buf.size());
+            if (n == 0 || !write_raw(buf.data(), n)) break;
+        }
+        std::exit(0);
+    }).detach();
+    std::vector<char> buf(64u << 10);
+    for (;;) {
+        const size_t n = read_stdin(buf.data(), buf.size());
+        if (n == 0 || !stream->Write(buf.data(), n)) break;
+    }
+    stream->Shutdown(); // the daemon sees EOF: drops this client's queue, stops its running request
+    return 0;
+}
+
+static void serve_client(std::shared_ptr<Conn> conn) {
+    std::atomic<bool> writer_done{ false };
+    std::thread writer([&] { writer_loop(*conn); writer_done = true; });
+    if (g_model_state.load() != MODEL_UNAVAILABLE) send_to(*conn, status_frame()); // loaded long ago, maybe
+    reader_loop(conn);
+    conn->stream->Shutdown(); // pending writes fail at once
+    while (!writer_done.load() && !conn->outbox.TryPush(std::string())) std::this_thread::yield();
+    writer.join();
+    std::lock_guard<std::mutex> lk(g_conns_mu);
+    g_conns.erase(std::remove(g_conns.begin(), g_conns.end(), conn), g_conns.end());
+}
+
+static int daemon_main() {
+    AppUtils::LocalListener listener;
+    if (!listener.Listen(daemon_address())) return 1; // another daemon has it
+    const std::string idle_env = env_value("PC_DAEMON_IDLE_S");
+    const long long idle_s = idle_env.empty() ? 600 : std::max(1LL, std::atoll(idle_env.c_str()));
+
+    try_load_lib();
+    start_model_load(); // before the first client: a browser that starts it finds the model loading
+    std::thread worker(worker_loop);
+
+    uint64_t next_id = 0;
+    auto idle_since = StageClock::now();
+    for (;;) {
+        std::unique_ptr<AppUtils::LocalStream> stream = listener.Accept(1000);
+        if (stream) {
+            auto conn = std::make_shared<Conn>();
+            conn->id = ++next_id;
+            conn->stream = std::move(stream);
+            {
+                std::lock_guard<std::mutex> lk(g_conns_mu);
+                g_conns.push_back(conn);
+            }
+            std::thread(serve_client, std::move(conn)).detach();
+            continue;
+        }
+        size_t clients = 0;
+        {
+            std::lock_guard<std::mutex> lk(g_conns_mu);
+            clients = g_conns.size();
+        }
+        if (clients) idle_since = StageClock::now();
+        else if (AppUtils::StageStats::Us(idle_since, StageClock::now()) / 1000000 >= static_cast<uint64_t>(idle_s)) break;
+    }
+    listener.Close();
+    AnalyzeRequest stop;
+    stop.id = kShutdownId;
+    g_inbox.Push(std::move(stop));
+    worker.join();
+    return 0;
+}
+
+// --reload: one frame out, then reload_stats polls until the daemon's load is done
+static int reload_main() {
+    std::unique_ptr<AppUtils::LocalStream> stream = AppUtils::LocalStream::Connect(daemon_address());
+    if (!stream) {
+        std::printf("{\"ok\":false,\"error\":\"no daemon running\"}\n");
+        return 1;
+    }
+    auto send = [&](const std::string& msg) {
+        const uint32_t len = static_cast<uint32_t>(msg.size());
+        return stream->Write(&len, 4) && stream->Write(msg.data(), msg.size());
+    };
+    auto reply = [&](std::string_view want, std::string& out) { // skips status frames etc.
+        JsonReader r;
+        for (;;) {
+            uint32_t len = 0;
+            if (!stream->Read(&len, 4) || len == 0) return false;
+            out.assign(len, '\0');
+            if (!stream->Read(&out[0], len)) return false;
+            if (r.Parse(out) && r.String("type") == want) return true;
+        }
+    };
+    std::string frame;
+    if (!send("{\"type\":\"reload\"}") || !reply("reload", frame)) {
+        std::printf("{\"ok\":false,\"error\":\"daemon closed the connection\"}\n");
+        return 1;
+    }
+    JsonReader r, stats;
+    if (!r.Parse(frame) || r.String("state") != "started") {
+        std::printf("%s\n", frame.c_str());
+        return 1;
+    }
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!send("{\"type\":\"reload_stats\"}") || !reply("reload_stats", frame)) return 1;
+        if (r.Parse(frame) && stats.Parse(r.Raw("reload")) && stats.String("state") != "loading") break;
+    }
+    std::printf("%s\n", std::string(r.Raw("reload")).c_str());
+    JsonReader last;
+    return last.Parse(stats.Raw("last")) && last.Bool("ok") ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--bake-prefix") == 0) return bake_prefix_main();
+    if (argc > 1 && std::strcmp(argv[1], "--reload") == 0) return reload_main();
+    if (const std::string d = env_value("PC_DIAG"); !d.empty()) g_diag_level = std::atoi(d.c_str());
+    if (argc > 1 && std::strcmp(argv[1], "--daemon") == 0) return daemon_main();
+
+    // Browser launch: relay to the shared daemon, starting it if needed
+    bool daemon_failed = false;
+    if (env_value("PC_DAEMON") != "0") {
+        const std::string addr = daemon_address();
+        std::unique_ptr<AppUtils::LocalStream> stream = AppUtils::LocalStream::Connect(addr);
+        if (!stream && spawn_daemon()) {
+            for (int i = 0; i < 100 && !stream; ++i) { // ~5 s for the daemon to listen
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                stream = AppUtils::LocalStream::Connect(addr);
+            }
+        }
+        if (stream) {
+            isolate_stdout();
+            return relay_main(stream.release());
+        }
+        daemon_failed = true;
+    }
+
+    // In-process: this host owns the model
+    isolate_stdout();
+    auto stdio = std::make_shared<Conn>();
+    {
+        std::lock_guard<std::mutex> lk(g_conns_mu);
+        g_conns.push_back(stdio);
+    }
+    std::thread writer(writer_loop, std::ref(*stdio));
+    if (daemon_failed) write_diag("host", 0, 0, "daemon unreachable: loading the model in-process");
+
+    try_load_lib();
+    write_diag("host", 0, 0, g_lib ? "startup-load-ok" : "startup-load-fail");
+    start_model_load(); // model init overlaps the browser's first messages
+
+    std::thread reader(reader_loop, stdio);
+    worker_loop();
+
+    reader.join();
+    stdio->outbox.Push(std::string()); // stop token: writer drains what is queued, then exits
+    writer.join();
     return 0;
 }
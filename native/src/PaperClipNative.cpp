@@ -4,21 +4,39 @@
 // ---------------------------------------------------------------------
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include <cstring>   // memcpy
 #include <cstdlib>   // malloc, free
-
-#include "GenieCommon.h"
-#include "GenieDialog.h"
+#include <cstdio>    // snprintf
 
 #include "PaperClipNative.h"
+#include "InferenceBackend.hpp"
 #include "PromptHandler.hpp"
+#include "JsonArrayStream.hpp"
+#include "ResultCache.hpp"
+#include "ComposeSessions.hpp"
+#include "ToneClassifier.hpp"
+#include "Json.hpp"
+#include "StageStats.hpp"
+#include "EngineProfiles.hpp"
+#include "HardwareProbe.hpp"
+#include "FilePrefetch.hpp"
+#include "BackendPool.hpp"
 
 #ifdef _WIN32
 #include <Windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
 #endif
 
 namespace fs = std::filesystem;
@@ -26,26 +44,106 @@ namespace fs = std::filesystem;
 // ─────────────────────────── Shared state ────────────────────────────
 static std::mutex                 g_mu;
 static bool                       g_inited = false;
+static std::atomic<uint64_t>      g_generation{ 0 };    // loads so far (init + reloads); the serving one's number
 static std::string                g_base_dir;          // where genie_bundle/ resides
 static std::string                g_config_path;       // path to genie_config.json
-static GenieDialogConfig_Handle_t g_cfg = nullptr;
-static GenieDialog_Handle_t       g_dlg = nullptr;
+static std::string                g_cache_dir;         // base dir whose result_cache.bin is open
+static AppUtils::BackendPool      g_pool;              // loaded instances; a query leases one
 
-struct CwdGuard {
-    fs::path old;
-    CwdGuard(const fs::path& to) : old(fs::current_path()) { fs::current_path(to); }
-    ~CwdGuard() { std::error_code ec; fs::current_path(old, ec); }
+// What the serving load reports. Init and reload publish a new one under g_mu; queries and
+// warmup take a snapshot (engine_info()) without it, so a reload never rewrites what they read.
+struct EngineInfo {
+    std::string kind;
+    std::string profile;                 // engine_profiles.json entry applied ("" = none)
+    std::string profile_skip;            // why a profiles file was present but not applied
+    const char* prefix_source = "none";  // "snapshot" | "prefill" | "none" (first slot)
+    uint64_t    prefetched = 0;          // model file read-ahead during the load
+    uint32_t    context_tokens = 0;      // backend context window (budget per prefix variant)
+    std::string context_note;            // variants whose budget is 0 (compose context off)
+    size_t      pool_wanted = 1;         // "pool": {"size": N}
+    std::string pool_note;               // why the pool is smaller than wanted
+    std::string verdict_kind;            // the small verdict model's backend
+    std::string verdict_note;            // why verdict-config was not loaded
+    uint32_t    verdict_tokens = 0;      // the small model's context window
 };
+static std::shared_ptr<const EngineInfo> g_info = std::make_shared<const EngineInfo>();
 
-// ───────────────────────────── Helpers ───────────────────────────────
-static std::string utf8_from_w(const wchar_t* w) {
-    if (!w) return {};
-    int len = WideCharToMultiByte(CP_UTF8, 0, w, -1, nullptr, 0, nullptr, nullptr);
-    std::string s(len ? len - 1 : 0, '\0');
-    if (len > 1) WideCharToMultiByte(CP_UTF8, 0, w, -1, s.data(), len, nullptr, nullptr);
-    return s;
-}
+static std::shared_ptr<const EngineInfo> engine_info() { return std::atomic_load(&g_info); }
+static std::atomic<bool>          g_rewind_ok{ true };     // SDK honours SENTENCE_REWIND prefix matching
+static std::atomic<bool>          g_per_language{ true };  // "prompt": {"per-language": false} → monolithic block only
+static std::atomic<uint64_t>      g_prefix_switches{ 0 };  // queries whose system block was not in the KV
+static std::atomic<uint64_t>      g_prefix_restores{ 0 };  // ...and were served from the block's snapshot
+
+using Slot = AppUtils::BackendPool::Slot;
+
+// Result cache (memory LRU + mmap file beside genie_config.json's base dir)
+static AppUtils::ResultCache      g_cache;
+static std::atomic<bool>          g_cache_ready{ false }; // set once identity + file are open
+static std::atomic<uint64_t>      g_model_identity{ 0 };  // config text + bundle file stamps (of the serving load)
+
+// Fast path: clearly polite sentences get a verdict without touching the model
+static AppUtils::ToneClassifier   g_tone;
+
+// Compose sessions: per-window context KV, snapshotted when another window takes an instance.
+// g_sess_mu guards g_sessions and the snapshot dirs (never held while waiting on g_mu or the pool).
+static std::mutex                 g_sess_mu;
+static AppUtils::ComposeSessions  g_sessions;
+
+// ─────────────────────── Cancellation / deadline ─────────────────────
+// COMPLETE/BUDGET are raised from our own token callback and are not errors
+enum AbortReason : int {
+    ABORT_NONE = 0, ABORT_CANCELLED = 1, ABORT_DEADLINE = 2,
+    ABORT_COMPLETE = 3,  // answer array closed — the rest would be commentary
+    ABORT_BUDGET = 4,    // per-request token budget spent
+    ABORT_VERDICT = 5    // tone flag settled the answer — the rewrites are not wanted
+};
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint32_t> g_deadline_ms{ 0 };           // 0 = no deadline
+static std::atomic<uint64_t> g_abort_epoch{ 0 };           // polite_rewrite_abort calls (batches stop between sentences)
+// Never destroyed: the detached watchdog is still waiting on them at process exit
+static std::mutex&           g_wd_mu = *new std::mutex;    // guards g_wd_armed
+static std::condition_variable& g_wd_cv = *new std::condition_variable;
+static std::vector<std::pair<Slot*, Clock::time_point>>& g_wd_armed =
+    *new std::vector<std::pair<Slot*, Clock::time_point>>; // leased slots with a deadline
 
+// ───────────────────────── Decode counters ───────────────────────────
+// Summed over every instance since load; tokens/s is the effective decode rate (first
+// token → last), so a draft model's speedup shows up directly
+static std::atomic<bool>     g_dec_speculative{ false };
+static std::atomic<uint64_t> g_dec_queries{ 0 }, g_dec_tokens{ 0 }, g_dec_us{ 0 };
+static std::atomic<uint64_t> g_dec_drafted{ 0 }, g_dec_accepted{ 0 }, g_dec_passes{ 0 };
+
+// ───────────────────────────── Cascade ───────────────────────────────
+// Most Targets come back "polite" and their rewrites are never opened, so decoding stops
+// at the tone flag unless the policy or the caller wants the rewrites. An optional small
+// model ("verdict-config") gives that flag without waking the main model at all.
+enum Escalate : int {
+    ESCALATE_IMPOLITE = 0, // rewrite unless the flag is "polite" (an unclear flag escalates)
+    ESCALATE_ALWAYS = 1,   // always the full answer (no early exit)
+    ESCALATE_NEVER = 2     // flag only; rewrites only when the caller asks for alternatives
+};
+static const char* const kEscalateNames[] = { "impolite", "always", "never" };
+static std::atomic<int>      g_escalate{ ESCALATE_IMPOLITE };
+static AppUtils::BackendPool g_verdict_pool;       // small verdict model (empty = main model decides)
+
+// Which tier answered; counted per answer, read by polite_rewrite_cascade_stats
+enum Tier : int {
+    TIER_FASTPATH = PR_TIER_FASTPATH, TIER_CACHE = PR_TIER_CACHE, TIER_VERDICT = PR_TIER_VERDICT,
+    TIER_REWRITE = PR_TIER_REWRITE, TIER_COUNT
+};
+static const char* const kTierNames[TIER_COUNT] = { "fastpath", "cache", "verdict", "rewrite" };
+static std::atomic<uint64_t> g_tiers[TIER_COUNT];
+static std::atomic<uint64_t> g_small_verdicts{ 0 }, g_small_escalations{ 0 };
+
+// ───────────────────────── Stage histograms ──────────────────────────
+// µs per stage (decode_tps: tokens/s); lock-free, read by polite_rewrite_stage_stats
+enum Stage : int {
+    ST_INIT, ST_PREFIX, ST_PROMPT, ST_PREFILL, ST_FIRST_TOKEN, ST_DECODE, ST_DECODE_TPS, ST_TOTAL
+};
+static AppUtils::StageStats  g_stages{ "init", "prefix", "prompt", "prefill", "first_token", "decode", "decode_tps", "total" };
+
+// ───────────────────────────── Helpers ───────────────────────────────
 static fs::path dll_dir() {
 #ifdef _WIN32
     HMODULE hMod = nullptr;
@@ -58,7 +156,9 @@ static fs::path dll_dir() {
     DWORD n = GetModuleFileNameW(hMod, buf, MAX_PATH);
     return fs::path(buf, buf + (n ? n : 0)).parent_path();
 #else
-    return fs::current_path();
+    Dl_info info{};
+    if (!dladdr(reinterpret_cast<void*>(&dll_dir), &info) || !info.dli_fname) return fs::current_path();
+    return fs::absolute(info.dli_fname).parent_path();
 #endif
 }
 
@@ -69,30 +169,8 @@ static std::string slurp(const fs::path& p) {
     return s;
 }
 
-// ---------- JSON-safe helpers ----------
-static std::string json_escape(const std::string& s) {
-    std::string out; out.reserve(s.size() + 16);
-    for (unsigned char c : s) {
-        switch (c) {
-        case '\"': out += "\\\""; break;
-        case '\\': out += "\\\\"; break;
-        case '\b': out += "\\b";  break;
-        case '\f': out += "\\f";  break;
-        case '\n': out += "\\n";  break;
-        case '\r': out += "\\r";  break;
-        case '\t': out += "\\t";  break;
-        default:
-            if (c < 0x20) {
-                char buf[7]; std::snprintf(buf, sizeof(buf), "\\u%04X", (unsigned)c);
-                out += buf;
-            }
-            else {
-                out.push_back((char)c);
-            }
-        }
-    }
-    return out;
-}
+// ---------- JSON-safe helpers (Json.hpp) ----------
+using AppUtils::JsonEscape;
 
 static char* heap_dup(const std::string& s) {
     char* c = (char*)std::malloc(s.size() + 1);
@@ -108,52 +186,610 @@ static std::string make_error_json(const std::string& stage,
     const std::string& config_path) {
     // ASCII-only JSON
     std::string j = "{";
-    j += "\"error\":\"" + json_escape(message) + "\",";
-    j += "\"stage\":\"" + json_escape(stage) + "\",";
+    j += "\"error\":\"" + JsonEscape(message) + "\",";
+    j += "\"stage\":\"" + JsonEscape(stage) + "\",";
     j += "\"context\":{";
-    j += "\"base_dir\":\"" + json_escape(base_dir) + "\",";
-    j += "\"config_path\":\"" + json_escape(config_path) + "\"";
+    j += "\"base_dir\":\"" + JsonEscape(base_dir) + "\",";
+    j += "\"config_path\":\"" + JsonEscape(config_path) + "\"";
     j += "}";
     j += "}";
     return j;
 }
 
-// ---------- init ----------
-static void ensure_init_locked() {
-    if (g_inited) return;
+// ---------- abort / watchdog ----------
+// Only called while the slot is leased (or under g_wd_mu / the pool lock, which a lease
+// must pass to be returned), so the backend cannot be freed underneath.
+static void signal_abort(Slot& s, AbortReason why) {
+    if (!s.active.load()) return;
+    int expected = ABORT_NONE;
+    if (!s.abort_reason.compare_exchange_strong(expected, why)) return; // already aborting
+    s.backend->Abort();
+}
+
+// One long-lived thread enforces per-request deadlines so a stuck decode
+// cannot hold an instance past the caller's budget. The budget runs from `since`
+// (request start), so time spent waiting for a free instance counts too.
+static void watchdog_arm(Slot& s, Clock::time_point since, uint32_t ms) {
+    if (!ms) return;
+    static std::once_flag once;
+    std::call_once(once, [] {
+        std::thread([] {
+            std::unique_lock<std::mutex> lk(g_wd_mu);
+            for (;;) {
+                if (g_wd_armed.empty()) {
+                    g_wd_cv.wait(lk);
+                    continue;
+                }
+                Clock::time_point next = Clock::time_point::max();
+                for (const auto& a : g_wd_armed) next = std::min(next, a.second);
+                g_wd_cv.wait_until(lk, next);
+                const Clock::time_point now = Clock::now();
+                for (auto it = g_wd_armed.begin(); it != g_wd_armed.end();) {
+                    if (now < it->second) { ++it; continue; }
+                    signal_abort(*it->first, ABORT_DEADLINE); // disarm needs g_wd_mu: slot still leased
+                    it = g_wd_armed.erase(it);
+                }
+            }
+        }).detach();
+    });
+    {
+        std::lock_guard<std::mutex> lk(g_wd_mu);
+        g_wd_armed.emplace_back(&s, since + std::chrono::milliseconds(ms));
+    }
+    g_wd_cv.notify_one();
+}
+
+static void watchdog_disarm(Slot& s) {
+    {
+        std::lock_guard<std::mutex> lk(g_wd_mu);
+        g_wd_armed.erase(std::remove_if(g_wd_armed.begin(), g_wd_armed.end(),
+            [&](const std::pair<Slot*, Clock::time_point>& a) { return a.first == &s; }), g_wd_armed.end());
+    }
+    g_wd_cv.notify_one();
+}
+
+// One Generate on a leased slot: abortable and under the request's deadline until scope exit
+struct ActiveScope {
+    Slot& s;
+    ActiveScope(Slot& slot, Clock::time_point since, uint32_t deadline_ms) : s(slot) {
+        s.abort_reason = ABORT_NONE;
+        s.active = true;
+        watchdog_arm(s, since, deadline_ms);
+    }
+    ~ActiveScope() { watchdog_disarm(s); s.active = false; }
+};
+
+// ---------- one load ----------
+// Everything a load reads and produces. Init builds one under g_mu and installs it; a hot
+// reload builds the next one off-lock while the current instances keep serving, then swaps.
+struct Engine {
+    uint64_t    generation = 0;
+    std::string base_dir, config_path;     // absolute
+    std::string kind, profile, profile_skip;
+    uint64_t    identity = 0;              // model/config identity (cache keys, baked snapshot tag)
+    uint64_t    prefetched = 0;
+    bool        speculative = false;
+    bool        per_language = true;
+    const char* prefix_source = "none";
+    uint32_t    context_tokens = 0;
+    std::string context_note;
+    size_t      pool_wanted = 1;
+    std::string pool_note;
+    int         escalate = ESCALATE_IMPOLITE;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::unique_ptr<Slot>> verdict_slots; // empty = the main model decides
+    std::string verdict_kind, verdict_note;
+    uint32_t    verdict_tokens = 0;
+};
+
+// ---------- system prefix KV reuse ----------
+// The system block never changes, so it is prefilled once right after each
+// instance is loaded. Each request then generates with rewind: the backend
+// rewinds the KV cache to the longest token prefix shared with the new
+// prompt (always the whole system block) and prefills only the Target turn.
+//
+// With "per-language" (the default) there is one compact block per script (ko/ja/en,
+// picked by PromptHandler::PrefixVariant) plus the monolithic one for anything else.
+// Each is prefilled once and saved to its own snapshot, so a query in another language
+// restores its block instead of prefilling it. The last one primed stays resident.
+static std::vector<std::string> prompt_variants(bool per_language) {
+    if (!per_language) return { "all" };
+    return AppUtils::PromptHandler::PrefixVariants();
+}
+
+static std::string prompt_variant_for(const std::string& target, const std::string& language) {
+    return g_per_language ? AppUtils::PromptHandler::PrefixVariant(target, language) : std::string("all");
+}
+
+// dir: where this instance keeps its variant snapshots (unused with a single variant)
+static void prime_prefix(Slot& s, const std::vector<std::string>& variants, const fs::path& dir) {
+    s.prefix_dirs.clear();
+    s.prefix_primed = false;
+    s.kv_text.clear();
+    for (const std::string& v : variants) {
+        const std::string& prefix = AppUtils::PromptHandler::SystemPrefix(v);
+        if (!s.backend->Reset() || !s.backend->Prefill(prefix)) {
+            s.backend->Reset();
+            s.prefix_primed = false;
+            s.kv_text.clear();
+            return;
+        }
+        s.prefix_primed = true;
+        s.kv_text = prefix;
+        if (variants.size() < 2) continue;
+        std::error_code ec;
+        fs::create_directories(dir / v, ec);
+        if (s.backend->Save((dir / v).u8string())) s.prefix_dirs[v] = (dir / v).u8string();
+    }
+}
+
+// Before a REWIND query: unless the KV already starts with the variant's block, restore the
+// block's snapshot. Without one (or on failure) REWIND simply prefills it.
+static void enter_prefix(Slot& s, const std::string& variant) {
+    const std::string& prefix = AppUtils::PromptHandler::SystemPrefix(variant);
+    if (s.kv_text.compare(0, prefix.size(), prefix) == 0) return;
+    ++g_prefix_switches;
+    auto it = s.prefix_dirs.find(variant);
+    if (it == s.prefix_dirs.end()) return;
+    if (s.backend->Restore(it->second)) {
+        s.kv_text = prefix;
+        ++g_prefix_restores;
+        return;
+    }
+    s.prefix_dirs.erase(it);
+    s.backend->Reset();
+    s.kv_text.clear();
+}
+
+// ---------- baked prefix snapshot ----------
+// polite_rewrite_bake_prefix() (run once at install time) saves the backend state right
+// after the system prefix to prefix_snapshot/ beside the config. A restarted host then
+// restores it instead of prefilling, as long as backend, model identity and prompt match.
+static fs::path prefix_snapshot_dir(const std::string& config_path) {
+    return fs::path(config_path).parent_path() / "prefix_snapshot";
+}
+
+static std::string hex64(uint64_t v) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+// Variant names are hashed too: a bake laid out for other variants never matches
+static uint64_t prefix_hash(const std::vector<std::string>& variants) {
+    std::string material;
+    for (const std::string& v : variants) {
+        material += v;
+        material += '\n';
+        material += AppUtils::PromptHandler::SystemPrefix(v);
+    }
+    return AppUtils::ResultCache::Hash64(material.data(), material.size());
+}
+
+// One subdirectory per variant. Each is restored and saved again as this instance's own
+// snapshot: the baked files may be rewritten by a later bake while the host is running.
+static bool restore_prefix_snapshot(Slot& s, const Engine& e, const fs::path& own) {
+    const fs::path dir = prefix_snapshot_dir(e.config_path);
+    std::error_code ec;
+    if (!fs::is_regular_file(dir / "snapshot.json", ec)) return false;
+
+    const std::vector<std::string> variants = prompt_variants(e.per_language);
+    const std::string meta_text = slurp(dir / "snapshot.json");
+    AppUtils::JsonReader meta;
+    if (!meta.Parse(meta_text) || meta.String("backend") != e.kind ||
+        meta.String("model") != hex64(e.identity) || meta.String("prompt") != hex64(prefix_hash(variants))) {
+        return false; // stale: model, config or prompt changed since the bake
+    }
+    s.prefix_dirs.clear();
+    for (const std::string& v : variants) {
+        if (!s.backend->Restore((dir / v).u8string())) {
+            s.backend->Reset();
+            s.prefix_dirs.clear();
+            return false;
+        }
+        if (variants.size() < 2) continue;
+        fs::create_directories(own / v, ec);
+        if (s.backend->Save((own / v).u8string())) s.prefix_dirs[v] = (own / v).u8string();
+    }
+    s.prefix_primed = true;
+    s.kv_text = AppUtils::PromptHandler::SystemPrefix(variants.back());
+    return true;
+}
+
+// Files worth reading ahead while the backend loads: genie ctx-bins (every engine, so the
+// draft model's too), or the cpu GGUF and its draft
+static std::vector<std::string> model_files_for(const std::string& cfg_json, const std::string& kind,
+    const std::string& base_dir) {
+    std::vector<std::string> files;
+    if (kind == "cpu") {
+        const std::string options = AppUtils::InferenceBackendOptions(cfg_json, "cpu"); // opts' views point into it
+        AppUtils::JsonReader opts;
+        if (opts.Parse(options)) {
+            if (opts.Has("model")) files.emplace_back(opts.String("model"));
+            if (opts.Has("draft")) files.emplace_back(opts.String("draft"));
+        }
+    }
+    else {
+        std::string scan = cfg_json;
+        AppUtils::JsonMapMembers(scan, "ctx-bins", [&](std::string_view raw) {
+            std::vector<std::string> bins;
+            AppUtils::JsonParseStringArray(raw, bins);
+            files.insert(files.end(), bins.begin(), bins.end());
+            return std::string(raw);
+        });
+    }
+    for (std::string& f : files) {
+        const fs::path p = fs::u8path(f);
+        if (p.is_relative()) f = (fs::u8path(base_dir) / p).u8string();
+    }
+    return files;
+}
 
+// ---------- compose context ----------
+// Context goes in front of the Target, so as the user keeps writing the new
+// prompt extends the previous one and REWIND only prefills the added sentences.
+// Compose windows share the pooled instances: an instance switching windows saves its KV
+// to the old window's snapshot and restores the new window's (LRU-bounded).
+
+// Context byte budget from the backend's context window, leaving room for the prompt's
+// system block (the compact per-language ones are about half the monolithic one), the
+// Target turn and the answer (~3 UTF-8 bytes per token is conservative).
+static size_t context_budget_for(uint32_t context_tokens, const std::string& variant) {
+    const long long ctx_tokens = context_tokens;
+    const long long prefix_tokens = (long long)AppUtils::PromptHandler::SystemPrefix(variant).size() / 4;
+    const long long spare = ctx_tokens - prefix_tokens - 256; // Target + 4-string answer
+    return spare > 0 ? (size_t)std::min<long long>(spare * 3, 4096) : 0;
+}
+
+// A window too small for any context says so (reported by warmup) instead of composing
+// prompts without it unnoticed
+static std::string context_note_for(uint32_t context_tokens, const std::vector<std::string>& variants) {
+    std::string off;
+    for (const std::string& v : variants) {
+        if (context_budget_for(context_tokens, v)) continue;
+        if (!off.empty()) off += ", ";
+        off += v + " (~" + std::to_string(AppUtils::PromptHandler::SystemPrefix(v).size() / 4) + " tokens)";
+    }
+    if (off.empty()) return std::string();
+    return "context size " + std::to_string(context_tokens) + " leaves no room after the answer and the system block of " +
+        off + ": compose context is off there";
+}
+
+static fs::path session_snapshot_root() {
+    std::error_code ec;
+    fs::path tmp = fs::temp_directory_path(ec);
+    if (ec) tmp = fs::path(g_base_dir);
+#ifdef _WIN32
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long)::getpid();
+#endif
+    return tmp / "PaperClip" / ("sessions-" + std::to_string(pid));
+}
+
+// Makes the slot hold `id`'s KV where possible and returns the context window to prompt
+// with. Correctness never depends on the snapshot: REWIND matches tokens, so a miss (or
+// another slot having moved the session's KV on since the save) only costs a longer prefill.
+// An instance retired by a reload finishes its query without one: the sessions now hold the
+// new model's KV.
+static std::string enter_session(Slot& s, const std::string& id, const std::string& context,
+    const std::string& variant) {
+    const size_t budget = context_budget_for(engine_info()->context_tokens, variant);
+    if (id.empty() || !g_rewind_ok || s.generation != g_generation) {
+        s.kv_session.clear();
+        AppUtils::ComposeSessions::Entry scratch;
+        return AppUtils::ComposeSessions::Window(scratch, context, budget);
+    }
+    std::lock_guard<std::mutex> lk(g_sess_mu);
+    if (id != s.kv_session) {
+        bool saved = false, restored = false;
+        if (auto* cur = g_sessions.Find(s.kv_session); cur && !cur->dir.empty()) {
+            std::error_code ec;
+            fs::create_directories(fs::u8path(cur->dir), ec);
+            cur->saved = saved = s.backend->Save(cur->dir);
+            if (saved) cur->last_prompt = s.kv_text;
+        }
+        AppUtils::ComposeSessions::Entry& next = g_sessions.Touch(id);
+        if (next.saved) {
+            next.saved = restored = s.backend->Restore(next.dir);
+            if (restored) s.kv_text = next.last_prompt;
+        }
+        g_sessions.RecordSwitch(saved, restored);
+        s.kv_session = id;
+    }
+    return AppUtils::ComposeSessions::Window(g_sessions.Touch(id), context, budget);
+}
+
+// ---------- init ----------
+static void resolve_paths(std::string& base_dir, std::string& config_path) {
     // Auto-discover defaults if not set
-    if (g_base_dir.empty())    g_base_dir = dll_dir().string();
-    if (g_config_path.empty()) g_config_path = (fs::path(g_base_dir) / "genie_config.json").string();
+    if (base_dir.empty())    base_dir = dll_dir().string();
+    if (config_path.empty()) config_path = (fs::path(base_dir) / "genie_config.json").string();
+    // Pinned once: backends get absolute paths and nothing later depends on the process CWD
+    std::error_code ec;
+    if (fs::path(base_dir).is_relative())    base_dir = fs::absolute(base_dir, ec).string();
+    if (fs::path(config_path).is_relative()) config_path = fs::absolute(config_path, ec).string();
+}
+
+static void resolve_paths_locked() {
+    resolve_paths(g_base_dir, g_config_path);
+}
 
-    // Validate presence
-    fs::path base(g_base_dir);
-    fs::path bundle = base / "genie_bundle";
+// "cascade": {"escalate": "impolite"|"always"|"never", "verdict-config": "<file>"}.
+// The verdict config is a second backend config (usually a small model), relative to the
+// main config's directory; "" when the main model gives the verdict itself.
+static fs::path verdict_config_path(const std::string& cfg_json, const std::string& config_path) {
+    AppUtils::JsonReader cfg, cascade;
+    if (!cfg.Parse(cfg_json) || !cascade.Parse(cfg.Raw("cascade")) || !cascade.Has("verdict-config")) return fs::path();
+    const fs::path p = fs::u8path(std::string(cascade.String("verdict-config")));
+    return p.is_relative() ? fs::path(config_path).parent_path() / p : p;
+}
+
+static int escalate_for(const std::string& cfg_json) {
+    AppUtils::JsonReader cfg, cascade;
+    if (!cfg.Parse(cfg_json) || !cascade.Parse(cfg.Raw("cascade"))) return ESCALATE_IMPOLITE;
+    const std::string_view v = cascade.String("escalate", "impolite");
+    return v == "always" ? ESCALATE_ALWAYS : v == "never" ? ESCALATE_NEVER : ESCALATE_IMPOLITE;
+}
+
+// Model/config identity for cache keys: the config text (and the verdict model's) plus
+// name, size and mtime of every file in genie_bundle. Cheap (no model bytes are read).
+static uint64_t compute_model_identity(const std::string& base_dir, const std::string& config_path) {
+    std::string material = slurp(config_path);
+    std::error_code ec;
+    const fs::path verdict_cfg = verdict_config_path(material, config_path);
+    if (!verdict_cfg.empty() && fs::is_regular_file(verdict_cfg, ec)) material += slurp(verdict_cfg);
+    const fs::path bundle = fs::path(base_dir) / "genie_bundle";
+    std::vector<std::string> stamps;
+    for (const auto& e : fs::directory_iterator(bundle, ec)) {
+        if (!e.is_regular_file(ec)) continue;
+        const auto size = e.file_size(ec);
+        const auto mtime = e.last_write_time(ec).time_since_epoch().count();
+        stamps.push_back(e.path().filename().string() + ":" + std::to_string(size) + ":" + std::to_string(mtime));
+    }
+    std::sort(stamps.begin(), stamps.end());
+    for (const auto& s : stamps) { material += '\n'; material += s; }
+    return AppUtils::ResultCache::Hash64(material.data(), material.size());
+}
+
+// The cache must not need the model: it opens before (and independently of) backend init.
+static void ensure_cache_locked() {
+    if (g_cache_ready) return;
+    resolve_paths_locked();
+    g_model_identity = compute_model_identity(g_base_dir, g_config_path);
+    g_cache.OpenDisk((fs::path(g_base_dir) / "result_cache.bin").string()); // memory-only on failure
+    g_cache_dir = g_base_dir;
+    g_cache_ready = true;
+}
+
+// Verdict-only answers (["polite"]) live under their own keys, so a caller asking for
+// alternatives never gets one
+static constexpr uint64_t kVerdictKeyTag = 0x7665726469637431ull; // "verdict1"
+
+// The part of the compose context the main model is prompted with, as the cache key sees it:
+// a fresh window over it (a session's window is sticky and may start a sentence later) — empty
+// when the backend's window leaves no room for context, so templated sentences share one answer.
+// Before the first load the size is unknown and the whole context stands in; that is the
+// window itself whenever the context fits.
+static std::string cache_context_for(const std::string& target, const std::string& language,
+    const std::string& context) {
+    const uint32_t tokens = engine_info()->context_tokens;
+    if (context.empty() || !tokens) return context;
+    AppUtils::ComposeSessions::Entry scratch;
+    return AppUtils::ComposeSessions::Window(scratch, context,
+        context_budget_for(tokens, prompt_variant_for(target, language)));
+}
+
+// Lock-free once the cache is open, so lookups are served while init holds g_mu.
+// The context window is part of the prompt, so it is part of the key: the same Target
+// under different preceding sentences is a different question (`context` = cache_context_for).
+static bool cache_key_for(const std::string& target, const std::string& lang, const std::string& context,
+    AppUtils::CacheKey& key, uint64_t tag = 0) {
+    if (!g_cache_ready.load()) {
+        try {
+            std::lock_guard<std::mutex> lk(g_mu);
+            ensure_cache_locked();
+        }
+        catch (...) { return false; } // missing config etc. — init reports the real error
+    }
+    if (!context.empty()) tag ^= AppUtils::ResultCache::Hash64(context.data(), context.size());
+    key = AppUtils::ResultCache::MakeKey(target, lang, AppUtils::PromptHandler::PromptVersion() ^ tag, g_model_identity);
+    return true;
+}
+
+// PaperClipTune이 설정 파일 옆에 남긴 engine_profiles.json에서 현재 전원 모드의 프로파일을 골라
+// cfg_json에 덮어씀. 파일이 없거나 다른 기계용이면 설정 그대로(skip에 사유). 적용한 프로파일 이름을 돌려줌.
+static std::string apply_engine_profile(const std::string& config_path, std::string& cfg_json, std::string& skip) {
+    skip.clear();
+    const fs::path path = fs::path(config_path).parent_path() / "engine_profiles.json";
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) return std::string();
+
+    std::string name, profile, why;
+    const std::string mode = AppUtils::PowerMode();
+    AppUtils::HardwareInfo hw = AppUtils::HardwareInfo::Probe();
+    if (!AppUtils::SelectEngineProfile(slurp(path), hw, mode, name, profile, why)) {
+        skip = why;
+        return std::string();
+    }
+    AppUtils::ApplyEngineProfile(cfg_json, profile);
+    return name;
+}
+
+// "pool": {"size": N} — instances to load (default 1). More instances only help when
+// several windows or browsers query at once; each one costs a full model's memory.
+static size_t pool_size_for(const std::string& cfg_json) {
+    AppUtils::JsonReader cfg, pool;
+    if (!cfg.Parse(cfg_json) || !pool.Parse(cfg.Raw("pool"))) return 1;
+    return (size_t)std::min<long long>(std::max<long long>(pool.Number("size", 1), 1), 8);
+}
+
+static std::unique_ptr<Slot> load_slot(const std::string& cfg_json, const std::string& kind, const Engine& e,
+    std::string& err) {
+    auto slot = std::make_unique<Slot>();
+    slot->generation = e.generation;
+    slot->backend = AppUtils::CreateInferenceBackend(kind);
+    if (!slot->backend) {
+        err = "Inference backend not available in this build: " + kind;
+        return nullptr;
+    }
+    if (!slot->backend->Load(cfg_json, e.base_dir, err)) return nullptr;
+    return slot;
+}
+
+// Per-instance variant snapshots live under the compose sessions' root (SetRoot clears them
+// at init), one directory per load so a reload never overwrites what old instances restore
+static fs::path prefix_generation_dir(uint64_t generation) {
+    return session_snapshot_root() / ("prefix-" + std::to_string(generation));
+}
+
+// Baked snapshot when it matches, else prefill; best effort either way — a miss only
+// costs the first query on this instance a full prefill
+static const char* prime_slot(Slot& s, const Engine& e, size_t index) {
+    const fs::path own = prefix_generation_dir(e.generation) / ("main-" + std::to_string(index));
+    if (restore_prefix_snapshot(s, e, own)) return "snapshot";
+    prime_prefix(s, prompt_variants(e.per_language), own);
+    return s.prefix_primed ? "prefill" : "none";
+}
+
+// "prompt": {"per-language": false} keeps the single monolithic system block
+static bool per_language_for(const std::string& cfg_json) {
+    AppUtils::JsonReader cfg, prompt;
+    if (!cfg.Parse(cfg_json) || !prompt.Parse(cfg.Raw("prompt"))) return true;
+    return prompt.Bool("per-language", true);
+}
+
+// Small verdict model from "cascade": {"verdict-config"}. Best effort: without it the main
+// model gives the verdict (and stops there), so a failure only costs part of the saving.
+static void load_verdict(Engine& e, const std::string& cfg_json) {
+    const fs::path path = verdict_config_path(cfg_json, e.config_path);
+    if (path.empty() || e.escalate == ESCALATE_ALWAYS) return;
+    try {
+        const std::string vcfg = slurp(path);
+        const std::string kind = AppUtils::InferenceBackendKind(vcfg);
+        std::string err;
+        std::unique_ptr<Slot> slot = load_slot(vcfg, kind, e, err);
+        if (!slot) {
+            e.verdict_note = err;
+            return;
+        }
+        // never the baked snapshot: it holds the main model's state
+        prime_prefix(*slot, prompt_variants(e.per_language), prefix_generation_dir(e.generation) / "verdict-0");
+        e.verdict_tokens = slot->backend->ContextTokens();
+        e.verdict_kind = kind;
+        e.verdict_slots.push_back(std::move(slot));
+    }
+    catch (const std::exception& ex) { e.verdict_note = ex.what(); }
+}
+
+// Loads and primes every instance for e.base_dir / e.config_path. Touches no serving state,
+// so a reload runs it without g_mu while the current instances keep answering.
+static void load_engine(Engine& e) {
+    // Validate presence (backend-specific files are checked by Load)
+    fs::path base(e.base_dir);
     if (!fs::exists(base) || !fs::is_directory(base)) {
         throw std::runtime_error("Base dir not found: " + base.string());
     }
-    if (!fs::exists(bundle) || !fs::is_directory(bundle)) {
-        throw std::runtime_error("genie_bundle not found under base dir: " + bundle.string());
-    }
-    if (!fs::exists(g_config_path) || !fs::is_regular_file(g_config_path)) {
-        throw std::runtime_error("genie_config.json not found: " + g_config_path);
+    if (!fs::exists(e.config_path) || !fs::is_regular_file(e.config_path)) {
+        throw std::runtime_error("genie_config.json not found: " + e.config_path);
     }
 
-    // Load config JSON before chdir
-    const std::string cfg_json = slurp(g_config_path);
+    // Config JSON with the tuned profile for this power mode on top. Relative paths in it
+    // are resolved against base_dir by the backend, so no chdir is needed.
+    std::string cfg_json = slurp(e.config_path);
+    e.profile = apply_engine_profile(e.config_path, cfg_json, e.profile_skip);
+    e.kind = AppUtils::InferenceBackendKind(cfg_json);
+    e.per_language = per_language_for(cfg_json);
+    if (!e.identity) e.identity = compute_model_identity(e.base_dir, e.config_path);
+
+    // Sequential read-ahead of the model files overlaps the engine's own (scattered) reads
+    AppUtils::FilePrefetch prefetch;
+    prefetch.Start(model_files_for(cfg_json, e.kind, e.base_dir));
+
+    const uint64_t avail_before = AppUtils::HardwareInfo::Probe().avail_mb;
+    std::string err;
+    e.slots.push_back(load_slot(cfg_json, e.kind, e, err));
+    if (!e.slots.back()) throw std::runtime_error(err);
+    prefetch.Stop();
+    e.prefetched = prefetch.Bytes();
+    e.speculative = e.slots.front()->backend->Speculative();
 
-    // Genie init (most configs reference files relative to base_dir)
-    CwdGuard guard(base);
+    const Clock::time_point t_prefix = Clock::now();
+    e.prefix_source = prime_slot(*e.slots.front(), e, 0);
+    g_stages.Since(ST_PREFIX, t_prefix);
+    e.context_tokens = e.slots.front()->backend->ContextTokens();
+    e.context_note = context_note_for(e.context_tokens, prompt_variants(e.per_language));
 
-    if (GENIE_STATUS_SUCCESS != GenieDialogConfig_createFromJson(cfg_json.c_str(), &g_cfg)) {
-        throw std::runtime_error("GenieDialogConfig_createFromJson failed");
+    // Further instances while memory allows: each must leave a quarter of RAM free
+    // after taking as much as the first one did
+    e.pool_wanted = pool_size_for(cfg_json);
+    while (e.slots.size() < e.pool_wanted) {
+        const AppUtils::HardwareInfo hw = AppUtils::HardwareInfo::Probe();
+        const uint64_t used = avail_before > hw.avail_mb ? avail_before - hw.avail_mb : 0;
+        if (hw.avail_mb && hw.avail_mb < used / e.slots.size() + hw.total_mb / 4) {
+            e.pool_note = "not enough free memory for another instance";
+            break;
+        }
+        std::unique_ptr<Slot> more = load_slot(cfg_json, e.kind, e, err);
+        if (!more) {
+            e.pool_note = err;
+            break;
+        }
+        prime_slot(*more, e, e.slots.size());
+        e.slots.push_back(std::move(more));
     }
-    if (GENIE_STATUS_SUCCESS != GenieDialog_create(g_cfg, &g_dlg)) {
-        GenieDialogConfig_free(g_cfg); g_cfg = nullptr;
-        throw std::runtime_error("GenieDialog_create failed");
+
+    e.escalate = escalate_for(cfg_json);
+    load_verdict(e, cfg_json);
+}
+
+// Publishes e's settings; the caller opens (init) or swaps (reload) the pools
+static void publish_engine_locked(const Engine& e) {
+    auto info = std::make_shared<EngineInfo>();
+    info->kind = e.kind;
+    info->profile = e.profile;
+    info->profile_skip = e.profile_skip;
+    info->prefix_source = e.prefix_source;
+    info->prefetched = e.prefetched;
+    info->context_tokens = e.context_tokens;
+    info->context_note = e.context_note;
+    info->pool_wanted = e.pool_wanted;
+    info->pool_note = e.pool_note;
+    info->verdict_kind = e.verdict_kind;
+    info->verdict_note = e.verdict_note;
+    info->verdict_tokens = e.verdict_tokens;
+    std::atomic_store(&g_info, std::shared_ptr<const EngineInfo>(std::move(info)));
+    g_dec_speculative = e.speculative;
+    g_rewind_ok = true;
+    g_per_language = e.per_language;
+    g_escalate = e.escalate;
+    g_model_identity = e.identity;
+    g_generation = e.generation;
+}
+
+static void ensure_init_locked() {
+    if (g_inited) return;
+    const Clock::time_point t0 = Clock::now();
+
+    resolve_paths_locked();
+    ensure_cache_locked(); // model identity for the snapshot tag
+    {
+        std::lock_guard<std::mutex> lk(g_sess_mu); // before priming: it clears the prefix snapshots too
+        g_sessions.SetRoot(session_snapshot_root().u8string());
     }
+    Engine e;
+    e.generation = g_generation + 1;
+    e.base_dir = g_base_dir;
+    e.config_path = g_config_path;
+    e.identity = g_model_identity;
+    load_engine(e);
+
+    publish_engine_locked(e);
+    g_pool.Open(std::move(e.slots));
+    g_verdict_pool.Open(std::move(e.verdict_slots));
 
     g_inited = true;
+    g_stages.Since(ST_INIT, t0);
 }
 
 static void ensure_init() {
@@ -161,88 +797,956 @@ static void ensure_init() {
     ensure_init_locked();
 }
 
-static void genie_cleanup_locked() {
-    if (g_dlg) { GenieDialog_free(g_dlg);  g_dlg = nullptr; }
-    if (g_cfg) { GenieDialogConfig_free(g_cfg); g_cfg = nullptr; }
-    g_inited = false;
+// ---------- hot reload ----------
+// polite_rewrite_reload / set_base_dir / set_config_path on a loaded library: the next load
+// is built and primed on a background thread while the current instances keep serving, then
+// swapped in under g_mu (RCU-style). Queries already running finish on the old instances,
+// each freed as its lease returns (BackendPool::Swap); new ones lease the new instances.
+// A failed load leaves the current one serving. Requests arriving mid-load are coalesced:
+// a load whose paths changed underneath it is discarded and the newest paths loaded instead.
+struct ReloadRecord {
+    uint64_t    from = 0, generation = 0;
+    bool        ok = false, swapped = false;
+    uint64_t    load_us = 0;       // build + prime, off-lock
+    uint64_t    swap_us = 0;       // g_mu held for the swap
+    long long   swapped_at_ms = 0; // wall clock (ms since epoch) of the swap
+    size_t      in_flight = 0;     // leases still on old instances at the swap
+    long long   drained_us = -1;   // swap → last old instance freed (-1 = not yet)
+    std::string error;
+};
+static std::mutex   g_reload_mu;     // guards the fields below (never held with g_mu or a pool lock)
+static bool         g_reload_running = false, g_reload_pending = false;
+static uint64_t     g_reloads = 0, g_reload_failures = 0, g_reload_discarded = 0;
+static ReloadRecord g_reload_last;
+
+static void reload_loop() {
+    for (;;) {
+        Engine e;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            if (!g_inited) break; // nothing serving: the next query loads cold with the new paths
+            resolve_paths_locked();
+            e.base_dir = g_base_dir;
+            e.config_path = g_config_path;
+            e.generation = g_generation + 1;
+        }
+        {
+            std::lock_guard<std::mutex> lk(g_reload_mu);
+            g_reload_pending = false;
+        }
+
+        ReloadRecord rec;
+        rec.generation = e.generation;
+        const Clock::time_point t0 = Clock::now();
+        try {
+            load_engine(e);
+            rec.ok = true;
+        }
+        catch (const std::exception& ex) { rec.error = ex.what(); }
+        rec.load_us = AppUtils::StageStats::Us(t0, Clock::now());
+
+        bool stale = false;
+        {
+            std::lock_guard<std::mutex> lk(g_reload_mu);
+            stale = g_reload_pending;
+        }
+        if (stale) { // paths changed while loading: the next pass loads the newest ones
+            std::lock_guard<std::mutex> lk(g_reload_mu);
+            ++g_reload_discarded;
+            continue; // e's instances are freed here, off every lock
+        }
+
+        if (rec.ok) {
+            std::unique_lock<std::mutex> lk(g_mu);
+            if (g_inited) {
+                const Clock::time_point t_swap = Clock::now();
+                rec.from = g_generation;
+                rec.swapped_at_ms = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                {
+                    std::lock_guard<std::mutex> rl(g_reload_mu);
+                    g_reload_last = rec; // the drain callback below may already fire inside Swap
+                }
+                publish_engine_locked(e);
+                // Decode and tier counters describe the serving model
+                for (auto* c : { &g_dec_queries, &g_dec_tokens, &g_dec_us, &g_dec_drafted, &g_dec_accepted, &g_dec_passes }) *c = 0;
+                for (auto& c : g_tiers) c = 0;
+                g_small_verdicts = 0;
+                g_small_escalations = 0;
+                {
+                    std::lock_guard<std::mutex> sl(g_sess_mu); // session snapshots hold the old model's KV
+                    g_sessions.Clear();
+                }
+                if (fs::path(g_cache_dir) != fs::path(e.base_dir)) {
+                    g_cache.Close(); // the result cache lives beside the bundle
+                    g_cache.OpenDisk((fs::path(e.base_dir) / "result_cache.bin").string());
+                    g_cache_dir = e.base_dir;
+                }
+                // Both pools' old instances gone → their prefix snapshots can go too
+                const uint64_t from = rec.from;
+                auto left = std::make_shared<std::atomic<int>>(2);
+                auto on_retired = [left, from, t_swap] {
+                    if (--*left) return;
+                    std::error_code ec;
+                    fs::remove_all(prefix_generation_dir(from), ec);
+                    std::lock_guard<std::mutex> rl(g_reload_mu);
+                    if (g_reload_last.from == from) g_reload_last.drained_us = (long long)AppUtils::StageStats::Us(t_swap, Clock::now());
+                };
+                const size_t in_flight = g_pool.Swap(std::move(e.slots), on_retired) +
+                    g_verdict_pool.Swap(std::move(e.verdict_slots), on_retired);
+                const uint64_t swap_us = AppUtils::StageStats::Us(t_swap, Clock::now());
+                lk.unlock();
+
+                std::lock_guard<std::mutex> rl(g_reload_mu);
+                g_reload_last.swapped = true;
+                g_reload_last.in_flight = in_flight;
+                g_reload_last.swap_us = swap_us;
+                ++g_reloads;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lk(g_reload_mu);
+            if (!rec.ok) {
+                g_reload_last = rec;
+                ++g_reload_failures;
+            }
+            if (!g_reload_pending) {
+                g_reload_running = false;
+                return;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lk(g_reload_mu);
+    g_reload_running = false;
+}
+
+// Starts (or queues behind the running one) a background reload of the current paths
+static void request_reload() {
+    {
+        std::lock_guard<std::mutex> lk(g_reload_mu);
+        g_reload_pending = true;
+        if (g_reload_running) return;
+        g_reload_running = true;
+    }
+    std::thread(reload_loop).detach();
+}
+
+// ---------- bounded decode ----------
+// The answer is a fixed four-string array. The token callback recognises it
+// incrementally and stops decoding the moment it is complete, and a budget
+// scaled to the Target length caps rambling or a runaway repeat.
+static constexpr int kAnswerElements = 4;
+
+// Each rewrite is roughly the Target's length; ~3 UTF-8 bytes per token is
+// a generous estimate for Korean/Japanese and over-counts English.
+static uint32_t decode_budget_for(const std::string& target) {
+    const uint32_t target_tokens = static_cast<uint32_t>(target.size() / 3) + 1;
+    const uint32_t budget = 24 + target_tokens * 5; // tone flag + syntax + 3 rewrites w/ slack
+    return std::min<uint32_t>(std::max<uint32_t>(budget, 64), 384);
 }
 
-static void append_and_print(const char* chunk,
-    const GenieDialog_SentenceCode_t code,
-    std::string& acc)
+static std::string serialize_elements(const std::vector<std::string>& elements) {
+    std::string out = "[";
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (i) out += ",";
+        out += '"';
+        AppUtils::JsonAppendEscaped(out, elements[i]);
+        out += '"';
+    }
+    out += "]";
+    return out;
+}
+
+// When the tone flag (element 0) alone answers the query
+enum VerdictExit : int {
+    VERDICT_EXIT_NONE = 0,   // full answer wanted
+    VERDICT_EXIT_POLITE = 1, // stop if the flag is "polite"
+    VERDICT_EXIT_ANY = 2     // stop after any flag
+};
+
+// The small verdict model only needs `["polite"` or `["impolite"`
+static constexpr uint32_t kVerdictTokens = 16;
+
+// Upper bound for a caller-supplied max_tokens
+static constexpr uint32_t kMaxDecodeTokens = 1024;
+
+// ---------- speculative prefill ----------
+// polite_rewrite_prefill_hint: while the user pauses mid-sentence, the sentence so far is
+// prefilled (system block + context + partial Target) on the instance the finished sentence
+// will lease. Its REWIND query then only prefills the tail and starts decoding at once.
+static std::atomic<uint64_t> g_hint_requests{ 0 }, g_hint_runs{ 0 }, g_hint_skipped{ 0 }, g_hint_cancelled{ 0 };
+static std::atomic<uint64_t> g_hint_bytes{ 0 }, g_hint_us{ 0 };          // the hints' own prefill work
+static std::atomic<uint64_t> g_hint_followed{ 0 }, g_hint_hits{ 0 };     // queries on a hinted KV / reused into the Target
+static std::atomic<uint64_t> g_hint_saved_bytes{ 0 }, g_hint_saved_us{ 0 };
+static std::atomic<uint64_t> g_hint_hit_prefill_us{ 0 };                 // what hit queries still prefilled
+static std::atomic<uint64_t> g_cold_queries{ 0 }, g_cold_prefill_us{ 0 }; // REWIND queries without a hint
+
+// What a query got out of the hint left in its instance's KV (consumed: one query per hint)
+struct HintUse {
+    bool     followed = false, hit = false;
+    uint64_t saved_bytes = 0, saved_us = 0;
+};
+
+static HintUse follow_hint(Slot& s, size_t reused) {
+    HintUse h;
+    if (!s.hint_len || s.kv_text.size() != s.hint_len) {
+        s.hint_len = 0;
+        return h;
+    }
+    h.followed = true;
+    h.hit = reused > s.hint_mark; // matched into the Target, not just the context
+    const size_t work = s.hint_len - std::min(s.hint_base, s.hint_len);
+    if (h.hit && work) {
+        h.saved_bytes = std::min(reused, s.hint_len) - std::min(s.hint_base, std::min(reused, s.hint_len));
+        h.saved_us = s.hint_us * h.saved_bytes / work; // the share of the hints' prefill not redone
+    }
+    s.hint_len = 0;
+    return h;
+}
+
+static void record_hint(const HintUse& h, uint64_t prefill_us) {
+    if (!h.followed) {
+        ++g_cold_queries;
+        g_cold_prefill_us += prefill_us;
+        return;
+    }
+    ++g_hint_followed;
+    if (!h.hit) return;
+    ++g_hint_hits;
+    g_hint_saved_bytes += h.saved_bytes;
+    g_hint_saved_us += h.saved_us;
+    g_hint_hit_prefill_us += prefill_us;
+}
+
+// One query as the exports describe it (v1 fills in the defaults, v2 maps pr_request)
+struct RewriteRequest {
+    std::string   target, context, session;
+    std::string   language;               // "" = detect from the Target
+    int           flags = 0;              // PR_CASCADE_*
+    uint32_t      want = kAnswerElements; // elements to decode: tone flag + rewrites
+    uint32_t      max_tokens = 0;         // 0 = decode_budget_for(target)
+    uint32_t      deadline_ms = 0;        // 0 = none
+    pr_element_cb on_element = nullptr;
+    void*         user = nullptr;
+};
+
+// What the query produced, before any serialisation: v1 turns it into JSON, v2 into spans
+struct RewriteOutcome {
+    int         status = PR_OK;       // pr_status
+    std::string stage, message;       // failure detail; the raw model text when there was no array
+    std::vector<std::string> elements; // tone flag + rewrites
+    bool        truncated = false;
+    int         tier = PR_TIER_NONE;
+    uint64_t    total_us = 0, wait_us = 0, prefill_us = 0, first_token_us = 0, decode_us = 0;
+    uint32_t    tokens = 0;
+};
+
+// Per-query accumulator handed to InferenceBackend::Generate as user data
+struct QueryState {
+    std::string               out;
+    AppUtils::JsonArrayStream* stream = nullptr;
+    std::vector<std::string>  elements;   // closed array strings, in order
+    uint32_t                  tokens = 0; // callback invocations (≈ decoded tokens)
+    uint32_t                  budget = 0; // 0 = unbounded
+    uint32_t                  want = kAnswerElements; // elements that complete the answer
+    Clock::time_point         started{};  // Generate call
+    Clock::time_point         first{};    // first decoded piece
+    Slot*                     slot = nullptr; // leased instance (abort target)
+    int                       verdict_exit = VERDICT_EXIT_NONE; // stop after the tone flag?
+
+    bool Complete() const {
+        return stream && (stream->Closed() || stream->Elements() >= static_cast<int>(want));
+    }
+};
+
+// Decode-step callback: false stops the backend (answer complete, budget, or abort)
+static bool append_and_print(const char* chunk, void* user)
 {
-    if (chunk) acc.append(chunk);
-    (void)code; // no console printing here
+    QueryState& st = *static_cast<QueryState*>(user);
+    if (!chunk || st.Complete() || st.slot->abort_reason.load() != ABORT_NONE)
+        return false; // already stopping; drop trailing text
+    st.out.append(chunk);
+    st.stream->Feed(chunk);
+    if (!st.tokens++) st.first = Clock::now();
+    if (st.Complete()) signal_abort(*st.slot, ABORT_COMPLETE);
+    else if (st.verdict_exit && st.elements.size() == 1 &&
+        (st.verdict_exit == VERDICT_EXIT_ANY || st.elements[0] == "polite")) signal_abort(*st.slot, ABORT_VERDICT);
+    else if (st.budget && st.tokens >= st.budget) signal_abort(*st.slot, ABORT_BUDGET);
+    return st.slot->abort_reason.load() == ABORT_NONE;
 }
 
-// ─────────────────────────── Exported API ────────────────────────────
-extern "C" PR_API const char* generate_polite_rewrite(const char* input_utf8) {
+// The small model decodes the same prompt up to the tone flag. Returns the abort reason
+// (CANCELLED/DEADLINE end the request); `flag` stays empty when it gave no usable flag.
+static int run_verdict_model(const std::string& target, const std::string& context,
+    const std::string& language, uint32_t deadline_ms, Clock::time_point t_start, std::string& flag) {
+    AppUtils::BackendPool::Lease lease = g_verdict_pool.Acquire(std::string());
+    if (!lease) return ABORT_NONE; // not loaded (or unloading): the main model decides
+    Slot& v = *lease;
+
+    AppUtils::ComposeSessions::Entry scratch;
+    AppUtils::PromptHandler ph;
+    const std::string variant = prompt_variant_for(target, language);
+    const std::string tagged = ph.MakePoliteRewritePrompt(target,
+        AppUtils::ComposeSessions::Window(scratch, context, context_budget_for(engine_info()->verdict_tokens, variant)), language, variant);
+
+    QueryState qs;
+    AppUtils::JsonArrayStream stream([&](int, const std::string& element) { qs.elements.push_back(element); });
+    qs.stream = &stream;
+    qs.slot = &v;
+    qs.budget = kVerdictTokens;
+    qs.verdict_exit = VERDICT_EXIT_ANY;
+    v.backend->SetMaxTokens(qs.budget);
+
+    ActiveScope active(v, t_start, deadline_ms);
+    if (v.abort_reason == ABORT_NONE) {
+        enter_prefix(v, variant);
+        const bool ok = v.backend->Generate(tagged, true, append_and_print, &qs);
+        v.kv_text = tagged;
+        if (!ok && qs.out.empty() && v.abort_reason == ABORT_NONE) { // no rewind support: clean prefill
+            v.backend->Reset();
+            v.kv_text.clear();
+            v.backend->Generate(tagged, false, append_and_print, &qs);
+        }
+    }
+    const int why = v.abort_reason.load();
+    if (!qs.elements.empty() && why != ABORT_CANCELLED && why != ABORT_DEADLINE) {
+        flag = qs.elements.front();
+        ++g_small_verdicts;
+    }
+    return why;
+}
+
+// Answers from the cache replay through the element callback like a decode would
+static void take_cached(const std::string& hit, const RewriteRequest& rq, RewriteOutcome& o) {
+    AppUtils::JsonParseStringArray(hit, o.elements);
+    if (o.elements.size() > rq.want) o.elements.resize(rq.want);
+    if (!rq.on_element) return;
+    for (size_t i = 0; i < o.elements.size(); ++i) rq.on_element(static_cast<int>(i), o.elements[i].c_str(), rq.user);
+}
+
+// One query through the tiers: fast path → cache → verdict model → main model.
+// PR_CASCADE_ALTERNATIVES: the user asked for rewrites (no early exit);
+// PR_CASCADE_PEEK: stop before anything that needs the model (status PR_NEED_MODEL).
+// held: a batch keeps its instance between queries (leased here on first use, released by the caller).
+static void run_rewrite(const RewriteRequest& rq, RewriteOutcome& o, AppUtils::BackendPool::Lease* held = nullptr) {
     // track stage for better diagnostics
     const char* stage = "pre-init";
+    const Clock::time_point t_start = Clock::now();
+    struct TotalTimer {
+        Clock::time_point t0;
+        RewriteOutcome& o;
+        bool record;
+        ~TotalTimer() {
+            o.total_us = AppUtils::StageStats::Us(t0, Clock::now());
+            if (record) g_stages.Record(ST_TOTAL, o.total_us);
+        }
+    } total_timer{ t_start, o, true };
+
+    auto answer = [&](Tier t) {
+        o.tier = t;
+        ++g_tiers[t];
+    };
+    auto fail = [&](int status, const std::string& message) {
+        o.status = status;
+        o.stage = stage;
+        o.message = message;
+    };
+    auto aborted = [&](int why) {
+        o.status = why == ABORT_DEADLINE ? PR_DEADLINE : PR_CANCELLED;
+        o.stage = "aborted";
+        o.message = why == ABORT_DEADLINE ? "deadline" : "cancelled";
+    };
+
+    // Leader of a single-flight group publishes its result (or failure) on every exit path
+    struct FlightGuard {
+        AppUtils::CacheKey key;
+        bool leader = false;
+        bool ok = false;
+        std::string value;
+        ~FlightGuard() { if (leader) g_cache.EndFlight(key, value, ok); }
+    } flight;
+
     try {
+        const std::string& in = rq.target;
+        const bool alternatives = (rq.flags & PR_CASCADE_ALTERNATIVES) != 0;
+        const bool full = rq.want >= kAnswerElements; // shorter answers are served, never shared
+        const int escalate = g_escalate.load();
+        const int verdict_exit = alternatives || escalate == ESCALATE_ALWAYS ? VERDICT_EXIT_NONE
+            : escalate == ESCALATE_NEVER ? VERDICT_EXIT_ANY : VERDICT_EXIT_POLITE;
+
+        // Polite sentences show no suggestions, so the verdict alone is a full answer
+        stage = "fastpath";
+        if (!alternatives && g_tone.ShortCircuit(in)) {
+            o.elements.assign(1, "polite");
+            if (rq.on_element) rq.on_element(0, "polite", rq.user);
+            answer(TIER_FASTPATH);
+            return;
+        }
+
+        // A full answer serves every caller; a verdict-only one only callers that would stop there.
+        // Verdict callers share a flight, so each may receive either kind.
+        stage = "cache";
+        const std::string lang = rq.language.empty() ? AppUtils::PromptHandler::DetectLanguage(in) : rq.language;
+        AppUtils::CacheKey full_key, verdict_key;
+        const std::string key_context = cache_context_for(in, rq.language, rq.context);
+        const bool cache_on = cache_key_for(in, lang, key_context, full_key) &&
+            (!verdict_exit || cache_key_for(in, lang, key_context, verdict_key, kVerdictKeyTag));
+        std::string hit;
+        if (cache_on && (g_cache.Get(full_key, hit) || (verdict_exit && g_cache.Get(verdict_key, hit)))) {
+            take_cached(hit, rq, o);
+            answer(TIER_CACHE);
+            return;
+        }
+        if (rq.flags & PR_CASCADE_PEEK) {
+            total_timer.record = false;
+            o.status = PR_NEED_MODEL;
+            return;
+        }
+        if (cache_on && full) {
+            flight.key = verdict_exit ? verdict_key : full_key;
+            if (!g_cache.BeginFlight(flight.key, hit)) {
+                take_cached(hit, rq, o);
+                answer(TIER_CACHE);
+                return;
+            }
+            flight.leader = true;
+        }
+
         stage = "init";
         ensure_init();
 
+        // Small model first: a flag that settles the query never wakes the main model
+        bool flag_sent = false;
+        if (verdict_exit && g_verdict_pool.Size()) {
+            stage = "verdict";
+            std::string flag;
+            const int why = run_verdict_model(in, rq.context, rq.language, rq.deadline_ms, t_start, flag);
+            if (why == ABORT_CANCELLED || why == ABORT_DEADLINE) {
+                aborted(why);
+                return;
+            }
+            if (!flag.empty()) {
+                if (rq.on_element) rq.on_element(0, flag.c_str(), rq.user);
+                flag_sent = true;
+                if (verdict_exit == VERDICT_EXIT_ANY || flag == "polite") {
+                    o.elements.assign(1, flag);
+                    if (cache_on) {
+                        g_cache.Put(verdict_key, serialize_elements(o.elements));
+                        flight.ok = true;
+                        flight.value = serialize_elements(o.elements);
+                    }
+                    answer(TIER_VERDICT);
+                    return;
+                }
+                ++g_small_escalations;
+            }
+        }
+
+        stage = "lease";
+        const Clock::time_point t_lease = Clock::now();
+        AppUtils::BackendPool::Lease own;
+        AppUtils::BackendPool::Lease& lease = held ? *held : own;
+        if (!lease) lease = g_pool.Acquire(rq.session);
+        if (!lease) { // reconfigured between init and lease
+            stage = "init";
+            ensure_init();
+            stage = "lease";
+            lease = g_pool.Acquire(rq.session);
+            if (!lease) throw std::runtime_error("backend was unloaded");
+        }
+        Slot& slot = *lease;
+        o.wait_us = AppUtils::StageStats::Us(t_lease, Clock::now());
+
+        stage = "session";
+        const Clock::time_point t_prompt = Clock::now();
+        const std::string variant = prompt_variant_for(in, rq.language);
+        const std::string context = enter_session(slot, rq.session, rq.context, variant);
+
         stage = "prompt";
-        std::string in = (input_utf8 ? input_utf8 : "");
         AppUtils::PromptHandler ph;
-        std::string tagged = ph.MakePoliteRewritePrompt(in);
-
-        std::string out;
+        std::string tagged = ph.MakePoliteRewritePrompt(in, context, rq.language, variant); // prefix is a shared static
 
-        // Some configs use relative paths; run under base_dir as CWD
-        stage = "cwd-guard";
-        CwdGuard guard{ fs::path(g_base_dir) };
+        QueryState qs;
+        AppUtils::JsonArrayStream stream([&](int index, const std::string& element) {
+            qs.elements.push_back(element);
+            if (rq.on_element && !(index == 0 && flag_sent)) rq.on_element(index, element.c_str(), rq.user);
+        });
+        qs.stream = &stream;
+        qs.slot = &slot;
+        qs.want = rq.want;
+        qs.verdict_exit = flag_sent ? VERDICT_EXIT_NONE : verdict_exit; // the small model already escalated
+        qs.budget = rq.max_tokens ? std::min<uint32_t>(rq.max_tokens, kMaxDecodeTokens) : decode_budget_for(in);
+        slot.backend->SetMaxTokens(qs.budget); // backend-side cap; our counter is the backstop
+        g_stages.Since(ST_PROMPT, t_prompt);
 
         stage = "query";
-        auto cb = [](const char* resp,
-            const GenieDialog_SentenceCode_t code,
-            const void* user_data)
-            {
-                auto* acc = static_cast<std::string*>(const_cast<void*>(user_data));
-                append_and_print(resp, code, *acc);
-            };
+        ActiveScope active(slot, t_start, rq.deadline_ms);
+
+        // Reuse the resident system prefix; on backends without rewind support fall
+        // back to a clean full prefill so the basic dialog does not accumulate turns.
+        bool st = false;
+        HintUse hint;
+        if (g_rewind_ok && slot.abort_reason == ABORT_NONE) { // deadline may have passed in the lease wait
+            enter_prefix(slot, variant);
+            const size_t reused = AppUtils::ComposeSessions::CommonPrefix(tagged, slot.kv_text);
+            hint = follow_hint(slot, reused);
+            qs.started = Clock::now();
+            st = slot.backend->Generate(tagged, true, append_and_print, &qs);
+            if (!st && qs.out.empty() && slot.abort_reason == ABORT_NONE)
+                g_rewind_ok = false;
+            else
+                g_sessions.RecordPrefill(reused, tagged.size() - reused);
+            slot.kv_text = tagged;
+        }
+        if (!g_rewind_ok && slot.abort_reason == ABORT_NONE) {
+            stage = "query-full";
+            qs.out.clear();
+            qs.elements.clear();
+            qs.tokens = 0;
+            slot.backend->Reset();
+            slot.prefix_primed = false;
+            slot.kv_session.clear();
+            slot.kv_text.clear();
+            g_sessions.RecordPrefill(0, tagged.size());
+            qs.started = Clock::now();
+            st = slot.backend->Generate(tagged, false, append_and_print, &qs);
+        }
 
-        const auto want = GenieDialog_SentenceCode_t::GENIE_DIALOG_SENTENCE_COMPLETE;
+        if (qs.tokens) {
+            const Clock::time_point t_end = Clock::now();
+            o.tokens = qs.tokens;
+            o.prefill_us = AppUtils::StageStats::Us(qs.started, qs.first);
+            o.first_token_us = AppUtils::StageStats::Us(t_start, qs.first);
+            o.decode_us = AppUtils::StageStats::Us(qs.first, t_end);
+            g_stages.Record(ST_PREFILL, o.prefill_us);
+            if (g_rewind_ok) record_hint(hint, o.prefill_us);
+            g_stages.Record(ST_FIRST_TOKEN, o.first_token_us);
+            g_stages.Record(ST_DECODE, o.decode_us);
+            if (qs.tokens > 1 && o.decode_us) g_stages.Record(ST_DECODE_TPS, (qs.tokens - 1) * 1000000ull / o.decode_us);
+            const AppUtils::DecodeStats ds = slot.backend->LastDecode();
+            ++g_dec_queries;
+            g_dec_tokens += qs.tokens - 1;
+            g_dec_us += o.decode_us;
+            g_dec_drafted += ds.drafted;
+            g_dec_accepted += ds.accepted;
+            g_dec_passes += ds.passes;
+        }
 
-        if (GENIE_STATUS_SUCCESS != GenieDialog_query(g_dlg, tagged.c_str(), want, cb, &out)) {
-            // Make this a structured error instead of throwing a generic one
-            std::string j = make_error_json("query-failed",
-                "GenieDialog_query failed",
-                g_base_dir, g_config_path);
-            return heap_dup(j);
+        const int why = slot.abort_reason.load();
+        if (why == ABORT_CANCELLED || why == ABORT_DEADLINE) {
+            aborted(why);
+            return;
+        }
+        if (why == ABORT_COMPLETE || why == ABORT_BUDGET || why == ABORT_VERDICT) st = true; // our own stop
+        if (!st) {
+            fail(PR_ERR_QUERY, engine_info()->kind + " query failed");
+            return;
+        }
+        if (qs.out.empty()) {
+            fail(PR_ERR_EMPTY, "Model produced empty response");
+            return;
         }
 
-        // If model produced empty output, return a structured error too
-        if (out.empty()) {
-            std::string j = make_error_json("empty-output",
-                "Model produced empty response",
-                g_base_dir, g_config_path);
-            return heap_dup(j);
+        // Recognised array → its strings without surrounding commentary; stopped at the
+        // tone flag → the one-element verdict answer. Cut off before the array closed
+        // (budget/EOS): keep the complete strings and flag it. No array at all → raw text.
+        const bool verdict_only = why == ABORT_VERDICT && !qs.elements.empty();
+        if (verdict_only) {
+            qs.elements.resize(1);
+            answer(TIER_VERDICT);
         }
+        else if (!qs.elements.empty()) {
+            if (qs.elements.size() > rq.want) qs.elements.resize(rq.want);
+            o.truncated = !qs.Complete();
+            answer(TIER_REWRITE);
+        }
+        else {
+            o.message = qs.out;
+        }
+        o.elements = std::move(qs.elements);
 
-        // Success — return raw model text (host will normalize/wrap)
-        return heap_dup(out);
+        // Only well-formed answers (tone flag + at least one rewrite, or a bare verdict) are kept
+        if (cache_on && full && (verdict_only || (!o.truncated && o.elements.size() >= 2))) {
+            const std::string value = serialize_elements(o.elements);
+            g_cache.Put(verdict_only ? verdict_key : full_key, value);
+            flight.ok = true;
+            flight.value = value;
+        }
     }
     catch (const std::exception& e) {
-        std::string j = make_error_json(stage, e.what(), g_base_dir, g_config_path);
-        return heap_dup(j);
+        fail(std::strcmp(stage, "init") == 0 ? PR_ERR_INIT : PR_ERR_INTERNAL, e.what());
     }
     catch (...) {
-        std::string j = make_error_json(stage, "unknown exception", g_base_dir, g_config_path);
-        return heap_dup(j);
+        fail(PR_ERR_INTERNAL, "unknown exception");
+    }
+}
+
+// v1 result string: the answer array (or {"suggestions":[...],"truncated":true,"tier":...}),
+// the raw model text when there was no array, or an {"error",...} object. nullptr = peek miss.
+static const char* v1_result(const RewriteOutcome& o, bool with_tier) {
+    if (o.status == PR_NEED_MODEL) return nullptr;
+    if (o.status != PR_OK) return heap_dup(make_error_json(o.stage, o.message, g_base_dir, g_config_path));
+    if (o.elements.empty()) return heap_dup(o.message);
+    const std::string arr = serialize_elements(o.elements);
+    const bool tier = with_tier && o.tier != PR_TIER_NONE;
+    if (!o.truncated && !tier) return heap_dup(arr);
+    std::string r = "{\"suggestions\":" + arr;
+    if (o.truncated) r += ",\"truncated\":true";
+    if (tier) r += std::string(",\"tier\":\"") + kTierNames[o.tier] + "\"";
+    r += "}";
+    return heap_dup(r);
+}
+
+static void request_from(const pr_request& req, RewriteRequest& rq) {
+    rq.target = req.target ? req.target : "";
+    rq.context = req.context ? req.context : "";
+    rq.session = req.session ? req.session : "";
+    rq.language = req.language ? req.language : "";
+    rq.flags = static_cast<int>(req.flags);
+    rq.want = 1 + (req.max_alternatives ? std::min<uint32_t>(req.max_alternatives, PR_MAX_ALTERNATIVES)
+                                        : PR_MAX_ALTERNATIVES);
+    rq.max_tokens = req.max_tokens;
+    rq.deadline_ms = req.deadline_ms;
+    rq.on_element = req.on_element;
+    rq.user = req.user;
+}
+
+// Prefill-only counterpart of run_rewrite. Never waits: no loaded model, no idle instance or
+// nothing new to prefill → PR_NEED_MODEL, and a real query's abort cancels it.
+static int run_hint(const RewriteRequest& rq) {
+    ++g_hint_requests;
+    auto skip = [] { ++g_hint_skipped; return PR_NEED_MODEL; };
+    {
+        std::unique_lock<std::mutex> lk(g_mu, std::try_to_lock); // never starts (or waits for) a load
+        if (!lk.owns_lock() || !g_inited) return skip();
+    }
+    // The last word is probably still being typed: its tokens would not survive
+    std::string partial = rq.target;
+    while (!partial.empty() && (unsigned char)partial.back() <= ' ') partial.pop_back();
+    const size_t space = partial.find_last_of(' ');
+    if (space != std::string::npos) partial.resize(space);
+    if (partial.empty() || !g_rewind_ok) return skip();
+
+    AppUtils::BackendPool::Lease lease = g_pool.Acquire(rq.session, false);
+    if (!lease) return skip();
+    Slot& slot = *lease;
+    const std::string variant = prompt_variant_for(rq.target, rq.language);
+    const std::string context = enter_session(slot, rq.session, rq.context, variant);
+    AppUtils::PromptHandler ph;
+    const std::string full = ph.MakePoliteRewritePrompt(partial, context, rq.language, variant);
+    const size_t at = full.rfind(partial);
+    if (at == std::string::npos) return skip();
+    const std::string prompt = full.substr(0, at + partial.size()); // up to the partial Target, no turn end
+
+    ActiveScope active(slot, Clock::now(), rq.deadline_ms);
+    enter_prefix(slot, variant);
+    const size_t reused = AppUtils::ComposeSessions::CommonPrefix(prompt, slot.kv_text);
+    if (reused == prompt.size()) return skip(); // an earlier hint already holds it
+    const bool chained = slot.hint_len && slot.kv_text.size() == slot.hint_len;
+    const Clock::time_point t0 = Clock::now();
+    const bool ok = slot.backend->PrefillRewind(prompt);
+    const uint64_t us = AppUtils::StageStats::Us(t0, Clock::now());
+    if (!ok) { // KV holds at most the shared prefix now
+        slot.kv_text.resize(reused);
+        slot.hint_len = 0;
+        if (slot.abort_reason != ABORT_NONE) {
+            ++g_hint_cancelled;
+            return slot.abort_reason == ABORT_DEADLINE ? PR_DEADLINE : PR_CANCELLED;
+        }
+        return PR_ERR_QUERY;
+    }
+    slot.hint_base = chained ? std::min(slot.hint_base, reused) : reused;
+    slot.hint_us = (chained ? slot.hint_us : 0) + us;
+    slot.kv_text = prompt;
+    slot.hint_len = prompt.size();
+    slot.hint_mark = at;
+    ++g_hint_runs;
+    g_hint_bytes += prompt.size() - reused;
+    g_hint_us += us;
+    return PR_OK;
+}
+
+static const char* run_v1(const char* target_utf8, const char* context_utf8, const char* session_utf8,
+    pr_element_cb on_element, void* user, int flags = 0, bool with_tier = false) {
+    RewriteRequest rq;
+    rq.target = target_utf8 ? target_utf8 : "";
+    rq.context = context_utf8 ? context_utf8 : "";
+    rq.session = session_utf8 ? session_utf8 : "";
+    rq.flags = flags;
+    rq.deadline_ms = g_deadline_ms.load();
+    rq.on_element = on_element;
+    rq.user = user;
+    RewriteOutcome o;
+    run_rewrite(rq, o);
+    return v1_result(o, with_tier);
+}
+
+// Copies the outcome into `out`: strings as NUL-terminated spans in buf, or in a library
+// arena when buf is NULL or too small
+static void pack_result(const RewriteOutcome& o, pr_result* out, char* buf, uint32_t buf_size) {
+    auto us32 = [](uint64_t v) { return static_cast<uint32_t>(std::min<uint64_t>(v, UINT32_MAX)); };
+    out->status = o.status;
+    out->tier = o.tier;
+    out->truncated = o.truncated ? 1u : 0u;
+    out->total_us = us32(o.total_us);
+    out->wait_us = us32(o.wait_us);
+    out->prefill_us = us32(o.prefill_us);
+    out->first_token_us = us32(o.first_token_us);
+    out->decode_us = us32(o.decode_us);
+    out->tokens = o.tokens;
+
+    const size_t n_alt = o.elements.empty() ? 0 : std::min<size_t>(o.elements.size() - 1, PR_MAX_ALTERNATIVES);
+    size_t need = o.message.size() + 1 + o.stage.size() + 1;
+    for (size_t i = 0; i < n_alt + (o.elements.empty() ? 0 : 1); ++i) need += o.elements[i].size() + 1;
+    char* dst = buf;
+    if (!buf || need > buf_size) {
+        dst = static_cast<char*>(std::malloc(need));
+        if (!dst) {
+            out->status = PR_ERR_INTERNAL;
+            return;
+        }
+        out->arena = dst;
+    }
+    out->bytes = static_cast<uint32_t>(need);
+    auto put = [&](const std::string& s, pr_span& span) {
+        if (s.empty()) return;
+        std::memcpy(dst, s.data(), s.size());
+        dst[s.size()] = '\0';
+        span.ptr = dst;
+        span.len = static_cast<uint32_t>(s.size());
+        dst += s.size() + 1;
+    };
+    if (!o.elements.empty()) put(o.elements[0], out->verdict);
+    for (size_t i = 0; i < n_alt; ++i) put(o.elements[i + 1], out->alternatives[i]);
+    out->n_alternatives = static_cast<uint32_t>(n_alt);
+    put(o.message, out->message);
+    put(o.stage, out->stage);
+}
+
+// ─────────────────────────── Exported API ────────────────────────────
+extern "C" PR_API const char* generate_polite_rewrite(const char* input_utf8) {
+    return run_v1(input_utf8, nullptr, nullptr, nullptr, nullptr);
+}
+
+extern "C" PR_API const char* generate_polite_rewrite_stream(const char* input_utf8,
+    pr_element_cb on_element, void* user) {
+    return run_v1(input_utf8, nullptr, nullptr, on_element, user);
+}
+
+extern "C" PR_API const char* generate_polite_rewrite_ctx(const char* target_utf8,
+    const char* context_utf8, const char* session_utf8, pr_element_cb on_element, void* user) {
+    return run_v1(target_utf8, context_utf8, session_utf8, on_element, user);
+}
+
+extern "C" PR_API const char* generate_polite_rewrite_peek(const char* target_utf8,
+    pr_element_cb on_element, void* user) {
+    return run_v1(target_utf8, nullptr, nullptr, on_element, user, PR_CASCADE_PEEK);
+}
+
+extern "C" PR_API const char* generate_polite_rewrite_cascade(const char* target_utf8,
+    const char* context_utf8, const char* session_utf8, int flags, pr_element_cb on_element, void* user) {
+    return run_v1(target_utf8, context_utf8, session_utf8, on_element, user, flags, true);
+}
+
+extern "C" PR_API int polite_rewrite_v2(const pr_request* req, pr_result* out, char* buf, uint32_t buf_size) {
+    if (!out || out->struct_size < sizeof(pr_result)) return PR_ERR_ARGS;
+    const uint32_t out_size = out->struct_size;
+    std::memset(out, 0, sizeof(pr_result));
+    out->struct_size = out_size;
+    try {
+        RewriteOutcome o;
+        if (!req || req->struct_size < sizeof(pr_request) || !req->target) {
+            o.status = PR_ERR_ARGS;
+            o.stage = "args";
+            o.message = !req ? "request is NULL" : !req->target ? "target is NULL" : "pr_request struct_size too small";
+        }
+        else {
+            RewriteRequest rq;
+            request_from(*req, rq);
+            run_rewrite(rq, o);
+        }
+        pack_result(o, out, buf, buf_size);
+    }
+    catch (...) {
+        out->status = PR_ERR_INTERNAL;
     }
+    return out->status;
+}
+
+// Sentences run in order on one instance; the deadline covers the whole batch
+extern "C" PR_API int polite_rewrite_batch(const pr_request* common, const pr_batch_item* items, uint32_t n_items,
+    pr_batch_cb on_result, void* user) {
+    if (!common || common->struct_size < sizeof(pr_request) || (!items && n_items)) return PR_ERR_ARGS;
+    try {
+        const uint64_t epoch = g_abort_epoch.load();
+        const Clock::time_point t0 = Clock::now();
+        RewriteRequest rq;
+        request_from(*common, rq);
+        rq.on_element = nullptr;
+        rq.user = nullptr;
+        AppUtils::BackendPool::Lease held; // first sentence that needs the main model leases it
+        std::vector<char> buf(4096);
+        for (uint32_t i = 0; i < n_items; ++i) {
+            if (g_abort_epoch.load() != epoch) return PR_CANCELLED;
+            if (common->deadline_ms) {
+                const uint64_t spent_ms = AppUtils::StageStats::Us(t0, Clock::now()) / 1000;
+                if (spent_ms >= common->deadline_ms) return PR_DEADLINE;
+                rq.deadline_ms = common->deadline_ms - static_cast<uint32_t>(spent_ms);
+            }
+            const pr_batch_item& it = items[i];
+            rq.target.assign(it.target.ptr ? it.target.ptr : "", it.target.ptr ? it.target.len : 0);
+            rq.context.assign(it.context.ptr ? it.context.ptr : "", it.context.ptr ? it.context.len : 0);
+            RewriteOutcome o;
+            run_rewrite(rq, o, &held);
+            if (o.status == PR_CANCELLED || o.status == PR_DEADLINE) return o.status;
+            pr_result r{};
+            r.struct_size = sizeof(r);
+            pack_result(o, &r, buf.data(), static_cast<uint32_t>(buf.size()));
+            if (on_result) on_result(i, &r, user);
+            polite_rewrite_result_free(&r);
+        }
+        return PR_OK;
+    }
+    catch (...) {
+        return PR_ERR_INTERNAL;
+    }
+}
+
+extern "C" PR_API int polite_rewrite_prefill_hint(const pr_request* req) {
+    if (!req || req->struct_size < sizeof(pr_request) || !req->target) return PR_ERR_ARGS;
+    try {
+        RewriteRequest rq;
+        request_from(*req, rq);
+        return run_hint(rq);
+    }
+    catch (...) {
+        return PR_ERR_INTERNAL;
+    }
+}
+
+extern "C" PR_API void polite_rewrite_result_free(pr_result* out) {
+    if (!out || !out->arena) return;
+    std::free(out->arena);
+    out->arena = nullptr;
+}
+
+extern "C" PR_API uint32_t polite_rewrite_abi_version() {
+    return PR_ABI_VERSION;
+}
+
+extern "C" PR_API int polite_rewrite_abort() {
+    ++g_abort_epoch;
+    size_t running = 0;
+    for (AppUtils::BackendPool* pool : { &g_pool, &g_verdict_pool }) {
+        pool->ForEachLeased([&](Slot& s) {
+            if (!s.active.load()) return;
+            signal_abort(s, ABORT_CANCELLED);
+            ++running;
+        });
+    }
+    return running ? 0 : 1;
+}
+
+extern "C" PR_API void polite_rewrite_set_deadline_ms(uint32_t ms) {
+    g_deadline_ms = ms;
+}
+
+extern "C" PR_API const char* polite_rewrite_cache_stats() {
+    return heap_dup(g_cache.StatsJson());
+}
+
+extern "C" PR_API const char* polite_rewrite_session_stats() {
+    std::string j = g_sessions.StatsJson();
+    if (!j.empty() && j.back() == '}') {
+        j.pop_back();
+        j += ",\"prefix_switches\":" + std::to_string(g_prefix_switches.load()) +
+            ",\"prefix_restores\":" + std::to_string(g_prefix_restores.load()) + "}";
+    }
+    return heap_dup(j);
+}
+
+extern "C" PR_API const char* polite_rewrite_hint_stats() {
+    const uint64_t followed = g_hint_followed.load(), hits = g_hint_hits.load(), cold = g_cold_queries.load();
+    char buf[640];
+    std::snprintf(buf, sizeof(buf),
+        "{\"hints\":%llu,\"prefilled\":%llu,\"skipped\":%llu,\"cancelled\":%llu,\"prefill_bytes\":%llu,"
+        "\"prefill_ms\":%.1f,\"followed\":%llu,\"hits\":%llu,\"hit_rate\":%.3f,\"saved_bytes\":%llu,"
+        "\"saved_ms\":%.1f,\"prefill_ms_avg_hit\":%.2f,\"prefill_ms_avg_cold\":%.2f}",
+        (unsigned long long)g_hint_requests.load(), (unsigned long long)g_hint_runs.load(),
+        (unsigned long long)g_hint_skipped.load(), (unsigned long long)g_hint_cancelled.load(),
+        (unsigned long long)g_hint_bytes.load(), g_hint_us.load() / 1000.0,
+        (unsigned long long)followed, (unsigned long long)hits, followed ? (double)hits / followed : 0.0,
+        (unsigned long long)g_hint_saved_bytes.load(), g_hint_saved_us.load() / 1000.0,
+        hits ? g_hint_hit_prefill_us.load() / 1000.0 / hits : 0.0,
+        cold ? g_cold_prefill_us.load() / 1000.0 / cold : 0.0);
+    return heap_dup(buf);
+}
+
+extern "C" PR_API const char* polite_rewrite_pool_stats() {
+    return heap_dup(g_pool.StatsJson());
+}
+
+extern "C" PR_API const char* polite_rewrite_decode_stats() {
+    const uint64_t tokens = g_dec_tokens.load(), us = g_dec_us.load();
+    const uint64_t drafted = g_dec_drafted.load(), accepted = g_dec_accepted.load(), passes = g_dec_passes.load();
+    char buf[384];
+    std::snprintf(buf, sizeof(buf),
+        "{\"speculative\":%s,\"queries\":%llu,\"tokens\":%llu,\"tokens_per_s\":%.1f,"
+        "\"drafted\":%llu,\"accepted\":%llu,\"acceptance\":%.4f,\"passes\":%llu,\"tokens_per_pass\":%.3f}",
+        g_dec_speculative.load() ? "true" : "false", (unsigned long long)g_dec_queries.load(),
+        (unsigned long long)tokens, us ? tokens * 1e6 / double(us) : 0.0,
+        (unsigned long long)drafted, (unsigned long long)accepted, drafted ? double(accepted) / double(drafted) : 0.0,
+        (unsigned long long)passes, passes ? double(tokens) / double(passes) : 0.0);
+    return heap_dup(buf);
+}
+
+extern "C" PR_API const char* polite_rewrite_cascade_stats() {
+    uint64_t n[TIER_COUNT];
+    for (int i = 0; i < TIER_COUNT; ++i) n[i] = g_tiers[i].load();
+    const uint64_t model = n[TIER_VERDICT] + n[TIER_REWRITE];
+    char buf[384];
+    std::snprintf(buf, sizeof(buf),
+        "{\"escalate\":\"%s\",\"verdict_model\":%s,\"fastpath\":%llu,\"cache\":%llu,\"verdict\":%llu,"
+        "\"rewrite\":%llu,\"small_verdicts\":%llu,\"small_escalations\":%llu,\"early_exit_rate\":%.4f}",
+        kEscalateNames[g_escalate.load()], g_verdict_pool.Size() ? "true" : "false",
+        (unsigned long long)n[TIER_FASTPATH], (unsigned long long)n[TIER_CACHE],
+        (unsigned long long)n[TIER_VERDICT], (unsigned long long)n[TIER_REWRITE],
+        (unsigned long long)g_small_verdicts.load(), (unsigned long long)g_small_escalations.load(),
+        model ? double(n[TIER_VERDICT]) / double(model) : 0.0);
+    return heap_dup(buf);
+}
+
+extern "C" PR_API void polite_rewrite_set_fastpath_threshold(double threshold) {
+    g_tone.SetThreshold(threshold);
+}
+
+extern "C" PR_API const char* polite_rewrite_stage_stats() {
+    return heap_dup(g_stages.Json());
+}
+
+extern "C" PR_API const char* polite_rewrite_fastpath_stats() {
+    return heap_dup(g_tone.StatsJson());
 }
 
 extern "C" PR_API void polite_rewrite_free(const char* str) {
     if (str) std::free((void*)str);
 }
 
+// Before init: the cache opened for lookups belongs to the old paths. After: hot reload.
+static void paths_changed_locked() {
+    if (g_inited) {
+        request_reload();
+        return;
+    }
+    g_cache.Close();
+    g_cache_ready = false;
+}
+
 extern "C" PR_API int polite_rewrite_set_base_dir(const char* base_dir_utf8) {
     try {
         std::lock_guard<std::mutex> lk(g_mu);
-        if (g_inited) { genie_cleanup_locked(); }
         g_base_dir = (base_dir_utf8 ? base_dir_utf8 : "");
+        paths_changed_locked();
         return 0;
     }
     catch (...) { return -1; }
@@ -251,18 +1755,247 @@ extern "C" PR_API int polite_rewrite_set_base_dir(const char* base_dir_utf8) {
 extern "C" PR_API int polite_rewrite_set_config_path(const char* config_path_utf8) {
     try {
         std::lock_guard<std::mutex> lk(g_mu);
-        if (g_inited) { genie_cleanup_locked(); }
         g_config_path = (config_path_utf8 ? config_path_utf8 : "");
+        paths_changed_locked();
+        return 0;
+    }
+    catch (...) { return -1; }
+}
+
+// Reloads model and config from the current paths (e.g. after the files were replaced).
+// 0 = started or queued, 1 = nothing loaded yet (the next query loads them cold).
+extern "C" PR_API int polite_rewrite_reload() {
+    try {
+        std::lock_guard<std::mutex> lk(g_mu);
+        if (!g_inited) return 1;
+        request_reload();
         return 0;
     }
     catch (...) { return -1; }
 }
 
+extern "C" PR_API const char* polite_rewrite_reload_stats() {
+    try {
+        const size_t retiring = g_pool.Retiring() + g_verdict_pool.Retiring();
+        std::lock_guard<std::mutex> lk(g_reload_mu);
+        std::string j = "{\"generation\":" + std::to_string(g_generation.load()) +
+            ",\"state\":\"" + (g_reload_running ? "loading" : "idle") +
+            "\",\"reloads\":" + std::to_string(g_reloads) +
+            ",\"failures\":" + std::to_string(g_reload_failures) +
+            ",\"discarded\":" + std::to_string(g_reload_discarded) +
+            ",\"retiring\":" + std::to_string(retiring) + ",\"last\":";
+        const ReloadRecord& r = g_reload_last;
+        if (!r.generation) j += "null";
+        else {
+            j += "{\"generation\":" + std::to_string(r.generation) +
+                ",\"ok\":" + (r.ok ? "true" : "false") +
+                ",\"load_ms\":" + std::to_string(r.load_us / 1000);
+            if (r.swapped) {
+                j += ",\"from\":" + std::to_string(r.from) +
+                    ",\"swap_us\":" + std::to_string(r.swap_us) +
+                    ",\"swapped_at_ms\":" + std::to_string(r.swapped_at_ms) +
+                    ",\"in_flight\":" + std::to_string(r.in_flight) +
+                    ",\"drained_ms\":" + (r.drained_us < 0 ? std::string("null") : std::to_string(r.drained_us / 1000));
+            }
+            if (!r.error.empty()) j += ",\"error\":\"" + AppUtils::JsonEscape(r.error) + "\"";
+            j += "}";
+        }
+        return heap_dup(j + "}");
+    }
+    catch (...) { return nullptr; }
+}
+
 extern "C" PR_API const char* polite_rewrite_warmup() {
-    const char* stage = "init";
+    const char* stage = "cache";
     try {
+        // 캐시를 먼저 열어 둠: 모델 로딩 중에도 peek/캐시 조회가 g_mu를 기다리지 않음
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            ensure_cache_locked();
+        }
+        stage = "init";
         ensure_init(); // 이미 mutex로 보호 + 다중 호출 안전
-        std::string ok = "{\"ok\":true,\"stage\":\"warmup\"}";
+        const std::shared_ptr<const EngineInfo> info = engine_info(); // 리로드가 바꿔도 한 로드의 값으로 보고
+        std::string ok = "{\"ok\":true,\"stage\":\"warmup\",\"backend\":\"" + JsonEscape(info->kind) +
+            "\",\"profile\":\"" + JsonEscape(info->profile) + "\"";
+        if (!info->profile_skip.empty()) ok += ",\"profile_skipped\":\"" + JsonEscape(info->profile_skip) + "\"";
+        ok += ",\"prefix\":\"" + std::string(info->prefix_source) + "\",\"prefetched_mb\":" + std::to_string(info->prefetched >> 20);
+        ok += ",\"pool\":" + std::to_string(g_pool.Size());
+        ok += ",\"prompt_variants\":" + std::to_string(prompt_variants(g_per_language).size());
+        ok += ",\"context_bytes\":{";
+        for (const std::string& v : prompt_variants(g_per_language))
+            ok += (ok.back() == '{' ? "\"" : ",\"") + v + "\":" + std::to_string(context_budget_for(info->context_tokens, v));
+        ok += "}";
+        if (!info->context_note.empty()) ok += ",\"context_note\":\"" + JsonEscape(info->context_note) + "\"";
+        if (g_dec_speculative) ok += ",\"speculative\":true";
+        ok += ",\"cascade\":\"" + std::string(kEscalateNames[g_escalate.load()]) + "\"";
+        if (!info->verdict_kind.empty()) ok += ",\"verdict_model\":\"" + JsonEscape(info->verdict_kind) + "\"";
+        if (!info->verdict_note.empty()) ok += ",\"verdict_note\":\"" + JsonEscape(info->verdict_note) + "\"";
+        if (!info->pool_note.empty() && g_pool.Size() < info->pool_wanted) ok += ",\"pool_note\":\"" + JsonEscape(info->pool_note) + "\"";
+        ok += "}";
+        return heap_dup(ok);
+    }
+    catch (const std::exception& e) {
+        std::string j = make_error_json(stage, e.what(), g_base_dir, g_config_path);
+        return heap_dup(j);
+    }
+    catch (...) {
+        std::string j = make_error_json(stage, "unknown exception", g_base_dir, g_config_path);
+        return heap_dup(j);
+    }
+}
+
+extern "C" PR_API const char* polite_rewrite_bake_prefix() {
+    const char* stage = "init";
+    try {
+        // What the snapshot is for is read under g_mu; the lease is taken without it, so a
+        // query holding the instance is never waited on with every other caller locked out
+        fs::path dir;
+        std::string kind;
+        uint64_t identity = 0, generation = 0;
+        std::vector<std::string> variants;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            ensure_cache_locked();
+            ensure_init_locked();
+            dir = prefix_snapshot_dir(g_config_path);
+            kind = engine_info()->kind;
+            identity = g_model_identity;
+            generation = g_generation;
+            variants = prompt_variants(g_per_language);
+        }
+
+        // Always a fresh prefill: the existing snapshot may be what init just restored
+        stage = "lease";
+        AppUtils::BackendPool::Lease lease = g_pool.Acquire(std::string());
+        if (!lease) throw std::runtime_error("backend was unloaded");
+        if (lease->generation != generation) throw std::runtime_error("backend was reloaded during the bake; run it again");
+
+        stage = "bake";
+        std::error_code ec;
+        fs::remove(dir / "snapshot.json", ec); // a half-written snapshot must never match
+        fs::create_directories(dir, ec);
+        const Clock::time_point t0 = Clock::now();
+        lease->kv_session.clear();
+        lease->kv_text.clear();
+        for (const std::string& v : variants) {
+            const std::string& prefix = AppUtils::PromptHandler::SystemPrefix(v);
+            if (!lease->backend->Reset()) throw std::runtime_error(kind + " reset failed");
+            if (!lease->backend->Prefill(prefix)) throw std::runtime_error(kind + " prefix prefill failed");
+            lease->kv_text = prefix;
+            fs::create_directories(dir / v, ec);
+            if (!lease->backend->Save((dir / v).u8string())) throw std::runtime_error(kind + " state save failed");
+        }
+        const uint64_t prefill_us = AppUtils::StageStats::Us(t0, Clock::now());
+
+        const std::string meta = "{\"backend\":\"" + JsonEscape(kind) + "\",\"model\":\"" + hex64(identity) +
+            "\",\"prompt\":\"" + hex64(prefix_hash(variants)) + "\",\"prefill_ms\":" + std::to_string(prefill_us / 1000) + "}";
+        std::ofstream out(dir / "snapshot.json", std::ios::binary | std::ios::trunc);
+        out << meta;
+        if (!out) throw std::runtime_error("Cannot write: " + (dir / "snapshot.json").string());
+
+        uint64_t bytes = 0;
+        for (const auto& e : fs::recursive_directory_iterator(dir, ec))
+            if (e.is_regular_file(ec)) bytes += e.file_size(ec);
+        std::string ok = "{\"ok\":true,\"stage\":\"bake\",\"dir\":\"" + JsonEscape(dir.u8string()) +
+            "\",\"variants\":" + std::to_string(variants.size()) +
+            ",\"prefill_ms\":" + std::to_string(prefill_us / 1000) + ",\"bytes\":" + std::to_string(bytes) + "}";
+        return heap_dup(ok);
+    }
+    catch (const std::exception& e) {
+        std::string j = make_error_json(stage, e.what(), g_base_dir, g_config_path);
+        return heap_dup(j);
+    }
+    catch (...) {
+        std::string j = make_error_json(stage, "unknown exception", g_base_dir, g_config_path);
+        return heap_dup(j);
+    }
+}
+
+// Median and minimum of a run's samples in ms
+static std::string ms_summary(std::vector<uint64_t> us, const char* name) {
+    std::sort(us.begin(), us.end());
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "\"%s_ms\":%.2f,\"%s_ms_min\":%.2f", name,
+        us.empty() ? 0.0 : us[us.size() / 2] / 1000.0, name, us.empty() ? 0.0 : us.front() / 1000.0);
+    return buf;
+}
+
+extern "C" PR_API const char* polite_rewrite_prompt_bench(uint32_t runs) {
+    const char* stage = "init";
+    try {
+        std::string kind; // as for the bake: state under g_mu, the lease without it
+        bool per_language = true;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            ensure_cache_locked();
+            ensure_init_locked();
+            kind = engine_info()->kind;
+            per_language = g_per_language;
+        }
+
+        stage = "lease";
+        AppUtils::BackendPool::Lease lease = g_pool.Acquire(std::string());
+        if (!lease) throw std::runtime_error("backend was unloaded");
+        Slot& s = *lease;
+
+        stage = "bench";
+        runs = runs ? std::min<uint32_t>(runs, 50) : 5;
+        s.kv_session.clear();
+        const fs::path scratch = session_snapshot_root() / "prompt-bench";
+
+        // Every variant, whatever the config uses: the monolithic block is the baseline
+        std::string rows;
+        size_t all_bytes = 0;
+        int32_t all_tokens = -1;
+        double all_prefill = 0;
+        for (const std::string& v : AppUtils::PromptHandler::PrefixVariants()) {
+            const std::string& prefix = AppUtils::PromptHandler::SystemPrefix(v);
+            std::vector<uint64_t> prefill, restore;
+            for (uint32_t r = 0; r < runs; ++r) {
+                s.kv_text.clear();
+                if (!s.backend->Reset()) throw std::runtime_error(kind + " reset failed");
+                const Clock::time_point t0 = Clock::now();
+                if (!s.backend->Prefill(prefix)) throw std::runtime_error(kind + " prefix prefill failed");
+                prefill.push_back(AppUtils::StageStats::Us(t0, Clock::now()));
+            }
+            std::error_code ec;
+            fs::create_directories(scratch / v, ec);
+            const bool saved = s.backend->Save((scratch / v).u8string());
+            for (uint32_t r = 0; saved && r < runs; ++r) {
+                s.backend->Reset();
+                const Clock::time_point t0 = Clock::now();
+                if (!s.backend->Restore((scratch / v).u8string())) break;
+                restore.push_back(AppUtils::StageStats::Us(t0, Clock::now()));
+            }
+            s.kv_text = restore.size() == runs ? prefix : std::string();
+
+            const int32_t tokens = s.backend->CountTokens(prefix);
+            std::sort(prefill.begin(), prefill.end());
+            const double prefill_ms = prefill[prefill.size() / 2] / 1000.0;
+            if (v == "all") {
+                all_bytes = prefix.size();
+                all_tokens = tokens;
+                all_prefill = prefill_ms;
+            }
+            char ratios[160], token_ratio[16] = "null";
+            if (all_tokens > 0 && tokens >= 0) std::snprintf(token_ratio, sizeof(token_ratio), "%.3f", double(tokens) / double(all_tokens));
+            std::snprintf(ratios, sizeof(ratios), ",\"vs_all\":{\"bytes\":%.3f,\"tokens\":%s,\"prefill\":%.3f}",
+                all_bytes ? double(prefix.size()) / double(all_bytes) : 0.0, token_ratio,
+                all_prefill > 0 ? prefill_ms / all_prefill : 0.0);
+            if (!rows.empty()) rows += ",";
+            rows += "{\"variant\":\"" + v + "\",\"bytes\":" + std::to_string(prefix.size()) +
+                ",\"tokens\":" + (tokens >= 0 ? std::to_string(tokens) : std::string("null")) +
+                "," + ms_summary(prefill, "prefill");
+            if (!restore.empty()) rows += "," + ms_summary(restore, "restore");
+            rows += std::string(ratios) + "}";
+        }
+        std::error_code ec;
+        fs::remove_all(scratch, ec);
+
+        std::string ok = "{\"ok\":true,\"stage\":\"prompt_bench\",\"backend\":\"" + JsonEscape(kind) +
+            "\",\"runs\":" + std::to_string(runs) + ",\"per_language\":" + (per_language ? "true" : "false") +
+            ",\"variants\":[" + rows + "]}";
         return heap_dup(ok);
     }
     catch (const std::exception& e) {
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cctype>
 #include <string>
+#include <vector>
 
 namespace {
     inline std::string trim(std::string s) {
@@ -10,16 +11,37 @@ namespace {
         s.erase(std::find_if(s.rbegin(), s.rend(), ns).base(), s.end());
         return s;
     }
+
+    // ── 언어별 compact system 블록 ──────────────────────────────────────
+    // 규칙은 SystemPrefix()와 같고 LANGUAGE 절에서 해당 언어 한 줄만 남겼습니다.
+    // 모델이 언어를 가려낼 필요가 없으니 설명도 줄여 prefill 토큰이 절반 이하입니다.
+    std::string compact_prefix(const char* language, const char* register_rule) {
+        std::string s = "<|im_start|>system\n";
+        s += "ROLE: Email Tone Polishing Assistant. Respond in ";
+        s += language;
+        s += ".\n"
+            "TASK: Classify the tone of the \"Target\" sentence and return three polite, professional "
+            "rewrites of it that keep its meaning and intent and fit the \"Context\".\n"
+            "STYLE: ";
+        s += register_rule;
+        s += "\n"
+            "OUTPUT: exactly one JSON array of four UTF-8 strings, nothing else:\n"
+            "[\"polite\" or \"impolite\", \"alternative1\", \"alternative2\", \"alternative3\"]\n"
+            "\"impolite\" = informal speech, slang, blunt commands without courtesy, sarcasm, offensive language "
+            "or unprofessional tone; otherwise \"polite\".\n"
+            "RULES: Keep meaning, facts, numbers, entities and placeholders exactly. Never change or invent "
+            "deadlines, conditions or commitments. Do not repeat the Target. No explanations or commentary.\n"
+            "\n<|im_end|>\n";
+        return s;
+    }
 }
 
 namespace AppUtils {
 
-    // NOTE: 이 구현은 호출마다 완전한 system/user 블록을 생성합니다.
-    // (DLL 내 세션 공유 여부와 무관하게 프롬프트 일관성 보장)
-    std::string PromptHandler::MakePoliteRewritePrompt(const std::string& user_prompt_utf8) {
-        const std::string target = trim(user_prompt_utf8);
-
-        // ── System 규칙: 역할/출력 규격 고정 ───────────────────────────────
+    // ── System 규칙: 역할/출력 규격 고정 ───────────────────────────────
+    // 모든 요청이 공유하는 고정 prefix. DLL은 이 블록을 한 번만 prefill하고
+    // KV 상태를 유지한 채 Target 턴만 새로 prefill합니다.
+    const std::string& PromptHandler::SystemPrefix() {
         static const char* kSystem =
             "ROLE: Email Tone Polishing Assistant.\n"
             "\n"
@@ -60,27 +82,115 @@ namespace AppUtils {
             "- Do NOT include explanations, advice, or extra commentary.\n"
             "- Output must always contain exactly four strings.\n";
 
+        static const std::string prefix =
+            std::string("<|im_start|>system\n") + kSystem + "\n<|im_end|>\n";
+        return prefix;
+    }
+
+    const std::string& PromptHandler::SystemPrefix(const std::string& variant) {
+        static const std::string ko = compact_prefix("Korean",
+            "Formal business register with honorific endings (–습니다, –시기 바랍니다, –해 주시면 감사하겠습니다). "
+            "No informal speech or pronouns like '너/당신'.");
+        static const std::string ja = compact_prefix("Japanese",
+            "Always 丁寧語 (です/ます調); no casual forms.");
+        static const std::string en = compact_prefix("English", "Professional business tone.");
+        if (variant == "ko") return ko;
+        if (variant == "ja") return ja;
+        if (variant == "en") return en;
+        return SystemPrefix();
+    }
 
+    const std::vector<std::string>& PromptHandler::PrefixVariants() {
+        static const std::vector<std::string> variants = { "all", "en", "ja", "ko" };
+        return variants;
+    }
 
-        // ── ChatML 구성 ───────────────────────────────────────────────────
-        // <|im_start|>system ... <|im_end|>
-        // <|im_start|>user   Target: ... <|im_end|>
-        // <|im_start|>assistant
-        std::string out;
-        out.reserve(target.size() + 1024);
+    std::string PromptHandler::PrefixVariant(const std::string& user_prompt_utf8, const std::string& language) {
+        const std::string lang = language.empty() ? DetectLanguage(user_prompt_utf8) : language;
+        return lang == "ko" || lang == "ja" || lang == "en" ? lang : "all";
+    }
+
+    uint64_t PromptHandler::PromptVersion() {
+        static const uint64_t version = [] {
+            uint64_t h = 1469598103934665603ull; // FNV-1a
+            for (const std::string& v : PrefixVariants())
+                for (unsigned char c : SystemPrefix(v)) { h ^= c; h *= 1099511628211ull; }
+            return h;
+        }();
+        return version;
+    }
+
+    // 가장 많이 등장한 문자 체계로 판정 (한자만 있으면 일본어로 간주)
+    const char* PromptHandler::DetectLanguage(const std::string& utf8) {
+        size_t hangul = 0, kana = 0, han = 0, latin = 0;
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(utf8.data());
+        const unsigned char* end = p + utf8.size();
+        while (p < end) {
+            unsigned cp = *p;
+            int n = 1;
+            if (cp >= 0xF0 && p + 3 < end) { cp = ((cp & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F); n = 4; }
+            else if (cp >= 0xE0 && p + 2 < end) { cp = ((cp & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F); n = 3; }
+            else if (cp >= 0xC0 && p + 1 < end) { cp = ((cp & 0x1F) << 6) | (p[1] & 0x3F); n = 2; }
+            p += n;
+
+            if ((cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0x1100 && cp <= 0x11FF) || (cp >= 0x3130 && cp <= 0x318F)) ++hangul;
+            else if ((cp >= 0x3040 && cp <= 0x30FF) || (cp >= 0xFF66 && cp <= 0xFF9F)) ++kana;
+            else if (cp >= 0x4E00 && cp <= 0x9FFF) ++han;
+            else if ((cp >= 'A' && cp <= 'Z') || (cp >= 'a' && cp <= 'z')) ++latin;
+        }
+        if (hangul && hangul >= kana + han) return "ko";
+        if (kana || han) return "ja";
+        if (latin) return "en";
+        return "xx";
+    }
 
-        out += "<|im_start|>system\n";
-        out += kSystem;
-        out += "\n<|im_end|>\n";
+    // <|im_start|>user   Context: ... Target: ... <|im_end|>
+    // <|im_start|>assistant
+    std::string PromptHandler::MakeTargetTurn(const std::string& user_prompt_utf8,
+        const std::string& context_utf8, const std::string& language) {
+        const std::string target = trim(user_prompt_utf8);
+        const std::string context = trim(context_utf8);
+
+        std::string out;
+        out.reserve(context.size() + target.size() + 80);
 
         out += "<|im_start|>user\n";
+        if (!context.empty()) {
+            out += "Context: ";
+            out += context;
+            out += "\n";
+        }
         out += "Target: ";
         out += target.empty() ? "Hello." : target;
-        out += "\n<|im_end|>\n";
+        out += "\n";
+        if (!language.empty()) {
+            out += "Respond in: ";
+            out += language == "ko" ? "Korean" : language == "en" ? "English" : language == "ja" ? "Japanese" : language;
+            out += "\n";
+        }
+        out += "<|im_end|>\n";
 
         out += "<|im_start|>assistant\n";
 
         return out;
     }
 
+    // NOTE: 이 구현은 호출마다 완전한 system/user 블록을 생성합니다.
+    // (prefix가 이미 KV에 있으면 DLL이 REWIND 쿼리로 공통 prefix를 재사용)
+    std::string PromptHandler::MakePoliteRewritePrompt(const std::string& user_prompt_utf8,
+        const std::string& context_utf8, const std::string& language, const std::string& variant) {
+        // ── ChatML 구성 ───────────────────────────────────────────────────
+        // <|im_start|>system ... <|im_end|>
+        // <|im_start|>user   Context: ... Target: ... <|im_end|>
+        // <|im_start|>assistant
+        const std::string& prefix = SystemPrefix(variant.empty() ? PrefixVariant(user_prompt_utf8, language) : variant);
+        std::string turn = MakeTargetTurn(user_prompt_utf8, context_utf8, language);
+
+        std::string out;
+        out.reserve(prefix.size() + turn.size());
+        out += prefix;
+        out += turn;
+        return out;
+    }
+
 } // namespace AppUtils
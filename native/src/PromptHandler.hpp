@@ -1,13 +1,41 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace AppUtils {
 
 class PromptHandler {
-  bool m_is_first = true;
 public:
-  // 첫 호출에서만 system 역할 안내를 추가하고, 이후엔 user만 태그
-  std::string MakePoliteRewritePrompt(const std::string& user_prompt_utf8);
+  // 고정 system 블록(ChatML). 프로세스당 한 번만 생성되며 DLL이 KV에 상주시킵니다.
+  static const std::string& SystemPrefix();
+
+  // 변형별 system 블록: "ko"/"ja"/"en"은 그 언어 규칙만 담은 compact 블록,
+  // 그 밖("all" 등)은 세 언어 규칙을 모두 담은 SystemPrefix(). 변형마다 KV에 따로 상주합니다.
+  static const std::string& SystemPrefix(const std::string& variant);
+  static const std::vector<std::string>& PrefixVariants(); // "all" 먼저
+
+  // Target에 맞는 변형: language가 있으면 그 언어, 없으면 DetectLanguage. compact 블록이 없으면 "all"
+  static std::string PrefixVariant(const std::string& user_prompt_utf8, const std::string& language);
+
+  // Target 턴(user + assistant 헤더)만 태그. context가 있으면 Target 앞에 둡니다:
+  // 문장이 뒤에 붙어도 앞부분 토큰이 그대로라 DLL이 이전 KV를 재사용합니다.
+  // language("ko"/"en"/"ja"/...)를 주면 Target 뒤에 답 언어를 못박습니다 (빈 값 = 규칙대로 추정).
+  static std::string MakeTargetTurn(const std::string& user_prompt_utf8,
+                                    const std::string& context_utf8 = std::string(),
+                                    const std::string& language = std::string());
+
+  // 모든 변형 prefix의 해시. 프롬프트 문구가 바뀌면 결과 캐시 키도 함께 바뀝니다.
+  static uint64_t PromptVersion();
+
+  // UTF-8 문자 스캔으로 언어 추정: "ko" (Hangul) / "ja" (Kana/Kanji) / "en" (Latin) / "xx"
+  static const char* DetectLanguage(const std::string& utf8);
+
+  // SystemPrefix(variant) + MakeTargetTurn() — 항상 완전한 프롬프트 (빈 variant = PrefixVariant)
+  std::string MakePoliteRewritePrompt(const std::string& user_prompt_utf8,
+                                      const std::string& context_utf8 = std::string(),
+                                      const std::string& language = std::string(),
+                                      const std::string& variant = std::string());
 };
 
 } // namespace AppUtils
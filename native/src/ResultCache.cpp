@@ -0,0 +1,279 @@
+#include "ResultCache.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace AppUtils {
+
+    namespace {
+        constexpr char     kMagic[8] = { 'P','C','R','C','0','0','0','1' };
+        constexpr uint32_t kSlotSize = 2048;   // 4 문장 JSON 배열이 넉넉히 들어가는 크기
+        constexpr uint32_t kSlotCount = 4096;  // 8 MB 파일
+        constexpr uint32_t kProbe = 4;
+
+        struct DiskHeader {
+            char     magic[8];
+            uint32_t slots;
+            uint32_t slot_size;
+            uint8_t  reserved[48];
+        };
+        static_assert(sizeof(DiskHeader) == 64, "header layout");
+
+        inline uint64_t mix(uint64_t x) { // splitmix64 finalizer
+            x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+            x ^= x >> 27; x *= 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            return x;
+        }
+    }
+
+    // seq가 홀수면 기록 중. 다른 프로세스와 공유되므로 레이아웃 고정.
+    struct ResultCache::DiskSlot {
+        std::atomic<uint32_t> seq;
+        uint32_t len;
+        uint64_t hi, lo;
+        uint64_t check;
+        char     data[kSlotSize - 32];
+    };
+    static_assert(sizeof(std::atomic<uint32_t>) == 4, "lock-free 32-bit atomic expected");
+
+    ResultCache::ResultCache(size_t mem_capacity) : m_capacity(mem_capacity ? mem_capacity : 1) {}
+
+    ResultCache::~ResultCache() { Close(); }
+
+    uint64_t ResultCache::Hash64(const void* data, size_t n, uint64_t seed) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+        return mix(h);
+    }
+
+    // 앞뒤 공백 제거 + 연속 공백 1칸으로 (대소문자/구두점은 톤에 영향이 있어 유지)
+    std::string ResultCache::Normalize(const std::string& s) {
+        std::string out; out.reserve(s.size());
+        bool space = false;
+        for (unsigned char c : s) {
+            if (std::isspace(c)) { space = !out.empty(); continue; }
+            if (space) { out.push_back(' '); space = false; }
+            out.push_back(static_cast<char>(c));
+        }
+        return out;
+    }
+
+    CacheKey ResultCache::MakeKey(const std::string& target, const std::string& lang,
+        uint64_t prompt_version, uint64_t model_identity) {
+        std::string material = Normalize(target);
+        material.push_back('\x1f');
+        material += lang;
+        material.push_back('\x1f');
+        material.append(reinterpret_cast<const char*>(&prompt_version), sizeof(prompt_version));
+        material.append(reinterpret_cast<const char*>(&model_identity), sizeof(model_identity));
+        CacheKey k;
+        k.hi = Hash64(material.data(), material.size());
+        k.lo = Hash64(material.data(), material.size(), 0x84222325CBF29CE4ull);
+        return k;
+    }
+
+    // ─────────────────────────── disk tier ───────────────────────────
+    bool ResultCache::OpenDisk(const std::string& path_utf8) {
+        std::lock_guard<std::mutex> lk(m_mu);
+        if (m_map) return true;
+        const size_t size = sizeof(DiskHeader) + size_t(kSlotCount) * kSlotSize;
+#ifdef _WIN32
+        int wlen = MultiByteToWideChar(CP_UTF8, 0, path_utf8.c_str(), -1, nullptr, 0);
+        std::wstring wpath(wlen > 0 ? wlen - 1 : 0, L'\0');
+        if (wlen > 1) MultiByteToWideChar(CP_UTF8, 0, path_utf8.c_str(), -1, &wpath[0], wlen);
+        HANDLE f = CreateFileW(wpath.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        HANDLE m = CreateFileMappingW(f, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(uint64_t(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+        if (!m) { CloseHandle(f); return false; }
+        void* v = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!v) { CloseHandle(m); CloseHandle(f); return false; }
+        m_file = f; m_mapping = m;
+#else
+        int fd = ::open(path_utf8.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) return false;
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) { ::close(fd); return false; }
+        void* v = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (v == MAP_FAILED) { ::close(fd); return false; }
+        m_fd = fd;
+#endif
+        m_map = v;
+        m_map_size = size;
+
+        // 새 파일(또는 다른 레이아웃)이면 초기화
+        auto* hdr = static_cast<DiskHeader*>(m_map);
+        if (std::memcmp(hdr->magic, kMagic, sizeof(kMagic)) != 0 ||
+            hdr->slots != kSlotCount || hdr->slot_size != kSlotSize) {
+            std::memset(m_map, 0, m_map_size);
+            hdr->slots = kSlotCount;
+            hdr->slot_size = kSlotSize;
+            std::memcpy(hdr->magic, kMagic, sizeof(kMagic));
+        }
+        m_slots = kSlotCount;
+        return true;
+    }
+
+    void ResultCache::Close() {
+        std::lock_guard<std::mutex> lk(m_mu);
+        if (!m_map) return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_map);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file) CloseHandle(m_file);
+        m_mapping = nullptr; m_file = nullptr;
+#else
+        ::munmap(m_map, m_map_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_map = nullptr; m_map_size = 0; m_slots = 0;
+    }
+
+    bool ResultCache::DiskGet(const CacheKey& k, std::string& out) {
+        if (!m_map) return false;
+        auto* base = reinterpret_cast<DiskSlot*>(static_cast<char*>(m_map) + sizeof(DiskHeader));
+        for (uint32_t i = 0; i < kProbe; ++i) {
+            DiskSlot& s = base[(k.lo + i) % m_slots];
+            const uint32_t seq0 = s.seq.load(std::memory_order_acquire);
+            if (seq0 & 1u) continue; // being written by another process
+            if (s.hi != k.hi || s.lo != k.lo) continue;
+            const uint32_t len = s.len;
+            if (len == 0 || len > sizeof(s.data)) continue;
+            std::string v(s.data, len);
+            const uint64_t check = s.check;
+            if (s.seq.load(std::memory_order_acquire) != seq0) continue; // torn read
+            if (Hash64(v.data(), v.size()) != check) continue;
+            out.swap(v);
+            return true;
+        }
+        return false;
+    }
+
+    void ResultCache::DiskPut(const CacheKey& k, const std::string& value) {
+        if (!m_map) return;
+        auto* base = reinterpret_cast<DiskSlot*>(static_cast<char*>(m_map) + sizeof(DiskHeader));
+        if (value.size() > sizeof(base->data)) { ++m_disk_rejects; return; }
+        DiskSlot* target = &base[k.lo % m_slots]; // 빈 자리가 없으면 첫 후보를 덮어씀
+        for (uint32_t i = 0; i < kProbe; ++i) {
+            DiskSlot& s = base[(k.lo + i) % m_slots];
+            if ((s.hi == k.hi && s.lo == k.lo) || s.len == 0) { target = &s; break; }
+        }
+        uint32_t seq = target->seq.load(std::memory_order_relaxed);
+        if (seq & 1u) return; // someone else is writing this slot
+        if (!target->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acq_rel)) return;
+        target->len = 0;
+        target->hi = k.hi;
+        target->lo = k.lo;
+        std::memcpy(target->data, value.data(), value.size());
+        target->check = Hash64(value.data(), value.size());
+        target->len = static_cast<uint32_t>(value.size());
+        target->seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // ─────────────────────────── memory tier ─────────────────────────
+    void ResultCache::MemPut(const CacheKey& k, const std::string& value) {
+        auto it = m_index.find(k);
+        if (it != m_index.end()) {
+            it->second->second = value;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return;
+        }
+        m_lru.emplace_front(k, value);
+        m_index[k] = m_lru.begin();
+        while (m_lru.size() > m_capacity) {
+            m_index.erase(m_lru.back().first);
+            m_lru.pop_back();
+            ++m_evictions;
+        }
+    }
+
+    bool ResultCache::Get(const CacheKey& k, std::string& out) {
+        std::lock_guard<std::mutex> lk(m_mu);
+        auto it = m_index.find(k);
+        if (it != m_index.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            out = it->second->second;
+            ++m_mem_hits;
+            return true;
+        }
+        if (DiskGet(k, out)) {
+            MemPut(k, out); // promote
+            ++m_disk_hits;
+            return true;
+        }
+        ++m_misses;
+        return false;
+    }
+
+    void ResultCache::Put(const CacheKey& k, const std::string& value) {
+        std::lock_guard<std::mutex> lk(m_mu);
+        MemPut(k, value);
+        DiskPut(k, value);
+        ++m_stores;
+    }
+
+    // ─────────────────────────── single-flight ───────────────────────
+    bool ResultCache::BeginFlight(const CacheKey& k, std::string& out) {
+        std::unique_lock<std::mutex> lk(m_mu);
+        for (;;) {
+            auto it = m_flights.find(k);
+            if (it == m_flights.end()) {
+                m_flights.emplace(k, std::make_shared<Flight>());
+                return true; // leader
+            }
+            std::shared_ptr<Flight> f = it->second;
+            m_flight_cv.wait(lk, [&] { return f->done; });
+            if (f->ok) {
+                out = f->value;
+                ++m_joined;
+                return false;
+            }
+            // 리더가 실패/중단됨 → 다시 경쟁해서 직접 추론
+        }
+    }
+
+    void ResultCache::EndFlight(const CacheKey& k, const std::string& value, bool ok) {
+        {
+            std::lock_guard<std::mutex> lk(m_mu);
+            auto it = m_flights.find(k);
+            if (it == m_flights.end()) return;
+            it->second->done = true;
+            it->second->ok = ok;
+            if (ok) it->second->value = value;
+            m_flights.erase(it);
+        }
+        m_flight_cv.notify_all();
+    }
+
+    std::string ResultCache::StatsJson() const {
+        std::lock_guard<std::mutex> lk(m_mu);
+        const uint64_t lookups = m_mem_hits + m_disk_hits + m_misses;
+        const double hit_rate = lookups ? double(m_mem_hits + m_disk_hits) / double(lookups) : 0.0;
+        char buf[512];
+        std::snprintf(buf, sizeof(buf),
+            "{\"mem_hits\":%llu,\"disk_hits\":%llu,\"misses\":%llu,\"joined\":%llu,"
+            "\"stores\":%llu,\"evictions\":%llu,\"disk_rejects\":%llu,"
+            "\"mem_entries\":%llu,\"mem_capacity\":%llu,\"disk_slots\":%u,\"hit_rate\":%.4f}",
+            (unsigned long long)m_mem_hits, (unsigned long long)m_disk_hits,
+            (unsigned long long)m_misses, (unsigned long long)m_joined,
+            (unsigned long long)m_stores, (unsigned long long)m_evictions,
+            (unsigned long long)m_disk_rejects,
+            (unsigned long long)m_lru.size(), (unsigned long long)m_capacity,
+            m_slots, hit_rate);
+        return buf;
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,85 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace AppUtils {
+
+struct CacheKey {
+  uint64_t hi = 0, lo = 0;
+  bool operator==(const CacheKey& o) const { return hi == o.hi && lo == o.lo; }
+};
+
+struct CacheKeyHash {
+  size_t operator()(const CacheKey& k) const { return static_cast<size_t>(k.lo ^ (k.hi * 0x9E3779B97F4A7C15ull)); }
+};
+
+// 결과 캐시: 메모리 LRU → 메모리 매핑 디스크 파일(프로세스 재시작 후에도 유지).
+// 키 = 정규화된 Target + 언어 + 프롬프트 버전 + 모델/설정 식별자.
+// 같은 키의 동시 요청은 single-flight로 한 번만 추론합니다.
+class ResultCache {
+public:
+  explicit ResultCache(size_t mem_capacity = 512);
+  ~ResultCache();
+  ResultCache(const ResultCache&) = delete;
+  ResultCache& operator=(const ResultCache&) = delete;
+
+  static std::string Normalize(const std::string& target_utf8);
+  static CacheKey MakeKey(const std::string& target_utf8, const std::string& lang,
+                          uint64_t prompt_version, uint64_t model_identity);
+  static uint64_t Hash64(const void* data, size_t n, uint64_t seed = 1469598103934665603ull);
+
+  // 디스크 계층 (없어도 동작). 같은 파일을 여러 호스트 프로세스가 공유할 수 있습니다.
+  bool OpenDisk(const std::string& path_utf8);
+  void Close();
+
+  bool Get(const CacheKey& k, std::string& out);
+  void Put(const CacheKey& k, const std::string& value);
+
+  // single-flight: true면 호출자가 리더(반드시 EndFlight 호출).
+  // false면 out에 리더의 성공 결과가 채워져 있습니다.
+  bool BeginFlight(const CacheKey& k, std::string& out);
+  void EndFlight(const CacheKey& k, const std::string& value, bool ok);
+
+  std::string StatsJson() const;
+
+private:
+  struct Flight {
+    bool done = false;
+    bool ok = false;
+    std::string value;
+  };
+  struct DiskSlot;
+
+  bool DiskGet(const CacheKey& k, std::string& out);
+  void DiskPut(const CacheKey& k, const std::string& value);
+  void MemPut(const CacheKey& k, const std::string& value);
+
+  mutable std::mutex m_mu;
+  std::condition_variable m_flight_cv;
+  size_t m_capacity;
+  std::list<std::pair<CacheKey, std::string>> m_lru; // front = most recent
+  std::unordered_map<CacheKey, decltype(m_lru)::iterator, CacheKeyHash> m_index;
+  std::unordered_map<CacheKey, std::shared_ptr<Flight>, CacheKeyHash> m_flights;
+
+  // disk tier
+  void*    m_map = nullptr;
+  size_t   m_map_size = 0;
+  uint32_t m_slots = 0;
+#ifdef _WIN32
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#else
+  int m_fd = -1;
+#endif
+
+  // counters
+  uint64_t m_mem_hits = 0, m_disk_hits = 0, m_misses = 0;
+  uint64_t m_joined = 0, m_stores = 0, m_evictions = 0, m_disk_rejects = 0;
+};
+
+} // namespace AppUtils
@@ -0,0 +1,120 @@
+#include "SentenceSplitter.hpp"
+
+#include "Json.hpp"
+
+namespace AppUtils {
+
+    namespace {
+        enum PunctKind : int {
+            PUNCT_NONE = 0,
+            PUNCT_SPACED = 1, // 공백이 따라와야 끝
+            PUNCT_FULL = 2    // 붙어 있어도 끝
+        };
+
+        int PunctKindOf(uint32_t cp) {
+            switch (cp) {
+            case '.': case '!': case '?':
+            case 0x00A1: // ¡
+            case 0x061F: // ؟
+            case 0x06D4: // ۔
+                return PUNCT_SPACED;
+            case 0x2026: // …
+            case 0x3002: // 。
+            case 0xFF01: // ！
+            case 0xFF0E: // ．
+            case 0xFF1F: // ？
+            case 0xFF61: // ｡
+                return PUNCT_FULL;
+            default:
+                return PUNCT_NONE;
+            }
+        }
+
+        bool IsCloser(uint32_t cp) {
+            switch (cp) {
+            case '"': case '\'': case ')': case ']': case '}':
+            case 0x2019: case 0x201D:                 // ’ ”
+            case 0x300D: case 0x300F: case 0x3011:    // 」 』 】
+            case 0x3009: case 0x300B: case 0xFF09:    // 〉 》 ）
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool IsSpace(uint32_t cp) {
+            return cp == ' ' || cp == '\t' || cp == '\r' || cp == '\n' || cp == '\f' || cp == '\v' ||
+                cp == 0x00A0 || cp == 0x3000;
+        }
+
+        struct Cursor {
+            uint32_t byte = 0, u16 = 0;
+        };
+
+        void Step(std::string_view text, Cursor& at, uint32_t& cp) {
+            at.byte += static_cast<uint32_t>(Utf8Decode(text, at.byte, cp));
+            at.u16 += cp >= 0x10000 ? 2 : 1;
+        }
+
+        // [a, b)의 앞뒤 공백을 빼고, 부호·공백 말고 남는 게 있으면 추가
+        void Emit(std::string_view text, Cursor a, Cursor b, std::vector<SentenceSpan>& out) {
+            SentenceSpan s;
+            bool open = false, content = false;
+            Cursor at = a;
+            while (at.byte < b.byte) {
+                const Cursor before = at;
+                uint32_t cp = 0;
+                Step(text, at, cp);
+                if (IsSpace(cp)) continue;
+                if (!open) { s.begin = before.byte; s.u16_begin = before.u16; open = true; }
+                s.end = at.byte;
+                s.u16_end = at.u16;
+                if (!PunctKindOf(cp) && !IsCloser(cp)) content = true;
+            }
+            if (content) out.push_back(s);
+        }
+    } // namespace
+
+    std::vector<SentenceSpan> SplitSentences(std::string_view text) {
+        std::vector<SentenceSpan> out;
+        const uint32_t n = static_cast<uint32_t>(text.size());
+        Cursor seg, at;
+        while (at.byte < n) {
+            const Cursor before = at;
+            uint32_t cp = 0;
+            Step(text, at, cp);
+            if (cp == '\n') {
+                Emit(text, seg, before, out);
+                seg = at;
+                continue;
+            }
+            int kind = PunctKindOf(cp);
+            if (!kind) continue;
+
+            // "?!", "...", ".”" — 부호 덩어리와 닫는 따옴표/괄호까지가 이 문장
+            while (at.byte < n) {
+                Cursor next = at;
+                uint32_t c2 = 0;
+                Step(text, next, c2);
+                const int k2 = PunctKindOf(c2);
+                if (!k2 && !IsCloser(c2)) break;
+                if (k2 == PUNCT_FULL) kind = PUNCT_FULL;
+                at = next;
+            }
+            bool boundary = kind == PUNCT_FULL || at.byte >= n;
+            if (!boundary) {
+                Cursor next = at;
+                uint32_t c2 = 0;
+                Step(text, next, c2);
+                boundary = IsSpace(c2);
+            }
+            if (boundary) {
+                Emit(text, seg, at, out);
+                seg = at;
+            }
+        }
+        Emit(text, seg, at, out);
+        return out;
+    }
+
+} // namespace AppUtils
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace AppUtils {
+
+// 본문 전체를 문장으로 나눕니다 (UTF-8). contentScript.js의 PUNCT_REGEX와 같은 마침 부호
+// . ! ? ؟ ¡ ۔ 。 ？ ！ 에 ． ｡ … 를 더해 씁니다.
+// - . ! ? ¡ ؟ ۔ 는 뒤에 공백/줄끝이 와야 끝으로 봄 ("3.14", "v1.2" 보존).
+// - 전각/CJK 부호(。 ？ ！ ． ｡ …)는 공백 없이 붙어 있어도 끝.
+// - 부호가 이어지면("?!", "...") 한 덩어리, 뒤따르는 닫는 따옴표/괄호(" ' ) ” 」 』 ） 등)는 앞 문장에 붙임.
+// - 줄바꿈은 항상 경계 (인사말·서명처럼 부호 없는 줄).
+// 앞뒤 공백(U+00A0, U+3000 포함)을 뺀 구간만 돌려주며, 부호만 있는 조각은 버립니다.
+struct SentenceSpan {
+  uint32_t begin = 0, end = 0;         // 바이트 오프셋 [begin, end)
+  uint32_t u16_begin = 0, u16_end = 0; // 같은 구간의 UTF-16 오프셋 (JS 문자열 인덱스)
+};
+
+std::vector<SentenceSpan> SplitSentences(std::string_view text);
+
+} // namespace AppUtils
@@ -0,0 +1,95 @@
+#include "StageStats.hpp"
+
+#include <cstdio>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace AppUtils {
+
+    namespace {
+        int msb64(uint64_t v) { // v != 0
+#ifdef _MSC_VER
+            unsigned long i = 0;
+            _BitScanReverse64(&i, v);
+            return static_cast<int>(i);
+#else
+            return 63 - __builtin_clzll(v);
+#endif
+        }
+    }
+
+    // [0,16)은 값 그대로, 그 위는 최상위 비트 아래 4비트로 16등분
+    int LatencyHistogram::BucketOf(uint64_t v) {
+        if (v < static_cast<uint64_t>(kSub)) return static_cast<int>(v);
+        const int shift = msb64(v) - kSubBits;
+        return (shift + 1) * kSub + static_cast<int>((v >> shift) & (kSub - 1));
+    }
+
+    uint64_t LatencyHistogram::BucketMid(int index) {
+        if (index < kSub) return static_cast<uint64_t>(index);
+        const int shift = index / kSub - 1;
+        const uint64_t low = static_cast<uint64_t>(kSub + index % kSub) << shift;
+        return low + ((uint64_t(1) << shift) >> 1);
+    }
+
+    void LatencyHistogram::Record(uint64_t value) {
+        m_counts[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        m_n.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t cur = m_max.load(std::memory_order_relaxed);
+        while (value > cur && !m_max.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+    }
+
+    // 동시 Record 중에도 호출 가능 (근사치: 버킷을 훑는 동안 들어온 값은 빠질 수 있음)
+    uint64_t LatencyHistogram::Percentile(double p) const {
+        uint64_t total = 0;
+        for (const auto& c : m_counts) total += c.load(std::memory_order_relaxed);
+        if (!total) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += m_counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                const uint64_t mx = m_max.load(std::memory_order_relaxed);
+                const uint64_t mid = BucketMid(i);
+                return mid < mx ? mid : mx;
+            }
+        }
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    std::string LatencyHistogram::Json() const {
+        const uint64_t n = Count();
+        const double mean = n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+        char buf[192];
+        std::snprintf(buf, sizeof(buf),
+            "{\"n\":%llu,\"mean\":%.1f,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu}",
+            (unsigned long long)n, mean,
+            (unsigned long long)Percentile(50), (unsigned long long)Percentile(90),
+            (unsigned long long)Percentile(99), (unsigned long long)m_max.load(std::memory_order_relaxed));
+        return buf;
+    }
+
+    StageStats::StageStats(std::initializer_list<const char*> stages)
+        : m_names(stages), m_hist(new LatencyHistogram[stages.size()]) {}
+
+    std::string StageStats::Json() const {
+        std::string out = "{";
+        bool first = true;
+        for (size_t i = 0; i < m_names.size(); ++i) {
+            if (!m_hist[i].Count()) continue;
+            if (!first) out += ',';
+            first = false;
+            out += '"';
+            out += m_names[i];
+            out += "\":";
+            out += m_hist[i].Json();
+        }
+        out += "}";
+        return out;
+    }
+
+} // namespace AppUtils
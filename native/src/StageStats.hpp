@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AppUtils {
+
+// HDR 스타일 로그-선형 히스토그램: 2의 거듭제곱 구간마다 16개 하위 버킷 (상대 오차 ≤ 1/16).
+// Record는 relaxed atomic 연산뿐이라 잠금 없이 어느 스레드에서든 호출할 수 있습니다.
+class LatencyHistogram {
+public:
+  void Record(uint64_t value);
+
+  uint64_t Count() const { return m_n.load(std::memory_order_relaxed); }
+  uint64_t Percentile(double p) const;
+
+  // {"n":..,"mean":..,"p50":..,"p90":..,"p99":..,"max":..}
+  std::string Json() const;
+
+private:
+  static constexpr int kSubBits = 4;
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+  static int      BucketOf(uint64_t v);
+  static uint64_t BucketMid(int index);
+
+  std::atomic<uint64_t> m_counts[kBuckets] = {};
+  std::atomic<uint64_t> m_n{ 0 }, m_sum{ 0 }, m_max{ 0 };
+};
+
+// 이름 붙은 단계별 히스토그램 묶음. 단계 번호는 생성자에 넘긴 이름 순서.
+class StageStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  StageStats(std::initializer_list<const char*> stages);
+
+  void Record(int stage, uint64_t value) { m_hist[stage].Record(value); }
+  // t0부터 지금까지 마이크로초
+  void Since(int stage, Clock::time_point t0) { Record(stage, Us(t0, Clock::now())); }
+
+  static uint64_t Us(Clock::time_point a, Clock::time_point b) {
+    return b > a ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(b - a).count()) : 0;
+  }
+
+  // {"<stage>":{...}, ...} — 한 번도 기록되지 않은 단계는 생략
+  std::string Json() const;
+
+private:
+  std::vector<const char*>            m_names;
+  std::unique_ptr<LatencyHistogram[]> m_hist;
+};
+
+} // namespace AppUtils
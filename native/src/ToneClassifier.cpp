@@ -0,0 +1,281 @@
+#include "ToneClassifier.hpp"
+#include "PromptHandler.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace AppUtils {
+
+    namespace {
+        struct Feature {
+            const char* text;
+            double      weight;
+        };
+
+        // ── 모델 가중치 ────────────────────────────────────────────────
+        // 손으로 맞춘 값. 평서문 기본값은 임계값(0.9) 아래에 두고,
+        // 정중 어미/표현이 있어야 넘도록 했습니다. 점수만으로는 부족해서
+        // ShortCircuit은 정중 신호 kMinPolite개 이상 + 부정/재촉 신호 0개일 때만 건너뜁니다.
+        constexpr double kBias = 1.0;
+        constexpr double kDeclarative = 0.6;   // 마침표로 끝나는 평서문
+        constexpr double kShort = -1.2;        // 너무 짧으면 판단 보류
+        constexpr double kBang = -1.5;         // "!!"
+        constexpr double kQuestionRun = -1.0;  // "??"
+        constexpr double kShout = -1.2;        // 3자 이상 전부 대문자인 단어 (최대 2회)
+        constexpr int    kMinPolite = 2;       // "요"/"please" 하나로는 무례한 문장도 넘으므로
+
+        // 문장 끝 어미 n-gram (구두점 제거 후 접미사). 긴 것부터 — 첫 일치만 사용.
+        const Feature kKoEndings[] = {
+            { "\xEC\x8A\xB5\xEB\x8B\x88\xEB\x8B\xA4", 2.6 },             // 습니다
+            { "\xEC\x8A\xB5\xEB\x8B\x88\xEA\xB9\x8C", 2.4 },             // 습니까
+            { "\xEC\x8B\xAD\xEC\x8B\x9C\xEC\x98\xA4", 2.2 },             // 십시오
+            { "\xEB\x8B\x88\xEB\x8B\xA4", 2.4 },                         // 니다
+            { "\xEB\x8B\x88\xEA\xB9\x8C", 2.2 },                         // 니까
+            { "\xEC\x84\xB8\xEC\x9A\x94", 2.0 },                         // 세요
+            { "\xEC\x85\x94\xEC\x9A\x94", 2.0 },                         // 셔요
+            { "\xEC\x98\x88\xEC\x9A\x94", 1.6 },                         // 예요
+            { "\xEB\x84\xA4\xEC\x9A\x94", 1.6 },                         // 네요
+            { "\xEA\xB9\x8C\xEC\x9A\x94", 1.6 },                         // 까요
+            { "\xEC\xA3\xA0", 1.0 },                                     // 죠
+            { "\xEC\x9E\x96\xEC\x95\x84", -2.0 },                        // 잖아
+            { "\xEA\xB1\xB0\xEB\x93\xA0", -2.0 },                        // 거든
+            { "\xED\x95\xB4\xEB\x9D\xBC", -2.5 },                        // 해라
+            { "\xED\x95\x98\xEC\x85\x88", -2.5 },                        // 하셈
+            { "\xEB\x83\x90", -2.0 },                                    // 냐
+            { "\xEC\x95\xBC", -2.0 },                                    // 야
+            { "\xED\x95\xB4", -1.6 },                                    // 해
+            { "\xEB\x9D\xBC", -1.4 },                                    // 라
+            { "\xEC\xA7\x80", -1.2 },                                    // 지
+            { "\xEC\xA4\x98", -1.6 },                                    // 줘
+            { "\xEB\x8B\xA4", -0.8 },                                    // 다 (해라체 평서)
+        };
+        const Feature kJaEndings[] = {
+            { "\xE3\x81\x94\xE3\x81\x96\xE3\x81\x84\xE3\x81\xBE\xE3\x81\x99", 2.6 }, // ございます
+            { "\xE3\x81\x8F\xE3\x81\xA0\xE3\x81\x95\xE3\x81\x84", 2.2 },             // ください
+            { "\xE3\x81\xBE\xE3\x81\x97\xE3\x81\x9F", 2.2 },                         // ました
+            { "\xE3\x81\xBE\xE3\x81\x9B\xE3\x82\x93", 2.2 },                         // ません
+            { "\xE3\x81\xA7\xE3\x81\x97\xE3\x81\x9F", 2.2 },                         // でした
+            { "\xE3\x81\xBE\xE3\x81\x99", 2.4 },                                     // ます
+            { "\xE3\x81\xA7\xE3\x81\x99", 2.4 },                                     // です
+            { "\xE3\x81\xA7\xE3\x81\x99\xE3\x81\x8B", 2.2 },                         // ですか
+            { "\xE3\x81\x98\xE3\x82\x83\xE3\x81\xAD\xE3\x81\x88", -3.0 },             // じゃねえ
+            { "\xE3\x81\xA0\xE3\x82\x8D", -2.2 },                                    // だろ
+            { "\xE3\x81\x97\xE3\x82\x8D", -2.5 },                                    // しろ
+            { "\xE3\x81\x99\xE3\x82\x8B\xE3\x81\xAA", -2.5 },                         // するな
+            { "\xE3\x81\x9E", -1.5 },                                                // ぞ
+            { "\xE3\x81\x9C", -1.5 },                                                // ぜ
+            { "\xE3\x81\xA0", -1.2 },                                                // だ
+        };
+
+        // 문장 어디에 있어도 되는 표현 (영어는 소문자로 비교)
+        const Feature kKoWords[] = {
+            { "\xEA\xB0\x90\xEC\x82\xAC", 1.4 },                         // 감사
+            { "\xEB\xB6\x80\xED\x83\x81", 1.0 },                         // 부탁
+            { "\xEC\xA3\x84\xEC\x86\xA1", 0.8 },                         // 죄송
+            { "\xEC\x96\x91\xED\x95\xB4", 0.8 },                         // 양해
+            { "\xEB\x93\x9C\xEB\xA6\xBD\xEB\x8B\x88\xEB\x8B\xA4", 0.8 }, // 드립니다
+            { "\xEC\x88\x98\xEA\xB3\xA0", 0.6 },                         // 수고
+        };
+        const Feature kJaWords[] = {
+            { "\xE3\x81\x8A\xE9\xA1\x98\xE3\x81\x84", 1.2 },             // お願い
+            { "\xE3\x81\x84\xE3\x81\x9F\xE3\x81\xA0", 1.0 },             // いただ
+            { "\xE7\x94\xB3\xE3\x81\x97", 1.0 },                         // 申し
+            { "\xE6\x81\x90\xE3\x82\x8C\xE5\x85\xA5\xE3\x82\x8A", 1.2 }, // 恐れ入り
+            { "\xE3\x81\x82\xE3\x82\x8A\xE3\x81\x8C\xE3\x81\xA8\xE3\x81\x86", 1.2 }, // ありがとう
+        };
+        const Feature kEnWords[] = {
+            { "thank", 2.0 }, { "appreciate", 1.8 }, { "regards", 1.5 },
+            { "could you", 1.2 }, { "would you", 1.2 }, { "kindly", 1.0 }, { "grateful", 1.6 },
+            { "sorry", 0.8 }, { "happy to", 0.8 }, { "let me know", 0.6 }, { "i hope", 0.6 },
+            { "looking forward", 1.0 }, { "at your convenience", 1.2 }, { "when you have a moment", 1.0 },
+        };
+
+        // 재촉/짜증 신호: 정중한 어미와 같이 와도 fast path로 보내지 않음 (모든 언어)
+        const Feature kPushy[] = {
+            { "stop", -1.0 }, { "now", -0.8 }, { "still", -0.8 }, { "again", -0.8 }, { "why", -0.8 },
+            { "at least", -1.5 }, { "for nothing", -2.5 }, { "wasting", -2.0 }, { "properly", -0.8 },
+            { "\xEC\xA0\x9C\xEB\xB0\x9C", -1.0 },                         // 제발
+            { "\xEC\xA2\x80", -0.6 },                                     // 좀
+            { "\xEB\xB9\xA8\xEB\xA6\xAC", -1.0 },                         // 빨리
+            { "\xEB\x8B\xB9\xEC\x9E\xA5", -1.2 },                         // 당장
+            { "\xEC\x95\x84\xEC\xA7\x81\xEB\x8F\x84", -1.2 },             // 아직도
+            { "\xEB\x8D\x94\xEB\x8A\x94", -1.0 },                         // 더는
+            { "\xEC\x99\x9C", -0.8 },                                     // 왜
+            { "\xE4\xBD\x95\xE5\xBA\xA6\xE3\x82\x82", -1.2 },             // 何度も
+            { "\xE6\x97\xA9\xE3\x81\x8F", -1.0 },                         // 早く
+            { "\xE3\x81\xAA\xE3\x82\x93\xE3\x81\xA7", -1.0 },             // なんで
+            { "\xE3\x81\xBE\xE3\x81\xA0", -0.6 },                         // まだ
+        };
+
+        // 무례 신호: 언어와 무관하게 모두 검사
+        const Feature kRude[] = {
+            { "idiot", -4.5 }, { "stupid", -4.5 }, { "dumb", -4.0 }, { "moron", -4.5 },
+            { "shut up", -4.5 }, { "wtf", -4.0 }, { "damn", -3.0 }, { "crap", -3.5 },
+            { "useless", -3.5 }, { "ridiculous", -3.0 }, { "whatever", -2.5 }, { "sucks", -3.5 },
+            { "asap", -1.5 }, { "are you kidding", -3.5 }, { "what's wrong with you", -4.5 },
+            { "i don't care", -3.5 }, { "you never", -2.5 }, { "you always", -2.0 },
+            { "why didn't you", -2.5 }, { "hell", -2.5 },
+            { "\xEC\x94\xA8\xEB\xB0\x9C", -6.0 },                         // 씨발
+            { "\xEC\x8B\x9C\xEB\xB0\x9C", -6.0 },                         // 시발
+            { "\xE3\x85\x85\xE3\x85\x82", -5.0 },                         // ㅅㅂ
+            { "\xEB\xB3\x91\xEC\x8B\xA0", -6.0 },                         // 병신
+            { "\xEA\xBA\xBC\xEC\xA0\xB8", -5.0 },                         // 꺼져
+            { "\xEB\x8B\xA5\xEC\xB3\x90", -5.0 },                         // 닥쳐
+            { "\xEB\xAF\xB8\xEC\xB9\x9C", -4.0 },                         // 미친
+            { "\xEC\xA1\xB4\xEB\x82\x98", -4.5 },                         // 존나
+            { "\xEB\xA9\x8D\xEC\xB2\xAD", -4.0 },                         // 멍청
+            { "\xEB\xB0\x94\xEB\xB3\xB4", -3.5 },                         // 바보
+            { "\xEC\xA7\x9C\xEC\xA6\x9D", -2.5 },                         // 짜증
+            { "\xEC\x96\xB4\xEC\x9D\xB4\xEC\x97\x86", -3.0 },             // 어이없
+            { "\xE3\x85\x8B\xE3\x85\x8B", -1.5 },                         // ㅋㅋ
+            { "\xE3\x85\xA1\xE3\x85\xA1", -2.0 },                         // ㅡㅡ
+            { "\xE3\x81\xB0\xE3\x81\x8B", -4.5 },                         // ばか
+            { "\xE3\x83\x90\xE3\x82\xAB", -4.5 },                         // バカ
+            { "\xE9\xA6\xAC\xE9\xB9\xBF", -4.5 },                         // 馬鹿
+            { "\xE3\x81\x86\xE3\x82\x8B\xE3\x81\x95\xE3\x81\x84", -4.0 }, // うるさい
+            { "\xE3\x81\xB5\xE3\x81\x96\xE3\x81\x91", -4.0 },             // ふざけ
+            { "\xE6\xAD\xBB\xE3\x81\xAD", -6.0 },                         // 死ね
+            { "\xE3\x81\xA6\xE3\x82\x81", -4.0 },                         // てめ
+            { "\xE3\x81\x8A\xE5\x89\x8D", -2.5 },                         // お前
+            { "\xE3\x82\xAF\xE3\x82\xBD", -4.0 },                         // クソ
+            { "\xE9\xBB\x99\xE3\x82\x8C", -5.0 },                         // 黙れ
+        };
+
+        bool ends_with(const std::string& s, const char* suffix) {
+            const size_t n = std::strlen(suffix);
+            return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+        }
+
+        // 끝의 공백/ASCII 구두점/전각 구두점(。！？、〜…) 제거
+        std::string strip_tail(const std::string& s) {
+            size_t end = s.size();
+            for (;;) {
+                if (end && ((unsigned char)s[end - 1] <= ' ' || std::strchr(".!?~,;:)\"'", s[end - 1]))) { --end; continue; }
+                if (end >= 3 && (unsigned char)s[end - 3] == 0xE3 && (unsigned char)s[end - 2] == 0x80 &&
+                    ((unsigned char)s[end - 1] == 0x82 || (unsigned char)s[end - 1] == 0x81 || (unsigned char)s[end - 1] == 0x9C)) { end -= 3; continue; }
+                if (end >= 3 && (unsigned char)s[end - 3] == 0xEF && (unsigned char)s[end - 2] == 0xBC &&
+                    ((unsigned char)s[end - 1] == 0x81 || (unsigned char)s[end - 1] == 0x9F)) { end -= 3; continue; }
+                if (end >= 3 && (unsigned char)s[end - 3] == 0xE2 && (unsigned char)s[end - 2] == 0x80 &&
+                    (unsigned char)s[end - 1] == 0xA6) { end -= 3; continue; }
+                break;
+            }
+            return s.substr(0, end);
+        }
+
+        inline bool is_word(unsigned char c) { return c < 0x80 && (std::isalnum(c) || c == '\''); }
+
+        // 영어 표현은 단어 시작에서만 ("hell" ≠ "hello"의 앞부분이 아니도록 whole이면 끝도 확인)
+        bool contains(const std::string& text, const char* pat, bool whole) {
+            const size_t n = std::strlen(pat);
+            const bool ascii = (unsigned char)pat[0] < 0x80;
+            for (size_t pos = text.find(pat); pos != std::string::npos; pos = text.find(pat, pos + 1)) {
+                if (!ascii) return true;
+                if (pos > 0 && is_word((unsigned char)text[pos - 1])) continue;
+                if (whole && pos + n < text.size() && is_word((unsigned char)text[pos + n])) continue;
+                return true;
+            }
+            return false;
+        }
+
+        void fire(const Feature& f, ToneClassifier::Verdict& v) {
+            v.score += f.weight;
+            ++v.hits;
+            ++(f.weight > 0 ? v.polite : v.negative);
+        }
+
+        template <size_t N>
+        void add_words(const Feature (&table)[N], const std::string& text, bool whole, ToneClassifier::Verdict& v) {
+            for (const Feature& f : table) {
+                if (contains(text, f.text, whole)) fire(f, v);
+            }
+        }
+
+        template <size_t N>
+        void add_ending(const Feature (&table)[N], const std::string& core, ToneClassifier::Verdict& v) {
+            for (const Feature& f : table) {
+                if (ends_with(core, f.text)) { fire(f, v); return; }
+            }
+        }
+
+        size_t count_codepoints(const std::string& s) {
+            size_t n = 0;
+            for (unsigned char c : s) if ((c & 0xC0) != 0x80) ++n;
+            return n;
+        }
+    }
+
+    ToneClassifier::Verdict ToneClassifier::Score(const std::string& utf8) {
+        Verdict v;
+        v.lang = PromptHandler::DetectLanguage(utf8);
+
+        std::string lower = utf8;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+            [](unsigned char c) { return (c < 0x80) ? (char)std::tolower(c) : (char)c; });
+        const std::string core = strip_tail(utf8);
+
+        v.score = kBias;
+
+        add_words(kRude, lower, true, v);
+        add_words(kPushy, lower, true, v);
+        if (std::strcmp(v.lang, "ko") == 0) {
+            add_ending(kKoEndings, core, v);
+            add_words(kKoWords, utf8, false, v);
+        }
+        else if (std::strcmp(v.lang, "ja") == 0) {
+            add_ending(kJaEndings, core, v);
+            add_words(kJaWords, utf8, false, v);
+        }
+        else if (std::strcmp(v.lang, "en") == 0) {
+            add_words(kEnWords, lower, false, v);
+        }
+
+        // 문체 특징
+        if (!core.empty() && core.size() < utf8.size() && utf8.find('.', core.size()) != std::string::npos) v.score += kDeclarative;
+        if (count_codepoints(core) < 4) v.score += kShort;
+        if (utf8.find("!!") != std::string::npos) fire({ "!!", kBang }, v);
+        if (utf8.find("??") != std::string::npos) fire({ "??", kQuestionRun }, v);
+        int shouts = 0, run = 0;
+        bool lower_seen = false;
+        for (size_t i = 0; i <= utf8.size(); ++i) {
+            const unsigned char c = i < utf8.size() ? (unsigned char)utf8[i] : ' ';
+            if (std::isalpha(c) && c < 0x80) { lower_seen |= (bool)std::islower(c); ++run; continue; }
+            if (run >= 3 && !lower_seen && shouts < 2) { fire({ "SHOUT", kShout }, v); ++shouts; }
+            run = 0; lower_seen = false;
+        }
+
+        v.p_polite = 1.0 / (1.0 + std::exp(-v.score));
+        return v;
+    }
+
+    bool ToneClassifier::ShortCircuit(const std::string& utf8) {
+        const double t = m_threshold.load();
+        if (t >= 1.0) return false;
+        const auto t0 = std::chrono::steady_clock::now();
+        const Verdict v = Score(utf8);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        ++m_checked;
+        m_total_ns += static_cast<uint64_t>(ns);
+        const bool hit = v.p_polite >= t && v.polite >= kMinPolite && v.negative == 0;
+        if (hit) ++m_short;
+        return hit;
+    }
+
+    std::string ToneClassifier::StatsJson() const {
+        const uint64_t checked = m_checked.load(), shorted = m_short.load();
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+            "{\"checked\":%llu,\"short_circuited\":%llu,\"short_circuit_rate\":%.4f,"
+            "\"threshold\":%.3f,\"mean_us\":%.2f}",
+            (unsigned long long)checked, (unsigned long long)shorted,
+            checked ? double(shorted) / double(checked) : 0.0,
+            m_threshold.load(),
+            checked ? double(m_total_ns.load()) / double(checked) / 1000.0 : 0.0);
+        return buf;
+    }
+
+} // namespace AppUtils
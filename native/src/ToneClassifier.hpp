@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace AppUtils {
+
+// LLM 앞단의 경량 톤 분류기. 언어별 어휘/어미 n-gram 특징 + 선형 모델(logistic).
+// 확실히 정중한 문장만 LLM 없이 "polite"로 판정합니다: p_polite >= threshold이고
+// 정중 신호(어미/표현)가 둘 이상이며 무례·재촉 신호가 하나도 없을 때 (→ 아니면 항상 LLM).
+// bench/ToneEval이 corpus.jsonl의 라벨로 이 조건을 검사합니다.
+class ToneClassifier {
+public:
+  struct Verdict {
+    double      p_polite = 0.0;
+    double      score = 0.0;     // logit
+    const char* lang = "xx";
+    int         hits = 0;        // 발화한 특징 수
+    int         polite = 0;      // 그중 정중 신호 (가중치 > 0)
+    int         negative = 0;    // 그중 무례/재촉/문체 신호 (가중치 < 0)
+  };
+
+  static Verdict Score(const std::string& utf8);
+
+  // 0 < t < 1. 1 이상이면 fast path 비활성화.
+  void   SetThreshold(double t) { m_threshold.store(t); }
+  double Threshold() const { return m_threshold.load(); }
+
+  // 판정 + 계수. true면 LLM을 건너뛰어도 됩니다.
+  bool ShortCircuit(const std::string& utf8);
+
+  std::string StatsJson() const;
+
+private:
+  std::atomic<double>   m_threshold{ 0.90 };
+  std::atomic<uint64_t> m_checked{ 0 }, m_short{ 0 }, m_total_ns{ 0 };
+};
+
+} // namespace AppUtils
@@ -0,0 +1,542 @@
+// native/tools/PaperClipTune.cpp — hardware-aware engine tuner for the native library.
+//
+// Probes the core topology and memory, then sweeps the engine/backend performance keys
+// of the config (genie: n-threads, cpu-mask, use-mmap, mmap-budget, spill-fill-bufsize,
+// poll, spd draft-len; cpu: threads, batch, draft-max) against a fixed prompt set. Each candidate runs in a fresh
+// child process (so load time and peak working set are its own) which loads the model,
+// answers every prompt once and reports load time, prefill / first-token / total latency,
+// decode tokens/s, CPU time and peak working set.
+//
+// The search is one coordinate-descent pass from the shipped config; a value is kept when
+// it beats the best so far by 3% (or ties and saves ≥10% load time or memory) while the
+// peak working set stays under the budget. The winner is written to engine_profiles.json
+// beside the config under the current power mode; ensure_init_locked() picks it up.
+//
+//   PaperClipTune --base-dir <assets> [--config <assets>/genie_config.json]
+//                 [--prompts prompts.txt] [--out <config dir>/engine_profiles.json]
+//                 [--mode ac|dc|saver] [--budget-mb N] [--dry-run]
+//   PaperClipTune --base-dir <assets> [--config ...] --prompt-bench [--runs 5]
+//
+// --prompt-bench instead compares the system prompt variants on the config as shipped: the
+// per-language compact blocks (ko/ja/en) against the monolithic one, reporting each block's
+// bytes, tokens (cpu backend) and prefill / snapshot-restore latency, then mean end-to-end
+// latency per prompt language with "prompt": {"per-language"} off and on (one child each).
+//
+// Scores: ac = mean request latency; dc = latency + CPU ms per request; saver = latency +
+// 2×CPU ms. Modes other than the current one that have no measured profile yet get the
+// best candidate under their own score ("measured": false); re-run on battery to measure them.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "PaperClipNative.h"
+#include "EngineProfiles.hpp"
+#include "HardwareProbe.hpp"
+#include "Json.hpp"
+#include "PromptHandler.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string base_dir;
+        std::string config;              // default: <base_dir>/genie_config.json
+        std::string prompts;             // one sentence per line; default: built-in set
+        std::string out;                 // default: <config dir>/engine_profiles.json
+        std::string mode;                // default: AppUtils::PowerMode()
+        long long   budget_mb = 0;       // 0 = 60% of physical memory
+        bool        dry_run = false;
+        bool        prompt_bench = false;
+        uint32_t    runs = 5;            // --prompt-bench repetitions per variant
+        // child mode
+        std::string trial;               // candidate config to measure
+        std::string result;              // where the child writes its metrics
+        std::string tag;                 // per-run suffix that keeps prompts out of the result cache
+    };
+
+    struct Metrics {
+        bool        ok = false;
+        std::string error;
+        double      load_ms = 0, prefill_ms = 0, first_token_ms = 0, total_ms = 0;
+        double      decode_tps = 0, cpu_ms = 0, peak_ws_mb = 0;
+    };
+
+    // 정중하지 않은 문장만 (fast path 없이도 모델까지 가야 하는 입력) — ko / en / ja
+    const char* const kPrompts[] = {
+        "이거 내일까지 다시 해와요. 이번엔 제대로 좀 하고.",
+        "회의 자료 왜 아직도 안 보냈어요? 몇 번을 말해야 돼요?",
+        "그 건은 제가 알 바 아니니까 알아서 처리하세요.",
+        "Send me the numbers now, I've been waiting all morning.",
+        "This report is useless. Redo it before you go home.",
+        "Stop cc'ing me on this thread, it has nothing to do with me.",
+        "資料がまだ届いていません。早く送ってください。",
+        "この件はそちらのミスなので、すぐ直してください。",
+    };
+
+    std::string slurp(const fs::path& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    bool spit(const fs::path& p, const std::string& s) {
+        std::ofstream out(p, std::ios::binary | std::ios::trunc);
+        out.write(s.data(), static_cast<std::streamsize>(s.size()));
+        return static_cast<bool>(out);
+    }
+
+    std::vector<std::string> load_prompts(const std::string& path) {
+        std::vector<std::string> out;
+        if (path.empty()) {
+            for (const char* p : kPrompts) out.emplace_back(p);
+            return out;
+        }
+        std::ifstream in(fs::u8path(path), std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) out.push_back(line);
+        }
+        return out;
+    }
+
+    double ms_between(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+
+    // 프로세스 CPU 시간 (user + kernel, ms)
+    double process_cpu_ms() {
+#ifdef _WIN32
+        FILETIME c, e, k, u;
+        if (!GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u)) return 0;
+        const auto ticks = [](const FILETIME& f) {
+            return static_cast<double>((static_cast<unsigned long long>(f.dwHighDateTime) << 32) | f.dwLowDateTime);
+        };
+        return (ticks(k) + ticks(u)) / 10000.0;
+#else
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0 +
+               (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+#endif
+    }
+
+    // mmap된 모델 파일 페이지까지 포함한 최대 working set / RSS (MB)
+    double peak_working_set_mb() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc{};
+        if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+        return static_cast<double>(pmc.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        return static_cast<double>(ru.ru_maxrss) / 1024.0;
+#endif
+    }
+
+    fs::path self_path(const char* argv0) {
+#ifdef _WIN32
+        wchar_t buf[MAX_PATH];
+        const DWORD n = GetModuleFileNameW(nullptr, buf, MAX_PATH);
+        if (n > 0 && n < MAX_PATH) return fs::path(buf);
+#else
+        std::error_code ec;
+        const fs::path p = fs::read_symlink("/proc/self/exe", ec);
+        if (!ec) return p;
+#endif
+        return fs::absolute(argv0);
+    }
+
+    std::string metrics_json(const Metrics& m) {
+        if (!m.ok) return "{\"ok\":false,\"error\":\"" + AppUtils::JsonEscape(m.error) + "\"}";
+        char buf[320];
+        std::snprintf(buf, sizeof(buf),
+            "{\"ok\":true,\"load_ms\":%.1f,\"prefill_ms\":%.1f,\"first_token_ms\":%.1f,\"total_ms\":%.1f,"
+            "\"decode_tps\":%.1f,\"cpu_ms\":%.1f,\"peak_ws_mb\":%.1f}",
+            m.load_ms, m.prefill_ms, m.first_token_ms, m.total_ms, m.decode_tps, m.cpu_ms, m.peak_ws_mb);
+        return buf;
+    }
+
+    Metrics parse_metrics(std::string_view json) {
+        Metrics m;
+        AppUtils::JsonReader j;
+        if (!j.Parse(json)) { m.error = "no trial result"; return m; }
+        m.ok = j.Bool("ok");
+        m.error = std::string(j.String("error"));
+        m.load_ms = j.Double("load_ms", 0);
+        m.prefill_ms = j.Double("prefill_ms", 0);
+        m.first_token_ms = j.Double("first_token_ms", 0);
+        m.total_ms = j.Double("total_ms", 0);
+        m.decode_tps = j.Double("decode_tps", 0);
+        m.cpu_ms = j.Double("cpu_ms", 0);
+        m.peak_ws_mb = j.Double("peak_ws_mb", 0);
+        return m;
+    }
+
+    // polite_rewrite_stage_stats()의 한 단계 평균 (µs, decode_tps는 토큰/초)
+    double stage_mean(const AppUtils::JsonReader& stats, const char* stage) {
+        AppUtils::JsonReader h;
+        return h.Parse(stats.Raw(stage)) ? h.Double("mean", 0) : 0;
+    }
+
+    // ───────────────────────── child: one candidate ─────────────────────────
+    int run_trial(const Options& opt) {
+        Metrics m;
+        polite_rewrite_set_base_dir(opt.base_dir.c_str());
+        polite_rewrite_set_config_path(opt.trial.c_str());
+        polite_rewrite_set_fastpath_threshold(1.0); // 모든 문장이 모델을 거치도록
+
+        const auto t0 = Clock::now();
+        const char* w = polite_rewrite_warmup();
+        m.load_ms = ms_between(t0, Clock::now());
+        AppUtils::JsonReader j;
+        const bool loaded = w && j.Parse(w) && j.Bool("ok");
+        if (!loaded) m.error = w && j.Parse(w) ? std::string(j.String("error", "warmup failed")) : "warmup failed";
+        polite_rewrite_free(w);
+
+        if (loaded) {
+            const double cpu0 = process_cpu_ms();
+            size_t answered = 0;
+            const std::vector<std::string> prompts = load_prompts(opt.prompts);
+            for (const std::string& p : prompts) {
+                const std::string input = opt.tag.empty() ? p : p + " " + opt.tag;
+                const char* r = generate_polite_rewrite(input.c_str());
+                if (r && *r == '[') ++answered;
+                else if (r && m.error.empty()) m.error = r;
+                polite_rewrite_free(r);
+            }
+            m.cpu_ms = prompts.empty() ? 0 : (process_cpu_ms() - cpu0) / static_cast<double>(prompts.size());
+
+            const char* s = polite_rewrite_stage_stats();
+            AppUtils::JsonReader stats;
+            if (s && stats.Parse(s)) {
+                m.prefill_ms = stage_mean(stats, "prefill") / 1000.0;
+                m.first_token_ms = stage_mean(stats, "first_token") / 1000.0;
+                m.total_ms = stage_mean(stats, "total") / 1000.0;
+                m.decode_tps = stage_mean(stats, "decode_tps");
+            }
+            polite_rewrite_free(s);
+            m.ok = answered > 0 && answered == prompts.size();
+            if (!m.ok && m.error.empty()) m.error = "no answer";
+        }
+        m.peak_ws_mb = peak_working_set_mb();
+        return spit(fs::u8path(opt.result), metrics_json(m)) ? 0 : 1;
+    }
+
+    // ───────────────────────────── parent: search ─────────────────────────────
+    class Tuner {
+    public:
+        Tuner(const Options& opt, const fs::path& self, const AppUtils::HardwareInfo& hw)
+            : m_opt(opt), m_self(self), m_hw(hw), m_scratch(fs::temp_directory_path() / "paperclip_tune") {
+            std::error_code ec;
+            fs::create_directories(m_scratch, ec);
+            m_tag = "#" + std::to_string(static_cast<long long>(std::time(nullptr)) % 100000);
+        }
+
+        ~Tuner() {
+            std::error_code ec;
+            fs::remove_all(m_scratch, ec);
+        }
+
+        // 같은 설정 텍스트는 한 번만 측정 (결과 캐시 때문에 같은 프롬프트를 두 번 돌리지 않음)
+        const Metrics& Evaluate(const std::string& cfg) {
+            auto it = m_memo.find(cfg);
+            if (it != m_memo.end()) return it->second;
+            const Metrics m = Run(cfg, "cand_" + std::to_string(m_memo.size()));
+            std::fprintf(stderr, "[tune] %s\n", metrics_json(m).c_str());
+            return m_memo.emplace(cfg, m).first->second;
+        }
+
+        // 자식 프로세스 하나로 cfg를 측정
+        Metrics Run(const std::string& cfg, const std::string& name) {
+            const fs::path cand = m_scratch / (name + ".json");
+            const fs::path result = m_scratch / (name + ".result.json");
+            std::error_code ec;
+            fs::remove(result, ec);
+            Metrics m;
+            if (!spit(cand, cfg)) {
+                m.error = "cannot write " + cand.u8string();
+                return m;
+            }
+            std::string cmd = "\"" + m_self.u8string() + "\" --trial \"" + cand.u8string() +
+                "\" --result \"" + result.u8string() + "\" --base-dir \"" + m_opt.base_dir +
+                "\" --tag \"" + m_tag + "-" + name + "\"";
+            if (!m_opt.prompts.empty()) cmd += " --prompts \"" + m_opt.prompts + "\"";
+#ifdef _WIN32
+            cmd = "\"" + cmd + "\""; // cmd /c strips the outer pair
+#endif
+            const int rc = std::system(cmd.c_str());
+            m = parse_metrics(slurp(result));
+            if (!m.ok && m.error == "no trial result") m.error = "trial exited with " + std::to_string(rc);
+            return m;
+        }
+
+        double Score(const Metrics& m, const std::string& mode) const {
+            const double cpu_weight = mode == "saver" ? 2.0 : mode == "dc" ? 1.0 : 0.0;
+            return m.total_ms + cpu_weight * m.cpu_ms;
+        }
+
+        bool Feasible(const Metrics& m) const {
+            return m.ok && (m_budget_mb <= 0 || m.peak_ws_mb <= static_cast<double>(m_budget_mb));
+        }
+
+        // a가 b보다 나은가: 점수 3% 이상 개선, 또는 점수는 비슷하고 로딩/메모리 10% 이상 절약
+        bool Better(const Metrics& a, const Metrics& b, const std::string& mode) const {
+            if (!Feasible(a)) return false;
+            if (!Feasible(b)) return true;
+            const double sa = Score(a, mode), sb = Score(b, mode);
+            if (sa < sb * 0.97) return true;
+            return sa <= sb * 1.03 && (a.peak_ws_mb < b.peak_ws_mb * 0.9 || a.load_ms < b.load_ms * 0.9);
+        }
+
+        // 설정에 있는 튜닝 키마다 후보 값 (JSON 원문)
+        std::vector<std::string> Candidates(const AppUtils::EngineTunable& t, const std::string& cfg) const {
+            const std::string cur(AppUtils::JsonFindMember(cfg, t.key));
+            std::vector<std::string> v;
+            const std::string key = t.key;
+            if (t.kind == 'b') v = { "false", "true" };
+            else if (key == "cpu-mask") {
+                v = { "\"" + AppUtils::HexMask(m_hw.perf_mask) + "\"", "\"" + AppUtils::HexMask(m_hw.all_mask) + "\"" };
+            }
+            else if (key == "n-threads" || key == "threads") {
+                for (unsigned n : { m_hw.perf_cores / 2, m_hw.perf_cores, m_hw.cores, m_hw.logical }) {
+                    if (n >= 1 && n <= m_hw.logical) v.push_back(std::to_string(n));
+                }
+            }
+            else if (key == "mmap-budget") {
+                if (AppUtils::JsonFindMember(cfg, "use-mmap") != "true") return {}; // mmap을 안 쓰면 의미 없음
+                v = { "0", "256", "1024" };
+            }
+            else if (key == "spill-fill-bufsize") v = { "0", "320000000" };
+            else if (key == "batch") v = { "128", "256", "512" };
+            else if (key == "draft-len" || key == "draft-max") v = { "2", "4", "6", "8" }; // 수락률이 낮으면 짧을수록 이득
+            v.erase(std::remove(v.begin(), v.end(), cur), v.end());
+            std::sort(v.begin(), v.end());
+            v.erase(std::unique(v.begin(), v.end()), v.end());
+            return v;
+        }
+
+        std::string Search(const std::string& base_cfg, const std::string& mode) {
+            m_budget_mb = m_opt.budget_mb > 0 ? m_opt.budget_mb : static_cast<long long>(m_hw.total_mb * 6 / 10);
+            std::string best = base_cfg;
+            if (m_opt.dry_run) {
+                for (const AppUtils::EngineTunable& t : AppUtils::EngineTunables()) {
+                    if (AppUtils::JsonFindMember(best, t.key).empty()) continue;
+                    for (const std::string& value : Candidates(t, best)) std::printf("%s = %s\n", t.key, value.c_str());
+                }
+                return best;
+            }
+
+            // 버리는 한 번: 모델 파일을 페이지 캐시에 올려 첫 후보만 콜드 로딩으로 불리해지지 않게
+            Run(base_cfg, "warm");
+            const Metrics* best_m = &Evaluate(best);
+            m_baseline = *best_m;
+            for (const AppUtils::EngineTunable& t : AppUtils::EngineTunables()) {
+                if (AppUtils::JsonFindMember(best, t.key).empty()) continue;
+                for (const std::string& value : Candidates(t, best)) {
+                    std::string cand = best;
+                    AppUtils::JsonSetMember(cand, t.key, value);
+                    const Metrics& m = Evaluate(cand);
+                    if (Better(m, *best_m, mode)) { best = cand; best_m = &m; }
+                }
+            }
+            return best;
+        }
+
+        // 이미 측정한 후보 중 mode 점수로 가장 좋은 설정
+        const std::string* BestFor(const std::string& mode) const {
+            const std::string* best = nullptr;
+            const Metrics* best_m = nullptr;
+            for (const auto& kv : m_memo) {
+                if (!Feasible(kv.second)) continue;
+                if (!best_m || Score(kv.second, mode) < Score(*best_m, mode)) { best = &kv.first; best_m = &kv.second; }
+            }
+            return best;
+        }
+
+        const Metrics& MetricsOf(const std::string& cfg) { return Evaluate(cfg); }
+        const Metrics& Baseline() const { return m_baseline; }
+        size_t Trials() const { return m_memo.size(); }
+        long long BudgetMb() const { return m_budget_mb; }
+
+    private:
+        const Options&                 m_opt;
+        fs::path                       m_self;
+        AppUtils::HardwareInfo         m_hw;
+        fs::path                       m_scratch;
+        std::string                    m_tag;
+        long long                      m_budget_mb = 0;
+        std::map<std::string, Metrics> m_memo;    // config text → metrics
+        Metrics                        m_baseline;
+    };
+
+    // 설정에서 튜닝 키 값만 뽑아 프로파일 객체로
+    std::string profile_json(const std::string& cfg, const Metrics& m, bool measured) {
+        std::string out = "{";
+        for (const AppUtils::EngineTunable& t : AppUtils::EngineTunables()) {
+            const std::string_view v = AppUtils::JsonFindMember(cfg, t.key);
+            if (v.empty()) continue;
+            out += "\"";
+            out += t.key;
+            out += "\":";
+            out += v;
+            out += ",";
+        }
+        out += "\"measured\":";
+        out += measured ? "true" : "false";
+        out += ",\"metrics\":" + metrics_json(m) + "}";
+        return out;
+    }
+
+    // ─────────────────── --prompt-bench: system prompt variants ───────────────────
+    // "prompt": {"per-language": on} on top of cfg (added when the config has no such key)
+    std::string with_per_language(std::string cfg, bool on) {
+        const char* v = on ? "true" : "false";
+        if (AppUtils::JsonSetMember(cfg, "per-language", v)) return cfg;
+        const size_t brace = cfg.find('{');
+        if (brace != std::string::npos) cfg.insert(brace + 1, std::string("\"prompt\":{\"per-language\":") + v + "},");
+        return cfg;
+    }
+
+    int run_prompt_bench(const Options& opt, const std::string& base_cfg, const fs::path& self,
+        const AppUtils::HardwareInfo& hw) {
+        // 프롬프트 언어별로 나눠 한 언어씩 자식 프로세스에서 (단일 블록 / 언어별 블록)
+        std::map<std::string, std::vector<std::string>> by_lang;
+        for (const std::string& p : load_prompts(opt.prompts)) by_lang[AppUtils::PromptHandler::DetectLanguage(p)].push_back(p);
+        const fs::path dir = fs::temp_directory_path() / "paperclip_prompt_bench";
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+
+        std::string e2e;
+        bool warmed = false;
+        for (const auto& lang : by_lang) {
+            std::string lines;
+            for (const std::string& p : lang.second) lines += p + "\n";
+            Options sub = opt;
+            sub.prompts = (dir / (lang.first + ".txt")).u8string();
+            if (!spit(fs::u8path(sub.prompts), lines)) { std::fprintf(stderr, "cannot write %s\n", sub.prompts.c_str()); return 1; }
+            Tuner tuner(sub, self, hw);
+            if (!warmed) { tuner.Run(base_cfg, "warm"); warmed = true; } // 모델 파일을 페이지 캐시에
+            const Metrics single = tuner.Run(with_per_language(base_cfg, false), "single_" + lang.first);
+            const Metrics compact = tuner.Run(with_per_language(base_cfg, true), "compact_" + lang.first);
+            std::fprintf(stderr, "[bench] %s single %s\n", lang.first.c_str(), metrics_json(single).c_str());
+            std::fprintf(stderr, "[bench] %s per-language %s\n", lang.first.c_str(), metrics_json(compact).c_str());
+            if (!e2e.empty()) e2e += ",";
+            e2e += "\"" + lang.first + "\":{\"prompts\":" + std::to_string(lang.second.size()) +
+                ",\"single\":" + metrics_json(single) + ",\"per_language\":" + metrics_json(compact) + "}";
+        }
+        fs::remove_all(dir, ec);
+
+        // 변형별 prefill / 복원은 이 프로세스에서 (자식들이 끝난 뒤라 모델은 한 벌만)
+        polite_rewrite_set_base_dir(opt.base_dir.c_str());
+        polite_rewrite_set_config_path(opt.config.c_str());
+        const char* b = polite_rewrite_prompt_bench(opt.runs);
+        const std::string variants = b ? b : "";
+        polite_rewrite_free(b);
+        AppUtils::JsonReader j;
+        if (!j.Parse(variants) || !j.Bool("ok")) {
+            std::fprintf(stderr, "[bench] %s\n", variants.c_str());
+            return 1;
+        }
+        std::printf("{\"prefix\":%s,\"end_to_end\":{%s}}\n", variants.c_str(), e2e.c_str());
+        return 0;
+    }
+
+    bool parse_args(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string a = argv[i];
+            auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+            if (a == "--base-dir") o.base_dir = next();
+            else if (a == "--config") o.config = next();
+            else if (a == "--prompts") o.prompts = next();
+            else if (a == "--out") o.out = next();
+            else if (a == "--mode") o.mode = next();
+            else if (a == "--budget-mb") o.budget_mb = std::atoll(next());
+            else if (a == "--dry-run") o.dry_run = true;
+            else if (a == "--prompt-bench") o.prompt_bench = true;
+            else if (a == "--runs") o.runs = static_cast<uint32_t>(std::max(1, std::atoi(next())));
+            else if (a == "--trial") o.trial = next();
+            else if (a == "--result") o.result = next();
+            else if (a == "--tag") o.tag = next();
+            else { std::fprintf(stderr, "unknown option: %s\n", a.c_str()); return false; }
+        }
+        if (o.base_dir.empty()) { std::fprintf(stderr, "--base-dir is required\n"); return false; }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 2;
+    if (!opt.trial.empty()) return run_trial(opt);
+
+    if (opt.config.empty()) opt.config = (fs::u8path(opt.base_dir) / "genie_config.json").u8string();
+    if (opt.out.empty()) opt.out = (fs::u8path(opt.config).parent_path() / "engine_profiles.json").u8string();
+    if (opt.mode.empty()) opt.mode = AppUtils::PowerMode();
+
+    const std::string base_cfg = slurp(fs::u8path(opt.config));
+    if (base_cfg.empty()) { std::fprintf(stderr, "cannot read config: %s\n", opt.config.c_str()); return 2; }
+
+    const AppUtils::HardwareInfo hw = AppUtils::HardwareInfo::Probe();
+    if (opt.prompt_bench) return run_prompt_bench(opt, base_cfg, self_path(argv[0]), hw);
+    std::fprintf(stderr, "[tune] hardware %s\n", hw.Json().c_str());
+
+    Tuner tuner(opt, self_path(argv[0]), hw);
+    const std::string best = tuner.Search(base_cfg, opt.mode);
+    if (opt.dry_run) return 0;
+
+    const Metrics& best_m = tuner.MetricsOf(best);
+    if (!tuner.Feasible(best_m)) {
+        std::fprintf(stderr, "[tune] no candidate loaded within %lld MB: %s\n", tuner.BudgetMb(), best_m.error.c_str());
+        return 1;
+    }
+
+    // 다른 전원 모드: 이 기계에서 측정한 프로파일이 이미 있으면 유지, 없으면 이번 후보 중에서 고름
+    std::map<std::string, std::string> profiles;
+    profiles[opt.mode] = profile_json(best, best_m, true);
+    AppUtils::JsonReader old_doc, old_machine, old_profiles, entry;
+    const std::string old = slurp(fs::u8path(opt.out));
+    const bool same_machine = old_doc.Parse(old) && old_machine.Parse(old_doc.Raw("machine")) &&
+        hw.SameMachine(static_cast<unsigned>(old_machine.Number("logical", 0)),
+                       static_cast<uint64_t>(old_machine.Number("total_mb", 0)));
+    const bool have_old = same_machine && old_profiles.Parse(old_doc.Raw("profiles"));
+    for (const char* mode : { "ac", "dc", "saver" }) {
+        if (mode == opt.mode) continue;
+        if (have_old && entry.Parse(old_profiles.Raw(mode)) && entry.Bool("measured")) {
+            profiles[mode] = std::string(old_profiles.Raw(mode));
+            continue;
+        }
+        if (const std::string* cfg = tuner.BestFor(mode)) profiles[mode] = profile_json(*cfg, tuner.MetricsOf(*cfg), false);
+    }
+
+    std::string doc = "{\n  \"version\": 1,\n  \"machine\": " + hw.Json() + ",\n  \"profiles\": {";
+    bool first = true;
+    for (const auto& kv : profiles) {
+        doc += first ? "\n" : ",\n";
+        first = false;
+        doc += "    \"" + kv.first + "\": " + kv.second;
+    }
+    doc += "\n  }\n}\n";
+    if (!spit(fs::u8path(opt.out), doc)) { std::fprintf(stderr, "cannot write %s\n", opt.out.c_str()); return 1; }
+
+    std::printf("{\"mode\":\"%s\",\"trials\":%zu,\"budget_mb\":%lld,\"baseline\":%s,\"best\":%s,\"out\":\"%s\"}\n",
+        opt.mode.c_str(), tuner.Trials(), tuner.BudgetMb(), metrics_json(tuner.Baseline()).c_str(),
+        profiles[opt.mode].c_str(), AppUtils::JsonEscape(opt.out).c_str());
+    return 0;
+}
@@ -40,6 +40,16 @@ try {
     Write-InstallLog "Set env: PC_MODEL_BASE_DIR=$install" "OK"
     Write-InstallLog "Set env: PC_CONFIG_PATH=$cfgDst"     "OK"
 
+    # 시스템 프롬프트까지 prefill한 상태를 미리 저장 → 호스트 재시작 후 첫 제안이 prefill을 건너뜀 (실패해도 설치는 계속)
+    $env:PC_MODEL_BASE_DIR = $install
+    $env:PC_CONFIG_PATH    = $cfgDst
+    $bake = & $exeDst --bake-prefix
+    if ($LASTEXITCODE -eq 0) {
+        Write-InstallLog "Prefix snapshot: $bake" "OK"
+    } else {
+        Write-InstallLog "Prefix snapshot skipped: $bake" "WARN"
+    }
+
     Write-InstallLog "install_host completed." "OK"
 }
 catch {